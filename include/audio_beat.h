@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// Audio-only tempo and beat tracker (party mode, audio task).
+//
+// Runs on the onset engine's per-hop flux (onset_flux.h, one value per
+// ONSET_HOP samples = 187.5 Hz at 48 kHz), so it adds no FFT of its own:
+//   envelope   x = log(1 + max(0, flux - mean over ~0.1 s) / mean over ~4 s),
+//              [1 2 1]/4 smoothed so a one-hop onset spans neighbouring lags
+//   tempo      leaky autocorrelation of x (time constant ~4 s), updated per
+//              hop for lags covering the BPM range below and their multiples up
+//              to x4; every ~170 ms a harmonic comb  sum_m acf[m*l] / m,
+//              weighted by a log-Gaussian prior around 120 BPM, picks the
+//              period (parabolic refinement; a different period must win
+//              ~1 s in a row before it replaces the current one)
+//   phase      beats are scheduled one period apart; at every half beat a
+//              4-beat comb over the envelope finds where the previous beat
+//              really was and pulls the schedule toward it, with a continuity
+//              penalty against off-beat flips
+//   confidence EMA over beats of sqrt(tempo strength * phase clarity):
+//              strength = autocorrelation coefficient at the period (~0 for
+//              noise), clarity = (peak - mean) / peak of the phase comb
+//
+// First tempo after ~6 s of audio. Events are emitted whatever the
+// confidence; gating is the caller's policy.
+// Cost per hop: ~500 multiply-adds (lags 70..565 at 187.5 Hz) plus ~600 once
+// per half beat, i.e. a few percent of one onset FFT hop. Static state ~7 KB.
+
+static constexpr float ABEAT_BPM_MIN   = 80.0f;
+static constexpr float ABEAT_BPM_MAX   = 160.0f;
+static constexpr float ABEAT_BPM_PRIOR = 120.0f;
+
+enum AudioBeatKind : uint8_t { ABEAT_NONE = 0, ABEAT_BEAT, ABEAT_HALF };
+
+struct AudioBeatEvent {
+  AudioBeatKind kind;
+  float lateHops;        // event time lies this many hops (0..1) before the current hop
+  float bpm;             // current tempo estimate
+  float conf;            // 0..1
+};
+
+void abeat_init(float hopRate);   // envelope rate in Hz (sampleRate / ONSET_HOP); also resets
+void abeat_reset();
+
+// One envelope sample (total flux of a hop). Returns true and fills *ev when a
+// beat or half beat falls in this hop.
+bool abeat_push(float flux, AudioBeatEvent* ev);
+
+float abeat_bpm();
+float abeat_confidence();
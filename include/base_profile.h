@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include "filter_bank.h"   // BAND_COUNT
+
+// Baseline profile slots (party mode, see BASELINE PROFILES in mode_party.cpp).
+//
+// One slot per key (BPM band, level band): the learned baselines and, once a
+// break has been measured under that key, the break floor as ratios to them.
+// The struct is the NVS blob layout; bump BASE_PROFILE_VERSION with it.
+
+struct BaseProfile {
+  uint8_t  used;
+  uint8_t  bpmBand;
+  int8_t   levelBand;
+  uint8_t  hasBreak;
+  uint32_t seq;                               // save order: lowest is evicted first
+  float    rms, tr, kVar, kMean;
+  float    bandE[BAND_COUNT], bandV[BAND_COUNT];
+  float    bfRms, bfTr, bfKVar;               // break floor / baseline
+};
+
+// Slot for a key: the one holding it, else an empty one, else the oldest.
+int8_t baseProfileSlot(const BaseProfile* slots, uint8_t n, uint8_t bpmBand, int8_t levelBand);
+
+// Write `now` (its key, baselines and, if now.hasBreak, break floor) into p
+// when p is new to the key or a value moved by more than `delta` (relative).
+// A slot taking a different key drops the old key's break floor. The write
+// takes ++*seq. Returns true when p changed.
+bool baseProfileStore(BaseProfile& p, const BaseProfile& now, float delta, uint32_t* seq);
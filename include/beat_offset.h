@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+// Audio-to-MIDI-clock offset estimator (party mode, loop core).
+//
+// Cross-correlates kick onsets from the I2S stream (LOW band flux per onset
+// hop, stamped in audio time) with MIDI beat timestamps:
+//   per beat   every hop within +-BEAT_OFFSET_WIN_US of the beat adds its flux
+//              at offset (hop - beat), spread over a triangular kernel one
+//              hop wide, into a 2 ms bin histogram
+//   per bar    (BEAT_OFFSET_BEATS beats) the histogram peak, parabolically
+//              refined, is one estimate if it stands BEAT_OFFSET_MIN_PROM
+//              times above the histogram mean and off the window edges
+//   report     mean and standard deviation of the last BEAT_OFFSET_BARS
+//              accepted bar estimates
+// A beat is correlated when the next one arrives, so its whole window has
+// been captured whatever the audio latency (window < one beat at 160 BPM).
+// Offset > 0: the audible kick arrives after the MIDI beat.
+
+static constexpr uint16_t BEAT_OFFSET_HOPS     = 256;      // onset ring, ~1.4 s at 187.5 Hz
+static constexpr int32_t  BEAT_OFFSET_WIN_US   = 100000;   // +- search window around a beat
+static constexpr int32_t  BEAT_OFFSET_BIN_US   = 2000;
+static constexpr uint8_t  BEAT_OFFSET_BINS     = 2 * (BEAT_OFFSET_WIN_US / BEAT_OFFSET_BIN_US) + 1;
+static constexpr uint8_t  BEAT_OFFSET_BEATS    = 4;        // beats per estimate (one bar)
+static constexpr uint8_t  BEAT_OFFSET_BARS     = 16;       // N: estimates kept
+static constexpr float    BEAT_OFFSET_MIN_PROM = 2.0f;     // histogram peak / mean
+
+class BeatOffsetEstimator {
+ public:
+  // hopUs: onset hop duration (kernel width)
+  explicit BeatOffsetEstimator(uint32_t hopUs) : kernelBins((int8_t)((hopUs + BEAT_OFFSET_BIN_US - 1) / BEAT_OFFSET_BIN_US)) {}
+
+  void reset();                         // everything, including the estimates
+  void resync();                        // forget the previous beat and the partial bar
+
+  // Kick onset strength of one hop centred at audio time tUs (micros()).
+  void addOnset(uint32_t tUs, float strength);
+
+  // MIDI beat at tUs. Correlates the previous beat; returns true when that
+  // closed a bar (accepted or not, see lastBarAccepted()).
+  bool onBeat(uint32_t tUs);
+
+  uint8_t  bars() const { return fill; }                 // accepted estimates held
+  int32_t  offsetUs() const;                              // mean of the held estimates
+  uint32_t stdUs() const;
+  bool     lastBarAccepted() const { return lastOk; }
+  int32_t  lastBarUs() const { return lastEst; }
+  float    lastProminence() const { return lastProm; }
+  uint32_t rejectedBars() const { return rejected; }
+
+ private:
+  void closeBar();
+
+  int8_t   kernelBins;
+  uint32_t hopT[BEAT_OFFSET_HOPS] = {};
+  float    hopF[BEAT_OFFSET_HOPS] = {};
+  uint16_t hopPos = 0, hopFill = 0;
+
+  float    hist[BEAT_OFFSET_BINS] = {};
+  uint8_t  beatsInBar = 0;
+  bool     havePrev = false;
+  uint32_t prevBeatUs = 0;
+
+  int32_t  est[BEAT_OFFSET_BARS] = {};
+  uint8_t  idx = 0, fill = 0;
+  bool     lastOk = false;
+  int32_t  lastEst = 0;
+  float    lastProm = 0.0f;
+  uint32_t rejected = 0;
+};
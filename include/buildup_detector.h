@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+// Buildup / riser detector (party mode, loop core, BREAK_CONFIRMED only).
+//
+// Monitor windows are averaged into one point per beat of three log power levels:
+//   tr     transient energy (snare rolls, risers, white-noise sweeps)
+//   hats   hats-band energy
+//   tilt   hats / body energy (a high-pass or low-pass filter opening up)
+// Over the last BUILDUP_BEATS points each level gets a least-squares slope
+// (dB per bar) and fit R^2. A level is rising when its slope reaches its
+// BUILDUP_*_DB_BAR and R^2 >= BUILDUP_MIN_R2 (a monotone climb, not a few loud
+// beats); score = max over levels of R^2 * slope / threshold. The detector is
+// armed after BUILDUP_CONFIRM_BEATS beats in a row with score >= 1 and
+// disarms as soon as the score falls below BUILDUP_DISARM_SCORE.
+// A beat without windows (paused) leaves the history and verdict as they were.
+// Cost per beat: one pass over 16 points x 3 levels. Arm latency on synthetic
+// window traces: test/test_buildup_detector.
+
+static constexpr uint8_t BUILDUP_BEATS         = 16;    // fit span (4 bars)
+static constexpr uint8_t BUILDUP_MIN_BEATS     = 8;     // no verdict before two bars
+static constexpr float   BUILDUP_TR_DB_BAR     = 1.0f;
+static constexpr float   BUILDUP_HATS_DB_BAR   = 1.5f;
+static constexpr float   BUILDUP_TILT_DB_BAR   = 1.0f;
+static constexpr float   BUILDUP_MIN_R2        = 0.5f;
+static constexpr uint8_t BUILDUP_CONFIRM_BEATS = 4;
+static constexpr float   BUILDUP_DISARM_SCORE  = 0.6f;
+
+enum BuildupLevel : uint8_t { BUILDUP_TR = 0, BUILDUP_HATS, BUILDUP_TILT, BUILDUP_LEVELS };
+
+class BuildupDetector {
+ public:
+  void reset();
+
+  // One monitor window (linear energies, as from the accumulators)
+  void addWindow(float tr, float hatsE, float bodyE);
+
+  // Beat boundary: closes the beat's point and re-evaluates. Returns true
+  // when the armed state changed.
+  bool onBeat();
+
+  bool    armed() const { return isArmed; }
+  float   score() const { return lastScore; }
+  uint8_t beats() const { return fill; }
+  float   slopeDbPerBar(BuildupLevel l) const { return slope[l]; }
+  float   fitR2(BuildupLevel l) const { return r2[l]; }
+
+ private:
+  float    winSum[BUILDUP_LEVELS] = {};
+  uint16_t winN = 0;
+
+  float    pts[BUILDUP_LEVELS][BUILDUP_BEATS] = {};
+  uint8_t  pos = 0, fill = 0;
+
+  float    slope[BUILDUP_LEVELS] = {};
+  float    r2[BUILDUP_LEVELS] = {};
+  float    lastScore = 0.0f;
+  uint8_t  streak = 0;
+  bool     isArmed = false;
+};
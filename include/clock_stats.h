@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// MIDI clock tick-interval statistics (party mode and diagnostic phase C+D).
+//
+// Fed with the arrival time of every 0xF8. Per interval dt:
+//   reference  ref = EMA of accepted intervals (gain 1/32), seeded by the
+//              median of the first CLOCK_STATS_SEED intervals (held back
+//              and then counted against it), so one late first tick does
+//              not set it
+//   jitter     |dt - ref|, binned into a fixed log histogram
+//   drop       dt > 1.5 * ref: counted, missed ticks estimated, and the
+//              interval kept out of jitter / reference / min / max
+//   re-seed    CLOCK_STATS_RESEED_DROPS drops in a row mean the clock slowed
+//              past 1.5x (the EMA only follows within that): ref becomes
+//              their median and they are counted as intervals instead
+// add() is O(1) integer work plus one float EMA step (a median of at most
+// five values when seeding); formatting happens only in summary() /
+// histogram(), outside the beat path.
+//
+// Histogram bins (microseconds): 0..7 exact, then 4 bins per octave
+// (lo = (4 + m) << (e - 2) for octave e), last bin open-ended at ~1.8 s.
+// Quantiles report the upper edge of their bin (<= 25% above the true value).
+//
+// Text goes to a caller buffer.
+
+static constexpr uint8_t  CLOCK_STATS_BINS      = 80;
+static constexpr float    CLOCK_STATS_DROP_FRAC = 1.5f;
+static constexpr uint8_t  CLOCK_STATS_SEED      = 5;
+static constexpr uint8_t  CLOCK_STATS_RESEED_DROPS = 4;
+
+class ClockStats {
+ public:
+  void reset();
+  void add(uint32_t tickUs);
+
+  uint32_t intervals() const { return n; }
+  uint32_t drops() const { return dropCount; }
+  uint32_t missedTicks() const { return missed; }
+  uint32_t reseeds() const { return reseedCount; }
+  float    referenceUs() const { return ref; }      // 0 until seeded
+  float    meanIntervalUs() const { return (n > 0) ? (float)((double)sumDt / (double)n) : 0.0f; }
+  uint32_t jitterQuantileUs(float q) const;     // q in [0, 1]
+
+  // One line each, no trailing newline. Return snprintf's length.
+  int summary(char* buf, size_t len) const;     // counts, bpm, interval span, jitter p50/p99/max, re-seeds
+  int histogram(char* buf, size_t len) const;   // non-empty bins as lo_us:count
+
+ private:
+  bool     havePrev = false;
+  uint32_t prevUs = 0;
+  float    ref = 0.0f;
+  uint32_t n = 0;
+  uint64_t sumDt = 0;
+  uint32_t minDt = 0, maxDt = 0;
+  uint32_t maxJit = 0;
+  uint32_t dropCount = 0, missed = 0;
+  uint32_t reseedCount = 0;
+  uint32_t hist[CLOCK_STATS_BINS] = {};
+  // Seed intervals (ref == 0), else the current run of drops
+  uint32_t held[CLOCK_STATS_SEED] = {};
+  uint8_t  heldN = 0;
+
+  void accept(uint32_t dt);
+  void reseedFromHeld();
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320), bitwise: for the small
+// records kept in RTC memory and NVS, where a table would cost more than it
+// saves. crc32_ieee("123456789", 9) == 0xCBF43926.
+static inline uint32_t crc32_ieee(const void* data, size_t n) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint32_t c = 0xFFFFFFFFu;
+  while (n--) {
+    c ^= *p++;
+    for (uint8_t k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+  }
+  return ~c;
+}
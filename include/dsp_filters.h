@@ -0,0 +1,221 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// Filter / rate-conversion kernels shared by the audio analysis paths
+// (party mode, diagnostic mode, party POC).
+//
+// Every coefficient is designed at compile time from a cutoff in Hz and the
+// sample rate the kernel runs at: the kernels are templates on <FS, FC_HZ>,
+// so a 44.1 / 48 / 96 kHz converter needs no retuning and no runtime trig.
+
+// ---- Shared analysis cutoffs ----
+static constexpr uint32_t DSP_KICK_ENV_HZ = 77;   // kick envelope one-pole (|x| low-pass)
+static constexpr uint32_t DSP_TR_HP_HZ    = 38;   // transient high-pass (removes DC / sub)
+
+// ---- Compile-time design math ----
+// Double precision, single-return recursion (C++11 constexpr); only ever
+// evaluated by the compiler.
+static constexpr double DSP_PI = 3.14159265358979323846;
+
+static constexpr double dsp_sq(double v) { return v * v; }
+static constexpr double dsp_expSeries(double x, double term, int n) {
+  return (n > 24) ? 0.0 : term + dsp_expSeries(x, term * x / (double)(n + 1), n + 1);
+}
+// exp(x) = exp(x/2)^2 until |x| <= 0.5, then Taylor
+static constexpr double dsp_exp(double x) {
+  return (x > 0.5 || x < -0.5) ? dsp_sq(dsp_exp(x * 0.5)) : dsp_expSeries(x, 1.0, 0);
+}
+static constexpr double dsp_sinSeries(double x2, double term, int n) {
+  return (n > 14) ? 0.0 : term + dsp_sinSeries(x2, -term * x2 / (double)((2 * n + 2) * (2 * n + 3)), n + 1);
+}
+// Valid for |x| <= pi (all design angles are 0 .. pi)
+static constexpr double dsp_sin(double x) { return dsp_sinSeries(x * x, x, 0); }
+static constexpr double dsp_cos(double x) { return dsp_sin(DSP_PI * 0.5 - x); }
+
+// One-pole low-pass  y += a * (x - y),      a = 1 - exp(-2*pi*fc/fs)
+static constexpr float dsp_onePoleLpAlpha(double fcHz, double fsHz) {
+  return (float)(1.0 - dsp_exp(-2.0 * DSP_PI * fcHz / fsHz));
+}
+// One-pole high-pass y = c * (y + x - x[-1]), c = exp(-2*pi*fc/fs)
+static constexpr float dsp_onePoleHpCoeff(double fcHz, double fsHz) {
+  return (float)dsp_exp(-2.0 * DSP_PI * fcHz / fsHz);
+}
+
+// ---- One-pole kernels ----
+template <uint32_t FS, uint32_t FC_HZ>
+struct OnePoleLP {
+  static_assert(FC_HZ > 0 && 2 * FC_HZ < FS, "cutoff must be between 0 and fs/2");
+  static constexpr float ALPHA = dsp_onePoleLpAlpha(FC_HZ, FS);
+
+  float y = 0.0f;
+  void reset() { y = 0.0f; }
+  inline float process(float x) { y += ALPHA * (x - y); return y; }
+};
+template <uint32_t FS, uint32_t FC_HZ> constexpr float OnePoleLP<FS, FC_HZ>::ALPHA;
+
+template <uint32_t FS, uint32_t FC_HZ>
+struct OnePoleHP {
+  static_assert(FC_HZ > 0 && 2 * FC_HZ < FS, "cutoff must be between 0 and fs/2");
+  static constexpr float COEFF = dsp_onePoleHpCoeff(FC_HZ, FS);
+
+  float y = 0.0f, xPrev = 0.0f;
+  void reset() { y = 0.0f; xPrev = 0.0f; }
+  inline float process(float x) { y = COEFF * (y + x - xPrev); xPrev = x; return y; }
+};
+template <uint32_t FS, uint32_t FC_HZ> constexpr float OnePoleHP<FS, FC_HZ>::COEFF;
+
+// ---- Envelope decimator ----
+// Third-order CIC (sinc^3) decimator by D in Hogenauer form: three integrators
+// at the input rate, three combs at the output rate. This is the polyphase FIR
+// with 3 taps per phase and a quadratic B-spline prototype; its zeros sit on
+// every alias centre k*fs/D, which is exactly where content folds onto the
+// 0..120 Hz kick band. Rejection at fs/D +/- 120 Hz (fs = 48 kHz):
+//   D = 8  : -72 dB      D = 12 : -61 dB
+// Per input sample: three uint32 adds. Integrators wrap modulo 2^32, which is
+// exact for CIC as long as input bits + 3*log2(D) <= 32.
+//
+// Input : non-negative magnitude in Q21 (|xQ24| >> 3)
+// Output: float, unity DC gain
+template <uint8_t D>
+struct CicDecimator3 {
+  static_assert(D >= 2 && D <= 12, "Q21 input + 3*log2(D) bit growth must fit in 32 bits");
+
+  uint32_t i1 = 0, i2 = 0, i3 = 0;
+  uint32_t c1 = 0, c2 = 0, c3 = 0;
+  uint8_t  phase = 0;
+
+  void reset() { i1 = i2 = i3 = 0; c1 = c2 = c3 = 0; phase = 0; }
+
+  // Push one input; returns true and writes *out on every D-th sample.
+  inline bool push(uint32_t inQ21, float* out) {
+    uint32_t o3;
+    if (!step(inQ21, &o3)) return false;
+    *out = (float)o3 * (1.0f / ((float)D * (float)D * (float)D * 2097152.0f));  // / (D^3 * 2^21)
+    return true;
+  }
+
+  // Signed input in Q20 (one bit given up for the sign, same 32-bit budget).
+  // Two's-complement wrap-around keeps the CIC exact; the comb output is
+  // read back as int32.
+  inline bool pushSigned(int32_t inQ20, float* out) {
+    uint32_t o3;
+    if (!step((uint32_t)inQ20, &o3)) return false;
+    *out = (float)(int32_t)o3 * (1.0f / ((float)D * (float)D * (float)D * 1048576.0f));  // / (D^3 * 2^20)
+    return true;
+  }
+
+ private:
+  inline bool step(uint32_t in, uint32_t* o3) {
+    i1 += in; i2 += i1; i3 += i2;
+    if (++phase < D) return false;
+    phase = 0;
+    const uint32_t o1 = i3 - c1; c1 = i3;
+    const uint32_t o2 = o1 - c2; c2 = o1;
+    *o3 = o2 - c3; c3 = o2;
+    return true;
+  }
+};
+
+// ---- Biquad sections (Direct Form II transposed) ----
+// DF2T needs two state words per section and one multiply per coefficient;
+// it is the form with the best float behaviour for low-cutoff sections.
+struct BiquadCoeffs { float b0, b1, b2, a1, a2; };   // a0 normalised to 1
+
+static constexpr double DSP_Q_BUTTERWORTH = 0.70710678118654752;
+
+// RBJ cookbook 2nd-order low-/high-pass, cs = cos(w), al = sin(w) / 2Q
+static constexpr BiquadCoeffs dsp_biquadLpFrom(double cs, double al) {
+  return { (float)((1.0 - cs) * 0.5 / (1.0 + al)), (float)((1.0 - cs) / (1.0 + al)),
+           (float)((1.0 - cs) * 0.5 / (1.0 + al)),
+           (float)(-2.0 * cs / (1.0 + al)), (float)((1.0 - al) / (1.0 + al)) };
+}
+static constexpr BiquadCoeffs dsp_biquadHpFrom(double cs, double al) {
+  return { (float)((1.0 + cs) * 0.5 / (1.0 + al)), (float)(-(1.0 + cs) / (1.0 + al)),
+           (float)((1.0 + cs) * 0.5 / (1.0 + al)),
+           (float)(-2.0 * cs / (1.0 + al)), (float)((1.0 - al) / (1.0 + al)) };
+}
+static constexpr BiquadCoeffs dsp_biquadLowpass(double fcHz, double fsHz, double q) {
+  return dsp_biquadLpFrom(dsp_cos(2.0 * DSP_PI * fcHz / fsHz), dsp_sin(2.0 * DSP_PI * fcHz / fsHz) / (2.0 * q));
+}
+static constexpr BiquadCoeffs dsp_biquadHighpass(double fcHz, double fsHz, double q) {
+  return dsp_biquadHpFrom(dsp_cos(2.0 * DSP_PI * fcHz / fsHz), dsp_sin(2.0 * DSP_PI * fcHz / fsHz) / (2.0 * q));
+}
+
+template <typename T> struct BiquadDF2T;
+
+// Float section: samples in [-1, 1].
+template <> struct BiquadDF2T<float> {
+  float b0 = 0, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+  float s1 = 0, s2 = 0;
+
+  void set(const BiquadCoeffs& c) { b0 = c.b0; b1 = c.b1; b2 = c.b2; a1 = c.a1; a2 = c.a2; }
+  void reset() { s1 = s2 = 0.0f; }
+
+  inline float process(float x) {
+    const float y = b0 * x + s1;
+    s1 = b1 * x - a1 * y + s2;
+    s2 = b2 * x - a2 * y;
+    return y;
+  }
+};
+
+// Fixed-point section: Q24 samples, Q28 coefficients (|c| < 8), Q52 int64
+// state. Products stay below 2^55, so the state never saturates.
+template <> struct BiquadDF2T<int32_t> {
+  int32_t b0 = 0, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+  int64_t s1 = 0, s2 = 0;
+
+  static int32_t toQ28(float c) { return (int32_t)lrintf(c * 268435456.0f); }
+  void set(const BiquadCoeffs& c) {
+    b0 = toQ28(c.b0); b1 = toQ28(c.b1); b2 = toQ28(c.b2); a1 = toQ28(c.a1); a2 = toQ28(c.a2);
+  }
+  void reset() { s1 = s2 = 0; }
+
+  inline int32_t process(int32_t xQ24) {
+    const int32_t y = (int32_t)(((int64_t)b0 * xQ24 + s1 + (1LL << 27)) >> 28);
+    s1 = (int64_t)b1 * xQ24 - (int64_t)a1 * y + s2;
+    s2 = (int64_t)b2 * xQ24 - (int64_t)a2 * y;
+    return y;
+  }
+};
+
+// ---- Biquad kernels (T = float or int32_t Q24) ----
+// Butterworth high-pass at FC_HZ.
+template <typename T, uint32_t FS, uint32_t FC_HZ>
+struct BiquadHighpass {
+  static_assert(FC_HZ > 0 && 2 * FC_HZ < FS, "cutoff must be between 0 and fs/2");
+  BiquadDF2T<T> s;
+  BiquadHighpass() {
+    constexpr BiquadCoeffs c = dsp_biquadHighpass(FC_HZ, FS, DSP_Q_BUTTERWORTH);
+    s.set(c);
+  }
+  void reset() { s.reset(); }
+  inline T process(T x) { return s.process(x); }
+};
+
+// Band-pass as a cascade of a high-pass (low edge) and a low-pass (high edge)
+// Butterworth section: 12 dB/oct on each side.
+template <typename T, uint32_t FS, uint32_t LO_HZ, uint32_t HI_HZ>
+struct BiquadBandpass {
+  static_assert(LO_HZ > 0 && LO_HZ < HI_HZ && 2 * HI_HZ < FS, "band edges must satisfy 0 < lo < hi < fs/2");
+  BiquadDF2T<T> hp, lp;
+  BiquadBandpass() {
+    constexpr BiquadCoeffs ch = dsp_biquadHighpass(LO_HZ, FS, DSP_Q_BUTTERWORTH);
+    constexpr BiquadCoeffs cl = dsp_biquadLowpass(HI_HZ, FS, DSP_Q_BUTTERWORTH);
+    hp.set(ch);
+    lp.set(cl);
+  }
+  void reset() { hp.reset(); lp.reset(); }
+  inline T process(T x) { return lp.process(hp.process(x)); }
+};
+
+// Sample-domain conversions for code templated on float / int32_t (Q24)
+template <typename T> static inline T dsp_sampleFromFloat(float x);
+template <> inline float   dsp_sampleFromFloat<float>(float x)   { return x; }
+template <> inline int32_t dsp_sampleFromFloat<int32_t>(float x) { return (int32_t)(x * 16777216.0f); }
+template <typename T> static inline T dsp_sampleFromQ24(int32_t q);
+template <> inline float   dsp_sampleFromQ24<float>(int32_t q)   { return (float)q * (1.0f / 16777216.0f); }
+template <> inline int32_t dsp_sampleFromQ24<int32_t>(int32_t q) { return q; }
+static inline float dsp_sampleToFloat(float x)   { return x; }
+static inline float dsp_sampleToFloat(int32_t x) { return (float)x * (1.0f / 16777216.0f); }
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "dsp_filters.h"
+#include "feature_acc.h"
+
+// Kick / body / hats filter bank (party mode, audio task).
+//
+// Each band is a DF2T biquad cascade. Kick and body only carry < 400 Hz, so
+// they run on a signed CIC at FS / DECIM (4 kHz at 48 kHz, like the kick
+// envelope); only the hats section runs at full rate and is averaged over
+// the same tick. Per band and tick: power y² and a one-pole envelope of |y|,
+// summed by BandAcc into energy and envelope variance.
+// Cost per input sample: one hats section; per tick: two two-section
+// cascades and three envelope updates (test/test_bench_filter_bank).
+//
+// T = float, or int32_t for the Q24 / Q28 integer sections. The integer
+// path is not float-free: the coefficients are designed in double at
+// compile time and converted to Q28 with lrintf when the bank is built, the
+// CIC output enters the kick / body sections through a float, and the band
+// outputs, envelopes and hats sums are float.
+
+static constexpr uint32_t BAND_KICK_LO_HZ = 40;
+static constexpr uint32_t BAND_KICK_HI_HZ = 120;
+static constexpr uint32_t BAND_BODY_LO_HZ = 150;
+static constexpr uint32_t BAND_BODY_HI_HZ = 400;
+static constexpr uint32_t BAND_HATS_HZ    = 6000;
+
+enum BandId : uint8_t { BAND_KICK = 0, BAND_BODY, BAND_HATS, BAND_COUNT };
+
+// Filter-bank levels (segment / window / bar), merged like FeatureAcc
+struct BankAcc {
+  BandAcc band[BAND_COUNT];
+  void reset() { for (uint8_t b = 0; b < BAND_COUNT; b++) band[b].reset(); }
+  void merge(const BankAcc& o) { for (uint8_t b = 0; b < BAND_COUNT; b++) band[b].merge(o.band[b]); }
+  void mergeSince(const BankAcc& src, BankAcc& mark) {
+    for (uint8_t b = 0; b < BAND_COUNT; b++) band[b].mergeSince(src.band[b], mark.band[b]);
+  }
+};
+
+template <typename T, uint32_t FS, uint8_t DECIM>
+class FilterBank {
+ public:
+  static constexpr uint32_t TICK_RATE = FS / DECIM;
+
+  void reset() {
+    decim.reset();
+    kick.reset();
+    body.reset();
+    hats.reset();
+    for (uint8_t b = 0; b < BAND_COUNT; b++) env[b].reset();
+    hatsAbsSum = hatsPowSum = 0.0f;
+  }
+
+  // One full-rate sample in; kick / body advance once per DECIM samples,
+  // hats accumulate |y| and y² until that same tick.
+  inline void push(int32_t xQ24, BankAcc& acc) {
+    const float h = dsp_sampleToFloat(hats.process(dsp_sampleFromQ24<T>(xQ24)));
+    hatsAbsSum += fabsf(h);
+    hatsPowSum += h * h;
+
+    float xd;
+    if (!decim.pushSigned(xQ24 >> 4, &xd)) return;
+
+    const T in = dsp_sampleFromFloat<T>(xd);
+    const float k = dsp_sampleToFloat(kick.process(in));
+    const float d = dsp_sampleToFloat(body.process(in));
+    update(acc.band[BAND_KICK], BAND_KICK, fabsf(k), k * k);
+    update(acc.band[BAND_BODY], BAND_BODY, fabsf(d), d * d);
+    update(acc.band[BAND_HATS], BAND_HATS, hatsAbsSum * (1.0f / DECIM), hatsPowSum * (1.0f / DECIM));
+    hatsAbsSum = hatsPowSum = 0.0f;
+  }
+
+ private:
+  inline void update(BandAcc& a, uint8_t b, float absY, float pow) {
+    a.add(fa_toQ28(pow), fa_toQ28(env[b].process(absY)));
+  }
+
+  CicDecimator3<DECIM> decim;                                       // signed: kick / body input
+  BiquadBandpass<T, TICK_RATE, BAND_KICK_LO_HZ, BAND_KICK_HI_HZ> kick;
+  BiquadBandpass<T, TICK_RATE, BAND_BODY_LO_HZ, BAND_BODY_HI_HZ> body;
+  BiquadHighpass<T, FS, BAND_HATS_HZ> hats;
+  OnePoleLP<TICK_RATE, DSP_KICK_ENV_HZ> env[BAND_COUNT];
+  float hatsAbsSum = 0.0f, hatsPowSum = 0.0f;                       // full-rate sums over one tick
+};
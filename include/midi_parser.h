@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+
+// MIDI 1.0 byte-stream parser.
+//
+// One byte in, at most one complete message out. Handles:
+//   - real-time bytes (0xF8..0xFF) anywhere, including inside other messages
+//     and SysEx, without disturbing them
+//   - running status for channel messages (cleared by system common / SysEx)
+//   - SysEx (0xF0 .. 0xF7) skipped; any non-real-time status byte also ends it
+//   - system common: MTC quarter frame, Song Position Pointer, Song Select,
+//     Tune Request
+//   - stray data bytes with no status are dropped
+
+enum MidiMsgType : uint8_t {
+  MIDI_MSG_NONE = 0,     // byte consumed, no complete message yet
+  MIDI_MSG_CLOCK,        // 0xF8
+  MIDI_MSG_START,        // 0xFA
+  MIDI_MSG_CONTINUE,     // 0xFB
+  MIDI_MSG_STOP,         // 0xFC
+  MIDI_MSG_SPP,          // 0xF2, spp = 16th notes since song start
+  MIDI_MSG_CHANNEL,      // 0x80..0xEF (status, d1, d2)
+  MIDI_MSG_SYSTEM        // other complete system common / real-time message
+};
+
+struct MidiMsg {
+  MidiMsgType type;
+  uint8_t  status;
+  uint8_t  d1, d2;
+  uint16_t spp;          // MIDI_MSG_SPP only (0..16383)
+};
+
+class MidiParser {
+ public:
+  MidiMsgType push(uint8_t b, MidiMsg* out);
+  void reset() { running = 0; need = 0; got = 0; inSysex = false; }
+
+  uint32_t sysexSkipped() const { return sysexCount; }
+  uint32_t strayData() const { return strayCount; }
+
+ private:
+  uint8_t  running = 0;      // current status (running status for channel msgs)
+  uint8_t  need = 0;         // data bytes the current status takes
+  uint8_t  got = 0;
+  uint8_t  data[2] = {0, 0};
+  bool     inSysex = false;
+  uint32_t sysexCount = 0;
+  uint32_t strayCount = 0;
+};
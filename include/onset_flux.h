@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+
+// Spectral-flux onset engine (party mode, audio task).
+//
+// 512-point real FFT on a Hann window, hop 256 samples (= one I2S DMA
+// descriptor, 5.3 ms at 48 kHz). The real transform is a 256-point complex
+// radix-4 DIF FFT on even/odd-packed samples plus the usual split step.
+// Twiddles come from a quarter-wave sine table in flash; the sample ring,
+// FFT workspace and previous magnitudes are statically allocated (~4 KB).
+//
+// Per hop and band: half-wave-rectified flux  sum_k max(0, |X_t[k]| - |X_t-1[k]|),
+// magnitudes normalised so a full-scale sine reads 1.0.
+//
+// Cost per hop: 4 x 64 radix-4 butterflies + 256 split steps + 257 sqrtf,
+// about 16k flops. Per 75 ms window against the window budget of 240 MHz *
+// 75 ms = 18M cycles: on the host in test/test_bench_onset, on the device
+// with DEBUG_AUDIO_CYCLES (mode_party.cpp).
+
+static constexpr uint16_t ONSET_FFT_N = 512;
+static constexpr uint16_t ONSET_HOP   = 256;
+
+enum OnsetBand : uint8_t { ONSET_LOW = 0, ONSET_MID, ONSET_HIGH, ONSET_BANDS };
+
+// Band edges: LOW 40..250 Hz (kick), MID 250 Hz..2 kHz (snare / body),
+// HIGH 2 kHz..fs/2 (hats). DC bin is never used.
+static constexpr float ONSET_LOW_LO_HZ = 40.0f;
+static constexpr float ONSET_LOW_HI_HZ = 250.0f;
+static constexpr float ONSET_MID_HI_HZ = 2000.0f;
+
+// Flux gathered over a span of hops (segment / window level)
+struct OnsetAcc {
+  uint32_t frames = 0;
+  float sumFlux[ONSET_BANDS] = {};
+  float peak = 0.0f;          // largest single-hop total flux
+
+  void reset() { frames = 0; for (uint8_t b = 0; b < ONSET_BANDS; b++) sumFlux[b] = 0.0f; peak = 0.0f; }
+  void add(const float flux[ONSET_BANDS]) {
+    float t = 0.0f;
+    for (uint8_t b = 0; b < ONSET_BANDS; b++) { sumFlux[b] += flux[b]; t += flux[b]; }
+    if (t > peak) peak = t;
+    frames++;
+  }
+  void merge(const OnsetAcc& o) {
+    frames += o.frames;
+    for (uint8_t b = 0; b < ONSET_BANDS; b++) sumFlux[b] += o.sumFlux[b];
+    if (o.peak > peak) peak = o.peak;
+  }
+  // Mean flux per hop: one band, or all bands (onset strength)
+  float band(uint8_t b) const { return (frames > 0) ? sumFlux[b] / (float)frames : 0.0f; }
+  float strength() const {
+    float t = 0.0f;
+    for (uint8_t b = 0; b < ONSET_BANDS; b++) t += sumFlux[b];
+    return (frames > 0) ? t / (float)frames : 0.0f;
+  }
+};
+
+void onset_init(uint32_t sampleRate);   // band bin edges; also resets
+void onset_reset();                      // clear sample ring and previous spectrum
+
+// Push one mono sample. Every ONSET_HOP samples (once the window is full) runs
+// the FFT, writes this hop's per-band flux and returns true.
+bool onset_push(float x, float flux[ONSET_BANDS]);
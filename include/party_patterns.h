@@ -35,13 +35,23 @@ PatternID   pp_activePattern();
 // ---- Context update (call before pp_onBeat each beat) ----
 // state        : current audio analysis context
 // beatIntervalUs : microseconds per beat (used for BRK fade durations)
-void pp_setContext(ContextState state, uint32_t beatIntervalUs);
+// intensity    : 0..1 music intensity from the analyzer, scales the state's
+//                brightness cap and STD density; < 0 = none (fixed caps).
+//                The groove baseline maps to PP_INTENSITY_AT_BASE, where the
+//                caps are as configured.
+static constexpr float PP_INTENSITY_AT_BASE = 0.60f;
+void pp_setContext(ContextState state, uint32_t beatIntervalUs, float intensity = -1.0f);
 
 // ---- Pattern selection ----
 // Fixed pattern, ignores round-robin (used by pattern tester)
 void pp_setPattern(PatternID p);
 // Round-robin selection for state (used by party mode on state transitions)
 void pp_selectForState(ContextState s);
+// The next downbeat starts a musical phrase (party mode phrase detector):
+// the pattern window ends there instead of after its fixed PATTERN_LEN_BARS.
+// Call before that downbeat's beat is prepared. While starts keep coming the
+// window waits for them (up to 16 bars), then falls back to 8-bar windows.
+void pp_phraseStart();
 
 // ---- Beat events ----
 // Call pp_setContext() first, then pp_onBeat() each beat.
@@ -50,11 +60,42 @@ void pp_selectForState(ContextState s);
 void pp_onBeat(uint8_t bar, uint8_t beat);
 void pp_onHalfBeat();
 
+// ---- Scheduled beat commits (party mode) ----
+// pp_prepareBeat() runs the beat ahead of time with the given context (as
+// pp_setContext() + pp_onBeat()) but renders its frame into a pending buffer
+// instead of the LEDs; beatUs is the predicted beat instant, used as the
+// beat's start time by BREAK fades and DROP shimmers. Returns true if a frame
+// is pending. Until pp_commitPending() latches it, pp_render() keeps
+// rendering the shown beat; the prepared beat takes over after the latch.
+// pp_commitPending() may be called from a timer callback; the caller must not
+// re-prepare or latch from the loop while that callback is latching.
+// pp_reprepareBeat() is for the prepared beat's tick: if the context state
+// decided on the tick differs from the prepared one, the beat is run again
+// from where it was prepared and its frame pends again (latch it now if the
+// first one was already latched). Returns true if it did.
+bool pp_prepareBeat(uint8_t bar, uint8_t beat, uint32_t beatUs, ContextState state,
+                    uint32_t beatIntervalUs, float intensity = -1.0f);
+bool pp_reprepareBeat(ContextState state, uint32_t beatIntervalUs, float intensity = -1.0f);
+bool pp_commitPending();
+
 // ---- Render (call every loop tick) ----
 // Renders BREAK crossfades and DROP half-beat shimmers continuously.
 // STD patterns are rendered on beat events; render is a no-op for VIS_STD.
 void pp_render();
 
+// ---- Warm resume ----
+// Pattern engine position, small enough for the RTC snapshot (rtc_resume.h).
+struct PatternSnapshot {
+  uint8_t active;       // PatternID
+  uint8_t stdIdx, brkIdx, drpIdx, savedDrpIdx;
+  uint8_t windowBar;
+  uint8_t state;        // ContextState the pattern was chosen for
+};
+void pp_snapshot(PatternSnapshot* s);
+// Restores the position (after pp_reset()); the next beat continues the
+// pattern window without a re-selection.
+void pp_restore(const PatternSnapshot& s);
+
 // ---- Reset ----
 // Clears all visual state (pattern indices, crossfade, drop step, etc.)
 // and turns off all LEDs. Call on hard reset or mode entry.
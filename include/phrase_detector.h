@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+// Phrase-boundary detector (party mode, loop core, one call per finalized bar).
+//
+// Each bar becomes a vector of log levels (rms, tr, kVar, kMean) in a ring of
+// PHRASE_RING_BARS. Novelty of the new bar against the PHRASE_LAGS previous
+// windows (4 / 8 / 16 bars): per dimension a z-score against the window's
+// mean and spread, RMS over the dimensions, averaged over the lags that have
+// history. Window sums and sums of squares are kept running (the bar leaving
+// each window is subtracted), so there is no self-similarity matrix.
+// Phrase grid: novelty above PHRASE_NOISE accumulates, with forgetting, into
+// the bar's slot modulo PHRASE_GRID_BARS; the strongest slot is the phrase
+// phase once it stands out from the mean by PHRASE_MIN_CONTRAST. A bar with
+// novelty >= PHRASE_STRONG is a phrase start by itself (mix-in on an odd
+// bar) and halves every other slot, so the grid re-anchors within a phrase.
+// Cost per bar: 4 logs, 3 lags x 4 dims of running sums, 8 slot decays; the
+// sums are rebuilt from the ring once per PHRASE_RING_BARS (28 vectors).
+// Hit rate and cost on synthetic traces: test/test_bench_phrase_detector.
+
+static constexpr uint8_t PHRASE_RING_BARS    = 32;
+static constexpr uint8_t PHRASE_DIMS         = 4;
+static constexpr uint8_t PHRASE_LAGS         = 3;
+static constexpr uint8_t PHRASE_GRID_BARS    = 8;
+static constexpr float   PHRASE_NOISE        = 1.0f;    // z below this is ordinary bar-to-bar change
+static constexpr float   PHRASE_STRONG       = 3.0f;
+static constexpr float   PHRASE_MIN_CONTRAST = 2.0f;    // best slot / mean slot
+static constexpr uint8_t PHRASE_MIN_BARS     = 16;      // history before the grid is trusted
+static constexpr float   PHRASE_SLOT_DECAY   = 1.0f - 1.0f / 32.0f;
+
+class PhraseDetector {
+ public:
+  void reset();
+
+  // One finalized bar (linear features). Returns true when the bar's novelty
+  // alone makes it a phrase start (>= PHRASE_STRONG).
+  bool onBar(uint32_t bar, float rms, float tr, float kVar, float kMean);
+
+  // First bar after `bar` on the phrase grid; 0 while the grid is not trusted.
+  uint32_t nextStart(uint32_t bar) const;
+
+  bool    gridValid() const;
+  uint8_t phase() const;                         // bar % PHRASE_GRID_BARS of phrase starts
+  float   contrast() const;                      // best slot / mean slot
+  float   novelty() const { return lastNovelty; }
+  float   noveltyAt(uint8_t lag) const { return lastLagNovelty[lag]; }
+  uint8_t bars() const { return fill; }
+
+ private:
+  void resum();
+
+  float    ring[PHRASE_RING_BARS][PHRASE_DIMS] = {};
+  uint8_t  pos = 0, fill = 0;
+
+  float    sum[PHRASE_LAGS][PHRASE_DIMS] = {};
+  float    sumSq[PHRASE_LAGS][PHRASE_DIMS] = {};
+
+  float    slot[PHRASE_GRID_BARS] = {};
+  float    lastNovelty = 0.0f;
+  float    lastLagNovelty[PHRASE_LAGS] = {};
+};
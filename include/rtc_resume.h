@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Warm resume after an unintended reset (RTC slow memory).
+//
+// One snapshot lives in RTC_NOINIT memory, which keeps its contents through
+// every reset except power-on. A CRC-32 over the header and payload tells a
+// real snapshot from garbage (a deep brownout can corrupt it).
+//   main      resume_pending() at boot; otherwise resume_begin(mode) once the
+//             user has picked a mode
+//   mode      resume_store() with its own payload (party mode: every bar),
+//             resume_load() in its init when resuming, resume_clear() on any
+//             deliberate exit (YELLOW hold, no-MIDI timeout, mode stop)
+// Modes without a payload (game, diagnostic) resume header-only: the header
+// holds the mode until a deliberate exit and the mode restarts from its init.
+// A payload older than RESUME_MAX_AGE_MS is not loaded; the mode still
+// resumes, cold.
+// Only brownout, panic and watchdog resets resume; ESP.restart() in this
+// firmware is always deliberate and clears the snapshot first anyway.
+// The RTC timer keeps counting through those resets too, so a snapshot also
+// records when it was taken (resume_rtc_us() timebase).
+
+static constexpr uint16_t RESUME_PAYLOAD_MAX = 160;
+static constexpr uint32_t RESUME_MAX_AGE_MS  = 10000;  // older payloads are stale
+
+// Boot: true (and the saved mode, snapshot age) if the reset was unintended
+// and a valid snapshot exists, with or without a payload.
+bool        resume_pending(uint8_t* mode, uint32_t* ageMs);
+void        resume_begin(uint8_t mode);                     // new session: header only
+void        resume_store(const void* payload, uint16_t len);
+bool        resume_load(void* payload, uint16_t len);       // false: no fresh payload of that size
+void        resume_clear();
+
+uint64_t    resume_rtc_us();                                // RTC timer (us), survives the resets above
+const char* resume_reset_reason();
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+
+// I2S sample counter as a timebase (party mode, audio task).
+//
+// Maps the running count of captured frames to micros() and back, so a MIDI
+// tick stamp can be turned into the index of the sample it coincides with.
+// Each DMA block reports when its newest sample became available; the task
+// wakes some time after the descriptor completes, so every observation is
+// late by that wake latency and the earliest ones are the truth:
+//   lag    = arrival - (anchor time + nominal duration since the anchor)
+//   est    = min(lag, est + SAMPLE_CLOCK_LEAK_US) per block
+// The leak lets the estimate follow an I2S master that runs slower than the
+// CPU crystal (up to SAMPLE_CLOCK_LEAK_US per block, ~190 ppm at 5.3 ms
+// blocks); a faster one is followed at once by the min.
+// The anchor advances in whole seconds of samples (exactly 1e6 us), so the
+// arithmetic stays in range however long the session runs.
+
+static constexpr int32_t SAMPLE_CLOCK_LEAK_US = 1;
+
+class SampleClock {
+ public:
+  explicit SampleClock(uint32_t sampleRate) : fs(sampleRate) {}
+
+  void reset() { have = false; s0 = 0; us0 = 0; est = 0; lastDev = 0; }
+
+  // Frames [0, endSample) have been captured; the newest arrived at arriveUs.
+  void observe(uint64_t endSample, uint32_t arriveUs) {
+    if (!have) {
+      have = true;
+      s0 = endSample;
+      us0 = arriveUs;
+      est = 0;
+      lastDev = 0;
+      return;
+    }
+    while (endSample - s0 >= 2ull * fs) { s0 += fs; us0 += 1000000u; }
+    const int32_t lag = (int32_t)(arriveUs - (us0 + nominalUs(endSample - s0)));
+    lastDev = lag - est;
+    est = (lag < est + SAMPLE_CLOCK_LEAK_US) ? lag : est + SAMPLE_CLOCK_LEAK_US;
+  }
+
+  bool valid() const { return have; }
+
+  // micros() at which frame `sample` was captured
+  uint32_t usAt(uint64_t sample) const {
+    const int64_t d = (int64_t)(sample - s0);
+    const int64_t us = (d >= 0) ? (int64_t)nominalUs((uint64_t)d) : -(int64_t)nominalUs((uint64_t)-d);
+    return us0 + (uint32_t)est + (uint32_t)us;
+  }
+
+  // Index of the frame captured at micros() tUs (nearest)
+  uint64_t sampleAt(uint32_t tUs) const {
+    const int64_t dUs = (int32_t)(tUs - us0 - (uint32_t)est);
+    const int64_t num = dUs * (int64_t)fs;
+    const int64_t d = (num >= 0) ? (num + 500000) / 1000000 : -((-num + 500000) / 1000000);
+    return s0 + (uint64_t)d;
+  }
+
+  int32_t lagUs() const { return est; }          // wake latency floor vs the anchor
+  int32_t lastDevUs() const { return lastDev; }  // last block's latency above the floor
+
+ private:
+  uint64_t nominalUs(uint64_t frames) const { return (frames * 1000000ull + fs / 2) / fs; }
+
+  uint32_t fs;
+  bool     have = false;
+  uint64_t s0 = 0;        // anchor frame
+  uint32_t us0 = 0;       // anchor micros() (before est)
+  int32_t  est = 0;
+  int32_t  lastDev = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Wait-free single-producer / single-consumer ring.
+// One task (or ISR) calls push(), exactly one other task calls pop().
+// Neither side ever blocks or retries: a full ring drops the new item and
+// counts it in overflows(). highWater() is the deepest fill seen since reset().
+// N must be a power of two; capacity is N items.
+template <typename T, uint16_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+ public:
+  // Producer side
+  bool push(const T& v) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    const uint32_t t = tail.load(std::memory_order_acquire);
+    const uint32_t fill = h - t;
+    if (fill >= N) {
+      overflowCount.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    buf[h & (N - 1)] = v;
+    head.store(h + 1, std::memory_order_release);
+    if (fill + 1 > hwm.load(std::memory_order_relaxed))
+      hwm.store((uint16_t)(fill + 1), std::memory_order_relaxed);
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T& out) {
+    const uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;
+    out = buf[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size()      const { return (uint16_t)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire)); }
+  uint16_t capacity()  const { return N; }
+  uint16_t highWater() const { return hwm.load(std::memory_order_relaxed); }
+  uint32_t overflows() const { return overflowCount.load(std::memory_order_relaxed); }
+
+  // Only while neither side is running.
+  void reset() {
+    head.store(0); tail.store(0);
+    overflowCount.store(0); hwm.store(0);
+  }
+
+ private:
+  T buf[N];
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> tail{0};
+  std::atomic<uint32_t> overflowCount{0};
+  std::atomic<uint16_t> hwm{0};
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+
+// Streaming quantile of a positive metric: fixed-bin log histogram with
+// exponential forgetting (party mode baselines, loop core).
+//
+//   bins     QHIST_BINS_PER_OCT per octave (~4.4% wide), QHIST_OCTAVES wide,
+//            centred on the first value; when a value falls outside, the
+//            window slides by whole octaves, but never so far that the held
+//            median leaves it (mass beyond the far edge is folded into the
+//            edge bin, a value still outside counts in its edge bin)
+//   add      every bin decays by (1 - 1/horizon), the value's bin gains 1:
+//            a value weighs as in an EMA of time constant `horizon`, but the
+//            quantile of the decayed mass ignores outliers instead of
+//            averaging them in (an outlier moves the median by at most one
+//            value's share of the mass)
+//   seed     `weight` values' worth of mass at one value, kept as a point
+//            inside its bin (it decays and slides with the bin): a seeded
+//            value reads back as itself, not as its bin's interpolation,
+//            and values added later only move the quantile by their share
+//   quantile cumulative scan, log-linear interpolation inside the bin (the
+//            rest of the seed bin's mass spread around the seed point)
+// Cost per add / query: one pass over QHIST_BINS floats (512 bytes each).
+// After a step change the median crosses over in ~horizon * ln 2 values.
+
+static constexpr uint8_t  QHIST_BINS_PER_OCT = 16;
+static constexpr uint8_t  QHIST_OCTAVES      = 8;
+static constexpr uint16_t QHIST_BINS         = (uint16_t)QHIST_BINS_PER_OCT * QHIST_OCTAVES;
+
+class QuantileHist {
+ public:
+  QuantileHist() { reset(0); }
+
+  void reset(uint16_t horizon);                 // 0: no forgetting
+  void reset() { reset(horizon); }
+
+  void add(float x);
+
+  // Warm start: `weight` values' worth of mass at v (quantile() == v until
+  // other values arrive)
+  void seed(float v, float weight);
+
+  float    quantile(float p) const;             // p in [0, 1]; 0 before the first add
+  float    median() const { return quantile(0.5f); }
+  uint32_t count() const { return n; }          // values added since reset
+  float    mass() const { return total; }       // decayed weight held
+
+ private:
+  int  binOf(float x) const;
+  int  medianBin() const;
+  float inBin(int i, float t) const;
+  void slide(int octaves);                      // > 0: window moves up
+
+  uint16_t horizon = 0;
+  float    decay = 1.0f;
+  bool     haveOrigin = false;
+  float    lo = 0.0f;                           // log2 of the lower edge of bin 0
+  float    w[QHIST_BINS] = {};
+  float    total = 0.0f;
+  int      seedBin = 0;                         // seed point: bin, position in it, mass left
+  float    seedFrac = 0.0f;
+  float    seedW = 0.0f;
+  uint32_t n = 0;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+
+// Beat tempo tracker (party mode, loop core).
+//
+// Second-order phase-locked loop (alpha-beta filter) on MIDI beat timestamps:
+//   predicted  t^  = phase + period
+//   error      e   = t - t^
+//   phase     <-   t^ + ALPHA * e
+//   period    <-   period + BETA * e
+// With ALPHA = 1 the period update is exactly the former IIR
+// period = 0.85 * period + 0.15 * dt (BETA = 0.15); ALPHA < 1 additionally
+// smooths the beat phase, which is what predictedNextBeatUs() extrapolates.
+//
+// Guards stay policy (mode_party.cpp): every beat yields a candidate period,
+// D1 (range) and D2 (spike) are checked here against the configured limits,
+// then an optional accept hook (CLOCK_HOLD) may still veto the update.
+// A rejected beat re-anchors the phase to the observed time and leaves the
+// period untouched, like the former lastBeatUs / lastBeatIntervalUs pair.
+
+enum TempoVerdict : uint8_t {
+  TEMPO_FIRST = 0,       // no previous beat: phase anchored only
+  TEMPO_ACCEPT,          // period and phase updated
+  TEMPO_REJECT_RANGE,    // D1: candidate BPM outside [bpmMin, bpmMax]
+  TEMPO_REJECT_SPIKE,    // D2: candidate BPM jumps more than spikeBpm
+  TEMPO_REJECT_HOOK      // accept hook vetoed (e.g. CLOCK_HOLD)
+};
+
+struct TempoBeat {
+  TempoVerdict verdict;
+  uint32_t rawIntervalUs;     // observed time since the previous beat (0 on first)
+  uint32_t candidateUs;       // period the filter proposed for this beat
+  float    candBpm;
+  float    curBpm;            // estimate before this beat
+  int32_t  phaseErrUs;        // e = t - predicted
+};
+
+class TempoTracker {
+ public:
+  // Policy hook: return false to keep the current period for this beat.
+  // Called only for beats that passed D1 / D2.
+  typedef bool (*AcceptHook)(uint32_t rawIntervalUs, uint32_t candidateUs);
+
+  struct Config {
+    float alpha;              // phase gain   (0, 1]
+    float beta;               // period gain  (0, 4 - 2*alpha)
+    float bpmMin, bpmMax;     // D1
+    float spikeBpm;           // D2
+    float confErrFull;        // mean |e| / period at which confidence reaches 0
+    uint8_t lockBeats;        // accepted beats until confidence can reach 1
+  };
+
+  TempoTracker(const Config& c, uint32_t initialPeriodUs);
+
+  void setAcceptHook(AcceptHook h) { hook = h; }
+
+  // One beat at time tUs (micros()). Returns what happened to it.
+  TempoBeat onBeat(uint32_t tUs);
+
+  // Forget the phase (clock stop / resync); the period is kept.
+  void resync();
+
+  // Warm start from a saved estimate: period set, phase forgotten.
+  void setPeriod(uint32_t periodUs);
+
+  uint32_t periodUs() const { return (uint32_t)(period + 0.5f); }
+  float    bpm() const { return 60000000.0f / period; }
+  bool     hasPhase() const { return havePhase; }
+  uint32_t lastBeatUs() const { return phaseUs; }        // filtered beat phase
+  uint32_t predictedNextBeatUs() const { return phaseUs + periodUs(); }
+  // 0..1: lock progress times (1 - mean |phase error| / confErrFull)
+  float    confidence() const;
+
+ private:
+  Config     cfg;
+  AcceptHook hook = nullptr;
+  float    period;
+  uint32_t phaseUs = 0;         // filtered time of the last beat
+  uint32_t lastObsUs = 0;       // observed time of the last beat
+  bool     havePhase = false;
+  float    errEma = 0.0f;       // EMA of |e| / period
+  uint8_t  locked = 0;          // accepted beats since resync (saturating)
+};
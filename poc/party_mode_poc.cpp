@@ -31,6 +31,7 @@
 
 #include <Arduino.h>
 #include "driver/i2s.h"
+#include "dsp_filters.h"
 
 // ---------- VISUAL TYPES MUST BE ABOVE ANY FUNCTIONS ----------
 enum Wing : uint8_t { W_BLUE=0, W_RED=1, W_GREEN=2, W_YELLOW=3 };
@@ -142,8 +143,9 @@ static constexpr uint32_t MONITOR_WIN_MS = 75;
 static constexpr uint32_t WIN_SAMPLES = (SAMPLE_RATE * MONITOR_WIN_MS) / 1000;
 
 // -------------- FILTERS --------------
-static constexpr float LP_ENV_ALPHA = 0.010f;
-static constexpr float HP_ALPHA = 0.995f;
+// Designed at compile time for SAMPLE_RATE (dsp_filters.h, shared with src/)
+typedef OnePoleLP<SAMPLE_RATE, DSP_KICK_ENV_HZ> KickEnvLP;
+typedef OnePoleHP<SAMPLE_RATE, DSP_TR_HP_HZ>    TransientHP;
 
 // -------------- UTILS ----------------
 static inline float safeDiv(float a, float b) { return a / (b + 1e-9f); }
@@ -266,9 +268,8 @@ static double winSumSq = 0.0, winTrSum = 0.0;
 static Welford barKickW, winKickW;
 
 // filter states
-static float envLP = 0.0f;
-static float hp_y = 0.0f;
-static float hp_x_prev = 0.0f;
+static KickEnvLP   envLP;
+static TransientHP trHP;
 
 // ---- Latest I2S snapshots for logging ----
 static volatile float lastWinRms = 0.0f, lastWinTr = 0.0f, lastWinKVar = 0.0f;
@@ -1762,9 +1763,8 @@ static void resetForHardReset() {
 
   resetBarAcc();
   resetWinAcc();
-  envLP = 0.0f;
-  hp_y = 0.0f;
-  hp_x_prev = 0.0f;
+  envLP.reset();
+  trHP.reset();
 
   baseInited = false;
   baseRms = baseTr = baseKVar = baseKMean = 0.0f;
@@ -1831,9 +1831,8 @@ static void resetForResumeLike() {
 
   resetBarAcc();
   resetWinAcc();
-  envLP = 0.0f;
-  hp_y = 0.0f;
-  hp_x_prev = 0.0f;
+  envLP.reset();
+  trHP.reset();
 
   breakReset();
   clearReturnTracking();
@@ -2099,21 +2098,18 @@ static void processAudio() {
 
     const float ax = fabsf(x);
 
-    const float hp = HP_ALPHA * (hp_y + x - hp_x_prev);
-    hp_x_prev = x;
-    hp_y = hp;
-    const float trAx = fabsf(hp);
+    const float trAx = fabsf(trHP.process(x));
 
-    envLP += LP_ENV_ALPHA * (ax - envLP);
+    const float env = envLP.process(ax);
 
     barSumSq += (double)(x * x);
     barTrSum += (double)trAx;
-    barKickW.update((double)envLP);
+    barKickW.update((double)env);
     barN++;
 
     winSumSq += (double)(x * x);
     winTrSum += (double)trAx;
-    winKickW.update((double)envLP);
+    winKickW.update((double)env);
     winN++;
 
     if (winN >= WIN_SAMPLES) {
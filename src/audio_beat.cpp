@@ -0,0 +1,276 @@
+#include "audio_beat.h"
+#include <math.h>
+
+static constexpr float    ENV_RATE_MAX   = 200.0f;   // hops are averaged down to <= this
+static constexpr uint16_t HIST_LEN       = 1024;     // longest lag: 4 periods at ENV_RATE_MAX / ABEAT_BPM_MIN
+static constexpr uint16_t HIST_MASK      = HIST_LEN - 1;
+static constexpr uint8_t  COMB_HARM      = 4;        // tempo comb: lag and its multiples up to x4
+static constexpr uint16_t LAG_SPAN_CAP   = (uint16_t)(60.0f * ENV_RATE_MAX / ABEAT_BPM_MIN) + 2;
+static constexpr uint16_t ACF_CAP        = COMB_HARM * LAG_SPAN_CAP + 2;
+static_assert(HIST_LEN >= ACF_CAP, "history must hold the longest lag");
+
+static constexpr float LOCAL_MEAN_S   = 0.10f;   // envelope high-pass (mean removal)
+static constexpr float SLOW_MEAN_S    = 4.0f;    // envelope scale (level independence)
+static constexpr float ACF_TAU_S      = 4.0f;    // autocorrelation memory
+static constexpr float PRIOR_OCT      = 1.0f;    // prior width (octaves, 1 sigma)
+static constexpr uint8_t TEMPO_EVERY  = 32;      // envelope samples between tempo estimates
+static constexpr float PERIOD_TRACK   = 0.04f;   // |new - cur| / cur followed smoothly
+static constexpr float PERIOD_GAIN    = 0.25f;
+static constexpr uint8_t PERIOD_SWITCH = 6;      // consistent estimates before a jump (~1 s)
+static constexpr float PHASE_GAIN     = 0.30f;   // schedule pull per half beat once locked
+static constexpr float PHASE_SIGMA    = 0.20f;   // phase continuity (fraction of a period, 1 sigma)
+static constexpr float PHASE_JUMP_RATIO = 1.5f;
+static constexpr uint8_t PHASE_JUMP_COUNT = 4;
+static constexpr float CONF_GAIN      = 0.25f;   // per beat
+static constexpr uint8_t COMB_BEATS   = 4;
+static const float COMB_W[COMB_BEATS] = {1.0f, 0.75f, 0.5f, 0.25f};
+
+// ---- Static state ----
+static float    envRate = 187.5f;
+static uint8_t  decim = 1, decimFill = 0;
+static float    decimSum = 0.0f;
+static uint16_t lagMin = 0, lagMax = 0, acfMax = 0;
+static float    gLocal = 0.0f, gSlow = 0.0f, acfDecay = 0.0f;
+
+static float    hist[HIST_LEN];
+static uint32_t n = 0;                   // envelope samples pushed
+static float    acf[ACF_CAP];            // indexed by lag
+static float    prior[LAG_SPAN_CAP];     // indexed by lag - lagMin
+static float    score[LAG_SPAN_CAP];     // scratch: tempo comb / phase comb
+static float    acf0 = 0.0f, xSum = 0.0f;  // same leaky sums at lag 0 / of x itself
+static float    localMean = 0.0f, slowMean = 0.0f;
+static float    xPrev1 = 0.0f, xPrev2 = 0.0f;
+
+static bool     havePeriod = false;
+static float    period = 0.0f;           // envelope samples per beat
+static float    candPeriod = 0.0f;
+static uint8_t  candCount = 0;
+static uint8_t  sinceTempo = 0;
+static float    untilBeat = 0.0f;        // envelope samples to the next scheduled beat
+static bool     halfDone = false;
+static bool     phaseLocked = false;
+static uint8_t  jumpCount = 0;
+static float    tempoStrength = 0.0f, phaseClarity = 0.0f, conf = 0.0f;
+
+void abeat_init(float hopRate) {
+  decim = (uint8_t)ceilf(hopRate / ENV_RATE_MAX);
+  if (decim < 1) decim = 1;
+  envRate = hopRate / (float)decim;
+
+  lagMin = (uint16_t)floorf(60.0f * envRate / ABEAT_BPM_MAX);
+  lagMax = (uint16_t)ceilf(60.0f * envRate / ABEAT_BPM_MIN);
+  acfMax = (uint16_t)(COMB_HARM * lagMax + 1);
+
+  gLocal   = 1.0f / (LOCAL_MEAN_S * envRate);
+  gSlow    = 1.0f / (SLOW_MEAN_S * envRate);
+  acfDecay = expf(-1.0f / (ACF_TAU_S * envRate));
+
+  const float priorLag = 60.0f * envRate / ABEAT_BPM_PRIOR;
+  for (uint16_t l = lagMin; l <= lagMax; l++) {
+    const float oct = log2f((float)l / priorLag) / PRIOR_OCT;
+    prior[l - lagMin] = expf(-0.5f * oct * oct);
+  }
+  abeat_reset();
+}
+
+void abeat_reset() {
+  for (uint16_t i = 0; i < HIST_LEN; i++) hist[i] = 0.0f;
+  for (uint16_t i = 0; i < ACF_CAP; i++) acf[i] = 0.0f;
+  acf0 = xSum = 0.0f;
+  n = 0;
+  decimFill = 0;
+  decimSum = 0.0f;
+  localMean = slowMean = 0.0f;
+  xPrev1 = xPrev2 = 0.0f;
+  havePeriod = false;
+  period = candPeriod = 0.0f;
+  candCount = sinceTempo = 0;
+  untilBeat = 0.0f;
+  halfDone = phaseLocked = false;
+  jumpCount = 0;
+  tempoStrength = phaseClarity = conf = 0.0f;
+}
+
+float abeat_bpm() { return havePeriod ? 60.0f * envRate / period : 0.0f; }
+float abeat_confidence() { return conf; }
+
+static inline float histAt(uint32_t back) { return hist[(n - 1 - back) & HIST_MASK]; }
+
+// (peak - mean) / peak of a non-negative score, 0 when flat
+static inline float clarity(float peak, float sum, uint16_t count) {
+  if (peak <= 0.0f || count == 0) return 0.0f;
+  const float c = (peak - sum / (float)count) / peak;
+  return (c > 0.0f) ? c : 0.0f;
+}
+
+static inline float parabolic(float a, float b, float c) {
+  const float den = a - 2.0f * b + c;
+  if (den >= 0.0f) return 0.0f;
+  float d = 0.5f * (a - c) / den;
+  if (d > 0.5f) d = 0.5f;
+  if (d < -0.5f) d = -0.5f;
+  return d;
+}
+
+static void estimateTempo() {
+  float* s = score;
+  const uint16_t span = (uint16_t)(lagMax - lagMin + 1);
+  uint16_t best = 0;
+  float sum = 0.0f;
+  for (uint16_t i = 0; i < span; i++) {
+    const uint16_t l = (uint16_t)(lagMin + i);
+    float v = acf[l];
+    for (uint8_t m = 2; m <= COMB_HARM; m++) {
+      const uint16_t lm = (uint16_t)(m * l);
+      float a = acf[lm];
+      if (acf[lm - 1] > a) a = acf[lm - 1];
+      if (acf[lm + 1] > a) a = acf[lm + 1];
+      v += a / (float)m;
+    }
+    s[i] = prior[i] * v;
+    sum += s[i];
+    if (s[i] > s[best]) best = i;
+  }
+  float p = (float)(lagMin + best);
+
+  // Strength: autocorrelation coefficient at the chosen lag (~0 for noise)
+  const float w = 1.0f - acfDecay;                  // 1 / sum of the leaky weights
+  const float mu = xSum * w;
+  const float var = acf0 * w - mu * mu;
+  const float rho = (var > 0.0f) ? (acf[lagMin + best] * w - mu * mu) / var : 0.0f;
+  tempoStrength = (rho > 0.0f) ? ((rho < 1.0f) ? rho : 1.0f) : 0.0f;
+
+  if (best > 0 && best + 1 < span) p += parabolic(s[best - 1], s[best], s[best + 1]);
+
+  if (!havePeriod) {
+    havePeriod = true;
+    period = p;
+    untilBeat = p;
+    halfDone = false;
+    phaseLocked = false;
+    candCount = 0;
+    return;
+  }
+  if (fabsf(p - period) <= PERIOD_TRACK * period) {
+    period += PERIOD_GAIN * (p - period);
+    candCount = 0;
+  } else if (candCount > 0 && fabsf(p - candPeriod) <= PERIOD_TRACK * candPeriod) {
+    if (++candCount >= PERIOD_SWITCH) { period = p; candCount = 0; phaseLocked = false; }
+  } else {
+    candPeriod = p;
+    candCount = 1;
+  }
+}
+
+// Envelope samples back from the newest one to the most recent beat, by a
+// COMB_BEATS comb at the current period. Once locked, offsets far from the
+// scheduled one (expectK) are penalised so an off-beat cannot take over in
+// one step; a much stronger unpenalised offset wins after PHASE_JUMP_COUNT
+// half beats in a row (e.g. locked onto the off-beat after a tempo switch).
+static float phaseComb(float expectK) {
+  float* sc = score;
+  uint16_t pInt = (uint16_t)(period + 0.5f);
+  if (pInt > LAG_SPAN_CAP) pInt = LAG_SPAN_CAP;
+  uint16_t kRaw = 0, kPen = 0;
+  float bestRaw = -1.0f, bestPen = -1.0f, sum = 0.0f;
+  for (uint16_t k = 0; k < pInt; k++) {
+    float v = 0.0f;
+    for (uint8_t j = 0; j < COMB_BEATS; j++)
+      v += COMB_W[j] * histAt((uint32_t)k + (uint32_t)((float)j * period + 0.5f));
+    sc[k] = v;
+    sum += v;
+    if (v > bestRaw) { bestRaw = v; kRaw = k; }
+
+    float d = (float)k - expectK;
+    if (d >= 0.5f * period) d -= period;
+    if (d < -0.5f * period) d += period;
+    d /= PHASE_SIGMA * period;
+    const float pen = v * expf(-0.5f * d * d);
+    if (pen > bestPen) { bestPen = pen; kPen = k; }
+  }
+  phaseClarity = clarity(bestRaw, sum, pInt);
+
+  uint16_t k = kRaw;
+  if (phaseLocked) {
+    if (bestRaw >= PHASE_JUMP_RATIO * sc[kPen]) {
+      if (++jumpCount < PHASE_JUMP_COUNT) k = kPen;
+      else jumpCount = 0;
+    } else {
+      jumpCount = 0;
+      k = kPen;
+    }
+  }
+  // offsets wrap around the period
+  const float prev = sc[(k + pInt - 1) % pInt];
+  const float next = sc[(k + 1) % pInt];
+  return (float)k + parabolic(prev, sc[k], next) + 1.0f;   // + smoothing delay
+}
+
+bool abeat_push(float flux, AudioBeatEvent* ev) {
+  decimSum += flux;
+  if (++decimFill < decim) return false;
+  const float v = decimSum / (float)decim;
+  decimFill = 0;
+  decimSum = 0.0f;
+
+  // Onset envelope
+  localMean += gLocal * (v - localMean);
+  float o = v - localMean;
+  if (o < 0.0f) o = 0.0f;
+  slowMean += gSlow * (o - slowMean);
+  const float xr = log1pf(o / (slowMean + 1e-9f));
+
+  // [1 2 1] / 4 smoothing: a one-hop onset must not fall between two lags
+  const float x = 0.25f * (xr + xPrev2) + 0.5f * xPrev1;
+  xPrev2 = xPrev1;
+  xPrev1 = xr;
+
+  hist[n & HIST_MASK] = x;
+  for (uint16_t l = lagMin; l <= acfMax; l++)
+    acf[l] = acfDecay * acf[l] + x * hist[(n - l) & HIST_MASK];
+  acf0 = acfDecay * acf0 + x * x;
+  xSum = acfDecay * xSum + x;
+  n++;
+
+  if (++sinceTempo >= TEMPO_EVERY) {
+    sinceTempo = 0;
+    if (n >= (uint32_t)(2 * acfMax)) estimateTempo();
+  }
+  if (!havePeriod) return false;
+
+  untilBeat -= 1.0f;
+
+  if (!halfDone && untilBeat <= 0.5f * period) {
+    halfDone = true;
+    const float late = 0.5f * period - untilBeat;
+
+    // Phase: where the comb puts the last beat vs where it was scheduled
+    const float age = period - untilBeat;
+    float err = age - phaseComb(age);                  // > 0: true beat later than scheduled
+    if (err >= 0.5f * period) err -= period;
+    if (err < -0.5f * period) err += period;
+    untilBeat += (phaseLocked ? PHASE_GAIN : 1.0f) * err;
+    phaseLocked = true;
+
+    ev->kind = ABEAT_HALF;
+    ev->lateHops = late * (float)decim;
+    ev->bpm = abeat_bpm();
+    ev->conf = conf;
+    return true;
+  }
+
+  if (untilBeat <= 0.0f) {
+    const float late = -untilBeat;
+    untilBeat += period;
+    halfDone = false;
+    const float c = sqrtf(tempoStrength * phaseClarity);
+    conf += CONF_GAIN * (c - conf);
+
+    ev->kind = ABEAT_BEAT;
+    ev->lateHops = late * (float)decim;
+    ev->bpm = abeat_bpm();
+    ev->conf = conf;
+    return true;
+  }
+  return false;
+}
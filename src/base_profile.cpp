@@ -0,0 +1,44 @@
+#include "base_profile.h"
+#include <math.h>
+
+static bool moved(float stored, float now, float delta) {
+  return fabsf(now - stored) > delta * fmaxf(stored, 1e-9f);
+}
+
+int8_t baseProfileSlot(const BaseProfile* slots, uint8_t n, uint8_t bpmBand, int8_t levelBand) {
+  for (uint8_t i = 0; i < n; i++)
+    if (slots[i].used && slots[i].bpmBand == bpmBand && slots[i].levelBand == levelBand) return (int8_t)i;
+  for (uint8_t i = 0; i < n; i++)
+    if (!slots[i].used) return (int8_t)i;
+  int8_t oldest = 0;
+  for (uint8_t i = 1; i < n; i++)
+    if (slots[i].seq < slots[oldest].seq) oldest = (int8_t)i;
+  return oldest;
+}
+
+bool baseProfileStore(BaseProfile& p, const BaseProfile& now, float delta, uint32_t* seq) {
+  const bool rekey = !p.used || p.bpmBand != now.bpmBand || p.levelBand != now.levelBand;
+  bool changed = rekey ||
+                 moved(p.rms, now.rms, delta) || moved(p.tr, now.tr, delta) ||
+                 moved(p.kVar, now.kVar, delta) || moved(p.kMean, now.kMean, delta);
+  if (now.hasBreak)
+    changed = changed || !p.hasBreak || moved(p.bfRms, now.bfRms, delta) ||
+              moved(p.bfTr, now.bfTr, delta) || moved(p.bfKVar, now.bfKVar, delta);
+  if (!changed) return false;
+
+  if (rekey) {                                 // evicted or empty: nothing of the old key survives
+    p.hasBreak = 0;
+    p.bfRms = p.bfTr = p.bfKVar = 0.0f;
+  }
+  p.used = 1;
+  p.bpmBand = now.bpmBand;
+  p.levelBand = now.levelBand;
+  p.seq = ++*seq;
+  p.rms = now.rms; p.tr = now.tr; p.kVar = now.kVar; p.kMean = now.kMean;
+  for (uint8_t b = 0; b < BAND_COUNT; b++) { p.bandE[b] = now.bandE[b]; p.bandV[b] = now.bandV[b]; }
+  if (now.hasBreak) {
+    p.hasBreak = 1;
+    p.bfRms = now.bfRms; p.bfTr = now.bfTr; p.bfKVar = now.bfKVar;
+  }
+  return true;
+}
@@ -0,0 +1,101 @@
+#include "beat_offset.h"
+#include <math.h>
+
+static constexpr int16_t CENTER_BIN = BEAT_OFFSET_BINS / 2;
+
+void BeatOffsetEstimator::reset() {
+  for (uint16_t i = 0; i < BEAT_OFFSET_HOPS; i++) { hopT[i] = 0; hopF[i] = 0.0f; }
+  hopPos = hopFill = 0;
+  resync();
+  for (uint8_t i = 0; i < BEAT_OFFSET_BARS; i++) est[i] = 0;
+  idx = fill = 0;
+  lastOk = false;
+  lastEst = 0;
+  lastProm = 0.0f;
+  rejected = 0;
+}
+
+void BeatOffsetEstimator::resync() {
+  for (uint8_t b = 0; b < BEAT_OFFSET_BINS; b++) hist[b] = 0.0f;
+  beatsInBar = 0;
+  havePrev = false;
+}
+
+void BeatOffsetEstimator::addOnset(uint32_t tUs, float strength) {
+  hopT[hopPos] = tUs;
+  hopF[hopPos] = strength;
+  hopPos = (uint16_t)((hopPos + 1) % BEAT_OFFSET_HOPS);
+  if (hopFill < BEAT_OFFSET_HOPS) hopFill++;
+}
+
+bool BeatOffsetEstimator::onBeat(uint32_t tUs) {
+  const bool had = havePrev;
+  const uint32_t beatUs = prevBeatUs;
+  havePrev = true;
+  prevBeatUs = tUs;
+  if (!had) return false;
+
+  const int32_t kw = kernelBins + 1;
+  for (uint16_t i = 0; i < hopFill; i++) {
+    const int32_t d = (int32_t)(hopT[i] - beatUs);
+    if (d < -BEAT_OFFSET_WIN_US || d > BEAT_OFFSET_WIN_US) continue;
+    const float f = hopF[i];
+    if (f <= 0.0f) continue;
+    const int32_t c = CENTER_BIN + (d + ((d >= 0) ? BEAT_OFFSET_BIN_US / 2 : -BEAT_OFFSET_BIN_US / 2)) / BEAT_OFFSET_BIN_US;
+    for (int32_t k = -kernelBins; k <= kernelBins; k++) {
+      const int32_t b = c + k;
+      if (b < 0 || b >= BEAT_OFFSET_BINS) continue;
+      hist[b] += f * (float)(kw - (k < 0 ? -k : k)) / (float)kw;
+    }
+  }
+
+  if (++beatsInBar < BEAT_OFFSET_BEATS) return false;
+  closeBar();
+  return true;
+}
+
+void BeatOffsetEstimator::closeBar() {
+  uint8_t best = 0;
+  float sum = 0.0f;
+  for (uint8_t b = 0; b < BEAT_OFFSET_BINS; b++) {
+    sum += hist[b];
+    if (hist[b] > hist[best]) best = b;
+  }
+  const float mean = sum / (float)BEAT_OFFSET_BINS;
+  lastProm = (mean > 0.0f) ? hist[best] / mean : 0.0f;
+
+  // Peak on the window edge: the true offset may lie outside it
+  lastOk = (lastProm >= BEAT_OFFSET_MIN_PROM) && best > 0 && best + 1 < BEAT_OFFSET_BINS;
+  if (lastOk) {
+    const float a = hist[best - 1], p = hist[best], c = hist[best + 1];
+    const float den = a - 2.0f * p + c;
+    const float frac = (den < 0.0f) ? 0.5f * (a - c) / den : 0.0f;
+    lastEst = (int32_t)lroundf(((float)(best - CENTER_BIN) + frac) * (float)BEAT_OFFSET_BIN_US);
+    est[idx] = lastEst;
+    idx = (uint8_t)((idx + 1) % BEAT_OFFSET_BARS);
+    if (fill < BEAT_OFFSET_BARS) fill++;
+  } else {
+    rejected++;
+  }
+
+  for (uint8_t b = 0; b < BEAT_OFFSET_BINS; b++) hist[b] = 0.0f;
+  beatsInBar = 0;
+}
+
+int32_t BeatOffsetEstimator::offsetUs() const {
+  if (fill == 0) return 0;
+  int64_t s = 0;
+  for (uint8_t i = 0; i < fill; i++) s += est[i];
+  return (int32_t)(s / fill);
+}
+
+uint32_t BeatOffsetEstimator::stdUs() const {
+  if (fill < 2) return 0;
+  const float m = (float)offsetUs();
+  float v = 0.0f;
+  for (uint8_t i = 0; i < fill; i++) {
+    const float d = (float)est[i] - m;
+    v += d * d;
+  }
+  return (uint32_t)(sqrtf(v / (float)(fill - 1)) + 0.5f);
+}
@@ -0,0 +1,78 @@
+#include "buildup_detector.h"
+#include <math.h>
+
+static constexpr float LEVEL_FLOOR = 1e-12f;                 // log of silence stays finite
+static constexpr float DB_PER_NEPER = 4.3429448f;             // 10 / ln(10): power ratio
+static constexpr float BEATS_PER_BAR = 4.0f;
+static const float THRESH_DB_BAR[BUILDUP_LEVELS] = { BUILDUP_TR_DB_BAR, BUILDUP_HATS_DB_BAR, BUILDUP_TILT_DB_BAR };
+
+void BuildupDetector::reset() {
+  for (uint8_t l = 0; l < BUILDUP_LEVELS; l++) {
+    winSum[l] = 0.0f;
+    slope[l] = r2[l] = 0.0f;
+    for (uint8_t i = 0; i < BUILDUP_BEATS; i++) pts[l][i] = 0.0f;
+  }
+  winN = 0;
+  pos = fill = 0;
+  lastScore = 0.0f;
+  streak = 0;
+  isArmed = false;
+}
+
+void BuildupDetector::addWindow(float tr, float hatsE, float bodyE) {
+  const float lt = 2.0f * logf(fmaxf(tr, LEVEL_FLOOR));        // mean |hp| is an amplitude
+  const float lh = logf(fmaxf(hatsE, LEVEL_FLOOR));
+  const float lb = logf(fmaxf(bodyE, LEVEL_FLOOR));
+  winSum[BUILDUP_TR]   += lt;
+  winSum[BUILDUP_HATS] += lh;
+  winSum[BUILDUP_TILT] += lh - lb;
+  winN++;
+}
+
+bool BuildupDetector::onBeat() {
+  if (winN == 0) return false;                 // no window closed in this beat
+  for (uint8_t l = 0; l < BUILDUP_LEVELS; l++) {
+    pts[l][pos] = winSum[l] / (float)winN;
+    winSum[l] = 0.0f;
+  }
+  winN = 0;
+  pos = (uint8_t)((pos + 1) % BUILDUP_BEATS);
+  if (fill < BUILDUP_BEATS) fill++;
+
+  const bool was = isArmed;
+  if (fill < BUILDUP_MIN_BEATS) return false;
+
+  // Oldest point first: x = 0 .. fill-1 (beats)
+  const uint8_t first = (uint8_t)((pos + BUILDUP_BEATS - fill) % BUILDUP_BEATS);
+  const float n = (float)fill;
+  const float mx = 0.5f * (n - 1.0f);
+  float sxx = 0.0f;
+  for (uint8_t i = 0; i < fill; i++) sxx += ((float)i - mx) * ((float)i - mx);
+
+  float score = 0.0f;
+  for (uint8_t l = 0; l < BUILDUP_LEVELS; l++) {
+    float my = 0.0f;
+    for (uint8_t i = 0; i < fill; i++) my += pts[l][(first + i) % BUILDUP_BEATS];
+    my /= n;
+    float sxy = 0.0f, syy = 0.0f;
+    for (uint8_t i = 0; i < fill; i++) {
+      const float dy = pts[l][(first + i) % BUILDUP_BEATS] - my;
+      sxy += ((float)i - mx) * dy;
+      syy += dy * dy;
+    }
+    const float b = sxy / sxx;                                 // nepers (log power) per beat
+    slope[l] = b * DB_PER_NEPER * BEATS_PER_BAR;
+    r2[l] = (syy > 0.0f) ? (sxy * sxy) / (sxx * syy) : 0.0f;
+    if (slope[l] > 0.0f && r2[l] >= BUILDUP_MIN_R2) {
+      const float s = r2[l] * slope[l] / THRESH_DB_BAR[l];
+      if (s > score) score = s;
+    }
+  }
+  lastScore = score;
+
+  if (score >= 1.0f) { if (streak < 255) streak++; }
+  else streak = 0;
+  if (!isArmed && streak >= BUILDUP_CONFIRM_BEATS) isArmed = true;
+  else if (isArmed && score < BUILDUP_DISARM_SCORE) isArmed = false;
+  return isArmed != was;
+}
@@ -0,0 +1,128 @@
+#include "clock_stats.h"
+#include <stdio.h>
+
+static constexpr float REF_GAIN = 1.0f / 32.0f;
+
+static inline uint8_t jitterBin(uint32_t v) {
+  if (v < 8) return (uint8_t)v;
+  const uint32_t e = 31u - (uint32_t)__builtin_clz(v);          // octave, >= 3
+  const uint32_t b = 8u + (e - 3u) * 4u + ((v >> (e - 2u)) & 3u);
+  return (b < CLOCK_STATS_BINS) ? (uint8_t)b : (uint8_t)(CLOCK_STATS_BINS - 1);
+}
+
+static inline uint32_t binLo(uint8_t b) {
+  if (b < 8) return b;
+  const uint32_t e = 3u + (uint32_t)(b - 8) / 4u;
+  const uint32_t m = (uint32_t)(b - 8) % 4u;
+  return (4u + m) << (e - 2u);
+}
+
+static_assert(CLOCK_STATS_RESEED_DROPS <= CLOCK_STATS_SEED, "drop run is held in the seed buffer");
+
+void ClockStats::reset() {
+  havePrev = false;
+  prevUs = 0;
+  ref = 0.0f;
+  n = 0;
+  sumDt = 0;
+  minDt = maxDt = 0;
+  maxJit = 0;
+  dropCount = missed = 0;
+  reseedCount = 0;
+  heldN = 0;
+  for (uint8_t i = 0; i < CLOCK_STATS_BINS; i++) hist[i] = 0;
+}
+
+// ref = median of the held intervals, which are then counted against it
+void ClockStats::reseedFromHeld() {
+  const uint8_t cnt = heldN;
+  uint32_t v[CLOCK_STATS_SEED], s[CLOCK_STATS_SEED] = {};
+  for (uint8_t i = 0; i < cnt; i++) {
+    v[i] = held[i];
+    uint8_t j = i;
+    for (; j > 0 && s[j - 1] > v[i]; j--) s[j] = s[j - 1];
+    s[j] = v[i];
+  }
+  ref = (float)s[cnt / 2];
+  heldN = 0;
+  for (uint8_t i = 0; i < cnt; i++) accept(v[i]);
+}
+
+void ClockStats::add(uint32_t tickUs) {
+  if (!havePrev) { havePrev = true; prevUs = tickUs; return; }
+  const uint32_t dt = tickUs - prevUs;
+  prevUs = tickUs;
+
+  if (ref <= 0.0f) {
+    held[heldN++] = dt;
+    if (heldN == CLOCK_STATS_SEED) reseedFromHeld();
+    return;
+  }
+  accept(dt);
+}
+
+void ClockStats::accept(uint32_t dt) {
+  if ((float)dt > CLOCK_STATS_DROP_FRAC * ref) {
+    dropCount++;
+    missed += (uint32_t)((float)dt / ref + 0.5f) - 1u;
+    held[heldN++] = dt;
+    if (heldN < CLOCK_STATS_RESEED_DROPS) return;
+    // Slower clock, not lost ticks: take the run back out of the drops
+    for (uint8_t i = 0; i < heldN; i++) {
+      dropCount--;
+      missed -= (uint32_t)((float)held[i] / ref + 0.5f) - 1u;
+    }
+    reseedCount++;
+    reseedFromHeld();
+    return;
+  }
+  heldN = 0;
+
+  const float dev = (float)dt - ref;
+  const uint32_t jit = (uint32_t)((dev < 0.0f ? -dev : dev) + 0.5f);
+  hist[jitterBin(jit)]++;
+  if (jit > maxJit) maxJit = jit;
+  ref += REF_GAIN * dev;
+
+  if (n == 0 || dt < minDt) minDt = dt;
+  if (dt > maxDt) maxDt = dt;
+  sumDt += dt;
+  n++;
+}
+
+uint32_t ClockStats::jitterQuantileUs(float q) const {
+  if (n == 0) return 0;
+  uint32_t need = (uint32_t)(q * (float)n + 0.5f);
+  if (need < 1) need = 1;
+  uint32_t acc = 0;
+  for (uint8_t b = 0; b < CLOCK_STATS_BINS; b++) {
+    acc += hist[b];
+    if (acc >= need) return (b + 1 < CLOCK_STATS_BINS) ? binLo((uint8_t)(b + 1)) - 1 : maxJit;
+  }
+  return maxJit;
+}
+
+int ClockStats::summary(char* buf, size_t len) const {
+  const float meanDt = meanIntervalUs();
+  const float bpm = (meanDt > 0.0f) ? 60000000.0f / (meanDt * 24.0f) : 0.0f;
+  return snprintf(buf, len,
+                  "ticks=%lu bpm=%.2f int_us=%.1f(%lu..%lu) jit_us p50=%lu p99=%lu max=%lu drops=%lu missed=%lu reseeds=%lu",
+                  (unsigned long)n, bpm, meanDt, (unsigned long)minDt, (unsigned long)maxDt,
+                  (unsigned long)jitterQuantileUs(0.50f), (unsigned long)jitterQuantileUs(0.99f),
+                  (unsigned long)maxJit, (unsigned long)dropCount, (unsigned long)missed,
+                  (unsigned long)reseedCount);
+}
+
+int ClockStats::histogram(char* buf, size_t len) const {
+  int used = 0;
+  if (len > 0) buf[0] = '\0';
+  for (uint8_t b = 0; b < CLOCK_STATS_BINS; b++) {
+    if (hist[b] == 0) continue;
+    if ((size_t)used >= len) break;
+    const int w = snprintf(buf + used, len - (size_t)used, "%s%lu:%lu",
+                           (used > 0) ? " " : "", (unsigned long)binLo(b), (unsigned long)hist[b]);
+    if (w < 0) break;
+    used += w;
+  }
+  return used;
+}
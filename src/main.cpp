@@ -4,6 +4,7 @@
 #include "mode_game.h"
 #include "mode_party.h"
 #include "mode_diagnostic.h"
+#include "rtc_resume.h"
 
 // Shimon - Top-level orchestrator  (Phase 3: Game + Party + Diagnostic)
 // Mode Selection (blocking, no timeout):
@@ -11,6 +12,9 @@
 //   GREEN single press  -> Party Mode
 //   RED   single press  -> Diagnostic Mode
 //   YELLOW hold >=5 s   -> Global Reset
+// After a brownout / watchdog / panic reset the saved mode resumes directly
+// (rtc_resume.h): party mode with its RTC snapshot, game and diagnostic from
+// their init; every deliberate restart goes through mode selection.
 
 enum TopMode : uint8_t { GAME_MODE = 0, PARTY_MODE = 1, DIAG_MODE = 2 };
 static TopMode activeMode = GAME_MODE;
@@ -74,12 +78,22 @@ static TopMode runModeSelection() {
 
 void setup() {
   Serial.begin(115200);
-  delay(300);
+  uint8_t savedMode = 0;
+  uint32_t ageMs = 0;
+  const bool resume = resume_pending(&savedMode, &ageMs) && savedMode <= DIAG_MODE;
+  if (!resume) delay(300);
   Serial.println("\n=== Shimon v" SHIMON_VERSION " ===");
   hw_led_init();
   hw_btn_init();
-  Serial.println("[BOOT] Hardware init done. Entering mode selection.");
-  activeMode = runModeSelection();
+  if (resume) {
+    activeMode = (TopMode)savedMode;
+    Serial.printf("[BOOT] %s reset: resuming mode %u (snapshot %lu ms old) at %lu ms.\n",
+                  resume_reset_reason(), (unsigned)savedMode, (unsigned long)ageMs, (unsigned long)millis());
+  } else {
+    Serial.printf("[BOOT] Hardware init done (reset: %s). Entering mode selection.\n", resume_reset_reason());
+    activeMode = runModeSelection();
+    resume_begin((uint8_t)activeMode);
+  }
   switch (activeMode) {
     case PARTY_MODE: party_init(); break;
     case DIAG_MODE:  diag_init();  break;
@@ -0,0 +1,80 @@
+#include "midi_parser.h"
+
+// Data bytes following a status byte
+static uint8_t dataLength(uint8_t status) {
+  if (status < 0xF0) {
+    const uint8_t hi = status & 0xF0;
+    return (hi == 0xC0 || hi == 0xD0) ? 1 : 2;   // program change / channel pressure
+  }
+  switch (status) {
+    case 0xF1: return 1;   // MTC quarter frame
+    case 0xF2: return 2;   // Song Position Pointer
+    case 0xF3: return 1;   // Song Select
+    default:   return 0;   // 0xF4 / 0xF5 undefined, 0xF6 tune request, 0xF7 EOX
+  }
+}
+
+MidiMsgType MidiParser::push(uint8_t b, MidiMsg* out) {
+  // Real-time: single byte, may appear anywhere, touches no parser state
+  if (b >= 0xF8) {
+    out->status = b;
+    out->d1 = out->d2 = 0;
+    out->spp = 0;
+    switch (b) {
+      case 0xF8: out->type = MIDI_MSG_CLOCK;    break;
+      case 0xFA: out->type = MIDI_MSG_START;    break;
+      case 0xFB: out->type = MIDI_MSG_CONTINUE; break;
+      case 0xFC: out->type = MIDI_MSG_STOP;     break;
+      default:   out->type = MIDI_MSG_SYSTEM;   break;   // active sensing, reset, undefined
+    }
+    return out->type;
+  }
+
+  if (b & 0x80) {
+    // Any other status byte ends a SysEx
+    if (inSysex) { inSysex = false; sysexCount++; }
+    if (b == 0xF0) { inSysex = true; running = 0; need = 0; return MIDI_MSG_NONE; }
+    if (b == 0xF7) { running = 0; need = 0; return MIDI_MSG_NONE; }   // EOX without SysEx
+
+    got = 0;
+    need = dataLength(b);
+    if (b < 0xF0) {
+      running = b;                    // channel message: becomes running status
+    } else {
+      running = 0;                    // system common clears running status
+      if (need == 0) {
+        out->type = MIDI_MSG_SYSTEM;
+        out->status = b; out->d1 = out->d2 = 0; out->spp = 0;
+        return out->type;
+      }
+      running = b;                    // completed below, then cleared
+    }
+    return MIDI_MSG_NONE;
+  }
+
+  // Data byte
+  if (inSysex) return MIDI_MSG_NONE;
+  if (running == 0 || need == 0) { strayCount++; return MIDI_MSG_NONE; }
+
+  data[got++] = b;
+  if (got < need) return MIDI_MSG_NONE;
+  got = 0;
+
+  out->status = running;
+  out->d1 = data[0];
+  out->d2 = (need > 1) ? data[1] : 0;
+  out->spp = 0;
+  if (running < 0xF0) {
+    out->type = MIDI_MSG_CHANNEL;     // running status stays armed
+  } else {
+    if (running == 0xF2) {
+      out->type = MIDI_MSG_SPP;
+      out->spp  = (uint16_t)(data[0] | ((uint16_t)data[1] << 7));
+    } else {
+      out->type = MIDI_MSG_SYSTEM;
+    }
+    running = 0;
+    need = 0;
+  }
+  return out->type;
+}
@@ -14,6 +14,9 @@
 #include "shimon.h"
 #include "hw.h"
 #include "mode_diagnostic.h"
+#include "rtc_resume.h"
+#include "dsp_filters.h"
+#include "clock_stats.h"
 
 #ifndef USE_WOKWI
 #include <HardwareSerial.h>
@@ -44,8 +47,10 @@ static constexpr uint32_t   D_MIN_FRAMES   = 10000;  // below = no I2S clock (co
 static constexpr float      D_MUSIC_RMS    = 0.050f; // above = music signal present
 
 // ---- Signal processing (mirrors party mode) ----
-static constexpr float LP_ENV_ALPHA = 0.010f;  // low-pass envelope coefficient
-static constexpr float HP_COEFF     = 0.95f;   // high-pass coefficient (removes DC/sub)
+// Same compile-time kernels and cutoffs as party mode (dsp_filters.h). The
+// envelope runs at full rate here (party mode decimates it first).
+typedef OnePoleLP<I2S_SAMPLE_RATE, DSP_KICK_ENV_HZ> DiagEnvLP;      // low-pass envelope
+typedef OnePoleHP<I2S_SAMPLE_RATE, DSP_TR_HP_HZ>    DiagTransientHP; // removes DC/sub
 
 // ---- Phase E ----
 static constexpr uint8_t PHASE_E_TRACK = 1;
@@ -123,14 +128,14 @@ static float    phCD_bpm;
 static uint32_t phCD_lastTickUs;
 static uint8_t  phCD_ticksInBar;
 static uint8_t  phCD_barCount;
+static ClockStats phCD_clk;          // tick intervals / jitter (same module as party mode)
 
 // ---- Phase CD: I2S (global accumulators) ----
 static double      phCD_sumSq;
 static double      phCD_trSum;
 static uint32_t    phCD_frames;
-static float       phCD_envLP;
-static float       phCD_hp_y;
-static float       phCD_hp_xPrev;
+static DiagEnvLP       phCD_envLP;
+static DiagTransientHP phCD_hp;
 static DiagWelford phCD_kickW;
 
 // ---- Phase CD: I2S (per-bar accumulators) ----
@@ -291,9 +296,10 @@ static void phCD_enter() {
   // MIDI
   phCD_midiTicks = 0; phCD_totalBytes = 0; phCD_bpm = 0.0f;
   phCD_lastTickUs = 0; phCD_ticksInBar = 0; phCD_barCount = 0;
+  phCD_clk.reset();
   // I2S global
   phCD_sumSq = 0.0; phCD_trSum = 0.0; phCD_frames = 0;
-  phCD_envLP = 0.0f; phCD_hp_y = 0.0f; phCD_hp_xPrev = 0.0f;
+  phCD_envLP.reset(); phCD_hp.reset();
   phCD_kickW.reset();
   // I2S per-bar
   phCD_barSumSq = 0.0; phCD_barTrSum = 0.0; phCD_barFrames = 0;
@@ -358,6 +364,7 @@ static bool phCD_tick() {
     phCD_totalBytes++;
     if (b == MIDI_CLOCK_BYTE) {
       uint32_t us = micros();
+      phCD_clk.add(us);
       if (phCD_lastTickUs > 0) {
         uint32_t dt = us - phCD_lastTickUs;
         if (dt > 0) phCD_bpm = 60000000.0f / ((float)dt * 24.0f);
@@ -380,19 +387,17 @@ static bool phCD_tick() {
   uint32_t frames = bytes / 4;
   for (uint32_t i = 0; i < frames; i++) {
     float x  = (float)buf[i] / 2147483647.0f;
-    float hp = HP_COEFF * (phCD_hp_y + x - phCD_hp_xPrev);
-    phCD_hp_y     = hp;
-    phCD_hp_xPrev = x;
+    float hp = phCD_hp.process(x);
     float ax = fabsf(x);
-    phCD_envLP += LP_ENV_ALPHA * (ax - phCD_envLP);
+    float env = phCD_envLP.process(ax);
     phCD_sumSq += (double)(x * x);
     phCD_trSum += (double)fabsf(hp);
     phCD_frames++;
-    phCD_kickW.update((double)phCD_envLP);
+    phCD_kickW.update((double)env);
     phCD_barSumSq += (double)(x * x);
     phCD_barTrSum += (double)fabsf(hp);
     phCD_barFrames++;
-    phCD_barKickW.update((double)phCD_envLP);
+    phCD_barKickW.update((double)env);
   }
 
   // --- Live beat flash ---
@@ -428,6 +433,11 @@ static void phCD_evaluateAndLog() {
 
   Serial.printf("  MIDI: PASS (%lu ticks, BPM=%.1f)\n",
                 (unsigned long)phCD_midiTicks, phCD_bpm);
+  char line[512];
+  phCD_clk.summary(line, sizeof(line));
+  Serial.printf("  CLOCK: %s\n", line);
+  phCD_clk.histogram(line, sizeof(line));
+  Serial.printf("  CLOCK_HIST jit_us: %s\n", line);
   resultC = DR_PASS;
 
   if (phCD_frames < D_MIN_FRAMES) {
@@ -651,11 +661,13 @@ void diag_tick() {
       if (hw_btn_any_edge(nullptr)) {
         hw_led_all_off();
         Serial.println("[DIAG] Returning to Mode Selection...");
+        resume_clear();
         delay(200); ESP.restart();
       }
       if (millis() - diagDoneStart >= DIAG_DONE_AUTO_MS) {
         hw_led_all_off();
         Serial.println("[DIAG] Auto-returning to Mode Selection...");
+        resume_clear();
         delay(200); ESP.restart();
       }
       if (millis() - diagTimer >= 750UL) {
@@ -671,6 +683,7 @@ void diag_tick() {
 }
 
 void diag_stop() {
+  resume_clear();                    // deliberate exit: the next boot selects a mode
   hw_led_all_off();
 #ifndef USE_WOKWI
   DiagMidi.end();
@@ -2,6 +2,7 @@
 #include "shimon.h"
 #include "hw.h"
 #include "mode_game.h"
+#include "rtc_resume.h"
 
 #ifndef USE_WOKWI
 #include <HardwareSerial.h>
@@ -1206,6 +1207,7 @@ void game_tick() {
 
 // ---- Mode interface ----
 void game_stop() {
+  resume_clear();                    // deliberate exit: the next boot selects a mode
   audio.shutdown();
   for (int i = 0; i < COLOR_COUNT; i++) {
     setLed((Color)i, false);
@@ -3,9 +3,29 @@
 
 #include <Arduino.h>
 #include "driver/i2s.h"
+#include "esp_timer.h"
 #include "mode_party.h"
 #include "hw.h"
 #include "party_patterns.h"
+#include "feature_acc.h"
+#include "dsp_filters.h"
+#include "filter_bank.h"
+#include "spsc_ring.h"
+#include "onset_flux.h"
+#include "tempo_tracker.h"
+#include "midi_parser.h"
+#include "clock_stats.h"
+#include "audio_beat.h"
+#include "beat_offset.h"
+#include "sample_clock.h"
+#include "buildup_detector.h"
+#include "streaming_quantile.h"
+#include "rtc_resume.h"
+#include "crc32.h"
+#include "phrase_detector.h"
+#include "base_profile.h"
+#include <Preferences.h>
+#include <type_traits>
 #ifndef USE_WOKWI
 #include <DFRobotDFPlayerMini.h>
 #include "shimon.h"   // DFPLAYER_RX / DFPLAYER_TX
@@ -39,6 +59,25 @@ static constexpr bool DEBUG_BEAT_LOG = false;
 // and BASE_SKIP (rejected bar + skip reason) to track baseline development.
 static constexpr bool DEBUG_BASELINE_LOG = false; // flip to true to log BASE_SKIP/BASE_UPDATE per bar
 
+// Set to true to run the legacy EMA baseline (with its band gate) alongside the
+// quantile baseline and log both per qualified bar (BASE_CMP).
+static constexpr bool DEBUG_BASELINE_SHADOW = false;
+
+// Set to true to run the legacy double-precision accumulators alongside the
+// fixed-point FeatureAcc and log the worst relative deviation per bar (ACC_SHADOW).
+// Costs the old per-sample double path again — verification builds only. The
+// same check runs on the host in test/test_feature_acc (pio test -e native).
+static constexpr bool DEBUG_ACC_SHADOW = false;
+
+// Set to true to time the audio task's per-sample loop with the CPU cycle
+// counter and log AUDIO_CYCLES (per sample, filter bank, onset FFT + beat tracker per hop,
+// per 75 ms window vs the window budget) with the AUDIO_RING line.
+static constexpr bool DEBUG_AUDIO_CYCLES = false;
+
+// Set to true to log the 16th-note GRID profile (kick / rms / tr per slot)
+// of every finalized bar.
+static constexpr bool DEBUG_GRID_LOG = false;
+
 // ---------------- VISUAL TUNABLES ----------------
 static constexpr uint8_t DEBUG_BRIGHT = 200;
 
@@ -54,6 +93,25 @@ static constexpr uint8_t BASE_BRIGHT = 235;
 // Pattern window length
 static constexpr uint8_t PATTERN_LEN_BARS = 8;
 
+// Continuous intensity (0..1) for the pattern engine, one per monitor window.
+// level = weighted window ratios vs baseline (kick capped at the top level);
+// the break floor's level (INTENSITY_FLOOR_LEVEL without one) maps to 0, the
+// baseline to PP_INTENSITY_AT_BASE (party_patterns.h) and INTENSITY_TOP_LEVEL
+// x baseline to 1, then a one-pole smoother. The states still pick the
+// pattern families; this only moves brightness and density between them
+// (pp_setContext).
+// Cost per monitor window: three multiplies for the level, one multiply-add
+// for the mapping and the smoother; no divides. The weighted reciprocals of
+// the baseline and the mapping below the baseline (from the floor's level)
+// are cached by intensityRefresh() whenever the baseline or the break floor
+// moves: per bar, baseline init / seed, BREAK entry / exit and resume.
+static constexpr float INTENSITY_W_RMS       = 0.45f;
+static constexpr float INTENSITY_W_TR        = 0.35f;
+static constexpr float INTENSITY_W_KICK      = 0.20f;
+static constexpr float INTENSITY_FLOOR_LEVEL = 0.25f;
+static constexpr float INTENSITY_TOP_LEVEL   = 1.60f;
+static constexpr float INTENSITY_ALPHA       = 0.25f;   // ~300 ms at 75 ms windows
+
 // Retrigger dip for accented beats (STD-02)
 static constexpr float RETRIGGER_DIP = 0.15f;       // Brief dip at beat boundary
 static constexpr float ACCENT_BOOST = 1.12f;        // Slight brightness boost on accent
@@ -68,21 +126,66 @@ static constexpr float DROP_OVERLAP_FRAC = 0.10f;
 static constexpr i2s_port_t I2S_PORT = I2S_NUM_0;
 // I2S_PIN_BCLK / I2S_PIN_LRCK / I2S_PIN_DATA / I2S_SAMPLE_RATE defined in shimon.h
 
-static constexpr int I2S_READ_FRAMES = 256;
+static constexpr int I2S_DMA_BUF_COUNT = 6;
+static constexpr int I2S_DMA_BUF_LEN   = 256;               // frames per DMA descriptor
+static constexpr int I2S_READ_FRAMES   = I2S_DMA_BUF_LEN;   // one read == one completed descriptor
+static constexpr int I2S_EVENT_QUEUE_LEN = I2S_DMA_BUF_COUNT;
 
 // -------------- MONITOR WINDOW (policy) --------------
 static constexpr uint32_t MONITOR_WIN_MS = 75;
-static constexpr uint32_t WIN_SAMPLES = (I2S_SAMPLE_RATE * MONITOR_WIN_MS) / 1000;
+// WIN_SAMPLES: see FILTERS (rounded to whole envelope ticks)
 
 // -------------- FILTERS --------------
-static constexpr float LP_ENV_ALPHA = 0.010f;
-static constexpr float HP_ALPHA = 0.995f;
+// All coefficients are designed at compile time from Hz and I2S_SAMPLE_RATE
+// (dsp_filters.h): the transient high-pass (DSP_TR_HP_HZ, ~38 Hz) runs at
+// full rate, the kick envelope (DSP_KICK_ENV_HZ, ~77 Hz) at fs / ENV_DECIM.
+//
+// Kick envelope runs after a CIC decimator (x8 or x12): the envelope only
+// tracks < 120 Hz energy, so full-rate updates are wasted work. Its one-pole
+// is designed for the decimated rate, so the pole stays at the same Hz.
+static constexpr uint8_t ENV_DECIM = 12;
+static_assert(ENV_DECIM == 8 || ENV_DECIM == 12, "ENV_DECIM: x8 or x12");
+static constexpr uint32_t ENV_RATE = I2S_SAMPLE_RATE / ENV_DECIM;
+static_assert(I2S_SAMPLE_RATE % ENV_DECIM == 0, "sample rate must divide by ENV_DECIM");
+
+// Monitor window in whole envelope ticks: 75 ms at 48 / 96 kHz, 74.8 ms at 44.1 kHz
+static constexpr uint32_t WIN_SAMPLES = ((I2S_SAMPLE_RATE * MONITOR_WIN_MS) / 1000 / ENV_DECIM) * ENV_DECIM;
+
+typedef OnePoleHP<I2S_SAMPLE_RATE, DSP_TR_HP_HZ>  TransientHP;
+typedef OnePoleLP<ENV_RATE, DSP_KICK_ENV_HZ>      KickEnvLP;
+
+// kVar(decimated) / kVar(full rate): the CIC removes envelope ripple above
+// fs/(2*D), which the full-rate one-pole only attenuated. Measured on
+// kick / bass / hat / pad mixes: 0.994..1.000 (x12), 0.997..1.000 (x8).
+// Absolute kVar thresholds are scaled by this so detection does not move.
+static constexpr float ENV_DECIM_KVAR_SCALE = (ENV_DECIM == 12) ? 0.997f : 0.999f;
+
+// Band filter bank (include/filter_bank.h): kick (sub), body (low-mid) and
+// hats, energy and envelope variance per window and bar.
+// Staging: the kbR / bdR / hhR ratios are logged (bar line, BASE_INIT,
+// RETURN / DROP events) and tracked in the baselines, but no detection
+// threshold uses them yet; that waits for tuning on recordings.
+// BANK_FIXED_POINT selects the Q24 / Q28 integer sections instead of float
+// (the sections only: the path around them stays float, see the header).
+static constexpr bool  BANK_FIXED_POINT = false;
+typedef std::conditional<BANK_FIXED_POINT, int32_t, float>::type BankSample;
+
+// Spectral-flux onset engine (onset_flux.h): 512-point FFT every 256 samples
+// on the audio task. Adds onset strength next to winRms / winTr / winKVar.
+static constexpr bool ONSET_FFT_ENABLE = true;
+
+// Audio beat tracker (audio_beat.h): tempo and beats from the onset flux, run
+// on the audio task after each FFT hop. Clock source when there is no MIDI
+// clock (see AUDIO CLOCK). Needs ONSET_FFT_ENABLE. Its envelope weights the
+// LOW (kick) band flux over MID / HIGH so hats do not pull the beat off.
+static constexpr bool  AUDIO_BEAT_ENABLE     = true;
+static constexpr float AUDIO_BEAT_LOW_WEIGHT = 2.0f;
 
 // -------------- UTILS ----------------
 static inline float safeDiv(float a, float b) { return a / (b + 1e-9f); }
 static inline float clamp01(float x) { return (x < 0.0f) ? 0.0f : (x > 1.0f ? 1.0f : x); }
 
-// -------------- WELFORD --------------
+// -------------- WELFORD (double reference, DEBUG_ACC_SHADOW only) --------------
 struct Welford {
   double mean = 0.0, m2 = 0.0;
   uint32_t n = 0;
@@ -95,6 +198,16 @@ struct Welford {
     m2 += d * d2;
   }
   float var() const { return (n < 2) ? 0.0f : (float)(m2 / (double)(n - 1)); }
+  // Chan's parallel combine
+  void merge(const Welford& o) {
+    if (o.n == 0) return;
+    if (n == 0) { *this = o; return; }
+    const uint32_t nn = n + o.n;
+    const double d = o.mean - mean;
+    mean += d * (double)o.n / (double)nn;
+    m2   += o.m2 + d * d * (double)n * (double)o.n / (double)nn;
+    n = nn;
+  }
 };
 
 // -------------- BASELINE (policy) -------------
@@ -102,12 +215,25 @@ static constexpr float BASE_ALPHA_STD      = 0.10f; // post-ready: slow, stable
 static constexpr float BASE_ALPHA_LEARNING = 0.30f; // pre-ready: fast convergence from false init
 static constexpr uint16_t BASELINE_MIN_QUALIFIED_BARS = 16;
 
+// Quantile baselines: each metric is the median of its qualified bars, kept in
+// a log histogram that forgets with BASELINE_QUANTILE_HORIZON (streaming_quantile.h).
+// An outlier bar moves a median by one bar's share at most, so no BASELINE_UPDATE_*
+// gate is needed after ready, and a new track level takes over in ~horizon*ln2 bars
+// (within 5% of a +40% step after 24..43 bars on synthetic traces; the gated EMA
+// never re-converges after a jump beyond its band: test/test_bench_baseline_quantile).
+static constexpr bool     BASELINE_QUANTILE = true;
+static constexpr uint16_t BASELINE_QUANTILE_HORIZON = 32;      // bars
+static constexpr uint16_t BASELINE_QUANTILE_READY_BARS = 8;    // median is stable from ~4 bars
+static constexpr uint16_t BASELINE_READY_BARS =
+    BASELINE_QUANTILE ? BASELINE_QUANTILE_READY_BARS : BASELINE_MIN_QUALIFIED_BARS;
+
 static constexpr float BASELINE_MIN_RMS = 0.020f;            // blocks near-silence baseline learning
-static constexpr float KICK_PRESENT_KVAR_ABS_MIN = 0.0010f;  // pre-baseInited kick proxy
+static constexpr float KICK_PRESENT_KVAR_ABS_MIN = 0.0010f * ENV_DECIM_KVAR_SCALE;  // pre-baseInited kick proxy
 static constexpr float KICK_PRESENT_KR_MIN = 0.90f;          // for CAND detection (kick gone check)
 
 // Representative bands for baseline updates - prevents drift from outliers
 // Bar qualifies for update if: kR in band (mandatory) AND (rR in band OR tR in band)
+// (EMA baselines only; quantile baselines take every bar with signal and kick)
 static constexpr float BASELINE_UPDATE_KR_MIN = 0.90f;
 static constexpr float BASELINE_UPDATE_KR_MAX = 1.10f;
 static constexpr float BASELINE_UPDATE_RR_MIN = 0.90f;
@@ -132,6 +258,33 @@ static constexpr float RECOVERY_KR_MIN = 0.80f;
 
 static constexpr float CAND_RECOVERY_KR_MIN = 0.82f;
 
+// -------------- DECISION GRANULARITY --------------
+// false: CAND / BREAK / recovery decided once per bar in onBarFinalized(),
+//        i.e. up to one bar after the music changed.
+// true : decided on every MIDI beat over a rolling 4-beat (1-bar) window,
+//        same ratios and thresholds, with the consecutive-evaluation
+//        hysteresis of GATE_BEAT. STATE lines carry dec= and lat_ms= in both
+//        modes so the two can be compared on the same set.
+static constexpr bool DECIDE_PER_BEAT = true;
+
+struct DecisionGate {
+  uint8_t candEnter;          // consecutive evaluations: STD -> CAND
+  uint8_t deep;               // CAND -> BREAK
+  uint8_t recover;            // CAND -> STD and BREAK -> STD
+  uint8_t recoverMinEvals;    // evaluations in CAND before recovery is judged
+  uint8_t evalsPerBar;
+  const char* name;
+  const char* whyDeep;
+  const char* whyCandRecover;
+  const char* whyBreakRecover;
+};
+static constexpr DecisionGate GATE_BAR  = { 1, 2, 1, 1, 1, "bar",
+                                            "BREAK_CONFIRM_DEEP_2B", "CAND_RECOVER_BAR", "BREAK_RECOVER_BAR" };
+// Rolling windows overlap by 3 beats: 5 deep evaluations span the same
+// 8 beats of audio as 2 deep bars; 2 evaluations debounce the other edges.
+static constexpr DecisionGate GATE_BEAT = { 2, 5, 2, 4, 4, "beat",
+                                            "BREAK_CONFIRM_DEEP_5BT", "CAND_RECOVER_BEAT", "BREAK_RECOVER_BEAT" };
+
 // -------------- kMean 2D DETECTION (v9) --------------
 // kMeanR = barKMean / baseKMean  (kick band energy presence, robust to character changes)
 static constexpr float CAND_KMEANR_MAX     = 1.05f; // CAND entry blocked if kick band at/above baseline
@@ -160,17 +313,309 @@ static constexpr float   DROP_VERIFY_BF_K_MIN = 0.70f * KICK_RETURN_BF_MIN; // t
 
 static constexpr int DROP_BARS = 8;
 
+// -------------- BUILDUP PRE-ARM (include/buildup_detector.h) --------------
+// Return-Impact confirms a DROP only after the kick is back (225 ms + peaks).
+// In BREAK_CONFIRMED the buildup detector follows transient / hats / tilt
+// slopes; while it is armed the next phrase boundary is predicted as the DROP
+// downbeat: the phrase detector's 8-bar grid (16-bar phrases start on it too)
+// once it is trusted, else every BUILDUP_PHRASE_BARS from the first bar
+// without kick. Its scheduled beat is prepared as DROP, so the first DROP
+// frame lands on the bar start, and the tick enters DROP (DROP_PREARMED).
+// The post-DROP kick verification cancels it back to BREAK if the drop does
+// not come; the detector is paused (not reset) meanwhile, so its history
+// survives the cancel. A missed pre-arm holds off the boundaries of the next
+// BUILDUP_BACKOFF_BARS, doubled per miss in the same break.
+static constexpr bool    BUILDUP_PREARM_ENABLE = true;
+static constexpr uint8_t BUILDUP_PHRASE_BARS   = 4;
+static constexpr uint8_t BUILDUP_BACKOFF_BARS  = 8;
+static constexpr uint8_t BUILDUP_BACKOFF_MAX   = 3;    // misses counted: 8 / 16 / 32 bars
+
+// -------------- PHRASE BOUNDARIES (include/phrase_detector.h) --------------
+// The pattern engine's fixed 8-bar window drifts off the track's phrases as
+// soon as a state change restarts it or the DJ mixes in on an odd bar. Each
+// finalized bar feeds the phrase detector; on beat 4 of the bar before a
+// predicted phrase start the engine is told the coming downbeat starts a
+// phrase (pp_phraseStart). Strong novelty re-anchors the grid.
+static constexpr bool    PHRASE_ENABLE = true;
+
 // ---------------- MIDI (UART1 on GPIO34) ----------------
 HardwareSerial MidiSerial(1);
 
+static MidiParser midiParser;
 static bool midiRunning = false;
+static bool midiStopped = false;        // transport Stop (0xFC) until Start / Continue
+static bool skipBarFinalize = false;    // bar after Start / SPP is partial: do not finalize
 static uint8_t tickInBeat = 0;          // 0..23
 static uint32_t ticksSinceBeat = 0;
 
 static uint32_t barCount = 0;           // 1..N (display)
 static uint8_t  beatInBar = 0;          // 1..4 (display)
-static uint32_t lastBeatUs = 0;
-static uint32_t lastBeatIntervalUs = 500000; // default ~120bpm
+static uint8_t  gridSlot = 0;           // 0..15: 16th of the bar the last clock tick fell in
+
+// -------------- MIDI RX TIMESTAMPING --------------
+// Bytes are read by a UART RX event handler (HardwareSerial::onReceive, RX
+// FIFO threshold 1 byte) that stamps them on arrival and pushes them into a
+// wait-free ring; processMidi() drains it from the loop.
+// The stamp is micros() (64-bit system timer), not the CPU cycle counter:
+// CCOUNT is per core and the handler task is not pinned to the loop core.
+// MIDI_STAMP_AT_RX = false times ticks when the loop drains them instead
+// (the former polling behaviour, i.e. behind render and the loop wake).
+// MIDI_JITTER compares both timings of the same ticks every MIDI_JITTER_LOG_MS.
+static constexpr bool     MIDI_STAMP_AT_RX   = true;
+static constexpr uint16_t MIDI_RING_LEN      = 64;     // 20 ms of bytes at 31250 bps
+static constexpr uint32_t MIDI_JITTER_LOG_MS = 30000;
+
+struct MidiRxByte {
+  uint8_t  b;
+  uint32_t rxUs;          // micros() in the RX handler
+};
+static SpscRing<MidiRxByte, MIDI_RING_LEN> midiRing;
+
+// Clock tick interval statistics over one report period (exact integer sums)
+struct TickStats {
+  uint32_t n = 0;
+  uint64_t sum = 0, sumSq = 0;
+  uint32_t minUs = 0xFFFFFFFFu, maxUs = 0;
+
+  void reset() { n = 0; sum = sumSq = 0; minUs = 0xFFFFFFFFu; maxUs = 0; }
+  void add(uint32_t dtUs) {
+    sum += dtUs; sumSq += (uint64_t)dtUs * dtUs; n++;
+    if (dtUs < minUs) minUs = dtUs;
+    if (dtUs > maxUs) maxUs = dtUs;
+  }
+  float sd() const {
+    if (n < 2) return 0.0f;
+    const double mean = (double)sum / (double)n;
+    const double v = ((double)sumSq - (double)n * mean * mean) / (double)(n - 1);
+    return (v > 0.0) ? (float)sqrt(v) : 0.0f;
+  }
+};
+static TickStats jitRx, jitPoll;
+static bool      jitHavePrev = false;
+static uint32_t  jitPrevRxUs = 0, jitPrevPollUs = 0;
+static uint64_t  jitLagSum = 0;                        // poll - rx per tick
+static uint32_t  jitLagMax = 0;
+
+// Tick-interval statistics (clock_stats.h): CLOCK_STATS per minute, plus the
+// session totals with the jitter histogram (CLOCK_HIST) at party_stop().
+static constexpr uint32_t CLOCK_STATS_LOG_MS = 60000;
+static ClockStats clkMinute, clkSession;
+
+// -------------- EVENT LOOP --------------
+// party_tick() ends by blocking on a task notification instead of delay(1).
+// Producers set one bit each: the audio task after every DMA block, the MIDI
+// RX handler after every read, the button GPIO interrupt on any edge. With
+// no event the loop still wakes at the render deadline (LOOP_RENDER_US after
+// the previous tick) for BREAK fades, DROP shimmers, blinks and watchdogs.
+// After a button edge it polls every tick for LOOP_BTN_SETTLE_MS so the hw
+// debounce (consecutive reads + ghost hold) completes.
+// LOOP_EVENTS logs the wake-to-handle time per source every LOOP_EVENTS_LOG_MS:
+// audio = segment close -> drained, midi = byte RX -> parsed, btn = GPIO
+// edge -> loop awake, render = lateness past the deadline.
+// LOOP_EVENT_WAIT = false restores the fixed delay(1).
+static constexpr bool     LOOP_EVENT_WAIT    = true;
+static constexpr uint32_t LOOP_RENDER_US     = 4000;    // render / watchdog deadline (250 Hz)
+static constexpr uint32_t LOOP_BTN_SETTLE_MS = 40;      // > HW_BTN_CONSISTENT reads + ghost hold
+static constexpr uint32_t LOOP_EVENTS_LOG_MS = 30000;
+
+enum LoopEventSrc : uint8_t { LOOP_EV_AUDIO = 0, LOOP_EV_MIDI, LOOP_EV_BTN, LOOP_EV_RENDER, LOOP_EV_COUNT };
+
+struct EventLatency {
+  uint32_t n = 0, maxUs = 0;
+  uint64_t sum = 0;
+  void reset() { n = 0; maxUs = 0; sum = 0; }
+  void add(uint32_t us) { n++; sum += us; if (us > maxUs) maxUs = us; }
+  uint32_t meanUs() const { return (n > 0) ? (uint32_t)(sum / n) : 0; }
+};
+static EventLatency loopLat[LOOP_EV_COUNT];
+static uint32_t loopWakes = 0;
+static TaskHandle_t loopTaskHandle = nullptr;      // set by party_init(), cleared by party_stop()
+static volatile uint32_t btnEdgeUs = 0;            // first unhandled GPIO edge (0 = none)
+static uint32_t btnSettleUntilMs = 0;
+
+static inline void loopNotify(LoopEventSrc src) {
+  TaskHandle_t h = loopTaskHandle;
+  if (h != nullptr) xTaskNotify(h, 1u << src, eSetBits);
+}
+
+static void IRAM_ATTR btnEdgeIsr() {
+  if (btnEdgeUs == 0) btnEdgeUs = micros() | 1u;
+  TaskHandle_t h = loopTaskHandle;
+  if (h == nullptr) return;
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(h, 1u << LOOP_EV_BTN, eSetBits, &woken);
+  if (woken == pdTRUE) portYIELD_FROM_ISR();
+}
+
+// -------------- SCHEDULED BEAT COMMITS --------------
+// At tick BEAT_PREP_TICK the next beat is run ahead (pp_prepareBeat) into a
+// pending frame, and a one-shot esp_timer latches it to LEDC at the tracker's
+// predicted beat instant minus BEAT_COMMIT_LEAD_US (LED / perception latency
+// offset; 0 = on the beat). If the tick arrives first the loop latches it
+// itself. Falls back to committing on the tick when tempo confidence is low
+// or the lead time is too short. Until the latch the shown beat keeps
+// rendering. A context state decided on the tick that differs from the
+// prepared one runs the beat again (pp_reprepareBeat) before it is latched,
+// or right after if the timer was first.
+// The timer claims the frame (PENDING -> LATCHING), latches it and then
+// publishes FIRED; the loop never re-prepares, latches or drops a beat while
+// the state is LATCHING, it waits for FIRED (a few LEDC writes).
+// BEAT_COMMIT logs commit - tick arrival (RX stamp) every MIDI_JITTER_LOG_MS.
+static constexpr bool     BEAT_COMMIT_SCHEDULED = true;
+static constexpr uint8_t  BEAT_PREP_TICK        = 22;      // of 0..23: ~2 ticks of lead
+static constexpr int32_t  BEAT_COMMIT_LEAD_US   = 0;
+static constexpr uint32_t BEAT_PREP_MIN_LEAD_US = 2000;    // closer than this: commit on the tick
+static constexpr float    BEAT_PREP_MIN_CONF    = 0.5f;
+
+enum CommitState : uint8_t { COMMIT_IDLE = 0, COMMIT_PENDING, COMMIT_LATCHING, COMMIT_FIRED };
+static esp_timer_handle_t    beatCommitTimer = nullptr;
+static std::atomic<uint8_t>  beatCommitState{COMMIT_IDLE};
+static volatile uint32_t     beatCommitUs = 0;      // micros() of the last timer latch
+static uint32_t              beatCommitTargetUs = 0;
+static bool                  beatPrepared = false;  // pp already ran the upcoming beat
+static bool                  commitAfterTick = false;   // timer armed past its tick (audio offset > 0)
+static uint32_t              commitAfterTickUs = 0;     // that tick's RX stamp
+
+// -------------- AUDIO / MIDI OFFSET --------------
+// The mixer's MIDI clock and its audio reach us with different latencies.
+// BeatOffsetEstimator (beat_offset.h) cross-correlates LOW band onsets with
+// MIDI beats; once AUDIO_OFFSET_MIN_BARS of the last 16 bar estimates agree
+// within AUDIO_OFFSET_MAX_STD_US, the applied offset moves toward their mean
+// by AUDIO_OFFSET_GAIN per bar. Scheduled commits land at predicted beat +
+// offset - BEAT_COMMIT_LEAD_US, so LED hits follow the audible kick; beats
+// committed on the tick (fallback) cannot be shifted, and BEAT_COMMIT's
+// latch - tick error now centres on the offset. The applied offset is kept
+// in NVS (namespace "party") and reloaded on entry.
+// Usable range AUDIO_OFFSET_MIN_US .. AUDIO_OFFSET_LIMIT_US (-26 .. +90 ms).
+// Audio ahead of MIDI pulls the latch toward the prepare tick: the beat is
+// prepared 24 - BEAT_PREP_TICK ticks ahead (31 ms at BPM_RANGE_MAX), and the
+// latch must stay BEAT_PREP_MIN_LEAD_US plus AUDIO_OFFSET_PREP_MARGIN_US
+// (tick jitter, prepare latency) after it, or every beat would fall back to
+// committing on the tick. Offsets are clamped to that range.
+static constexpr bool     AUDIO_OFFSET_ENABLE        = true;
+static constexpr uint8_t  AUDIO_OFFSET_MIN_BARS      = 8;
+static constexpr uint32_t AUDIO_OFFSET_MAX_STD_US    = 8000;
+static constexpr float    AUDIO_OFFSET_GAIN          = 0.25f;
+static constexpr int32_t  AUDIO_OFFSET_LIMIT_US      = 90000;    // inside the estimator window
+static constexpr uint32_t AUDIO_OFFSET_PREP_MARGIN_US = 3000;
+static constexpr uint32_t AUDIO_OFFSET_SAVE_DELTA_US = 2000;     // NVS write only on real change
+static constexpr uint32_t AUDIO_OFFSET_SAVE_MIN_MS   = 60000;    // and at most once a minute
+static constexpr uint32_t AUDIO_OFFSET_LOG_MS        = 30000;
+static constexpr const char* NVS_NAMESPACE           = "party";
+static constexpr const char* NVS_KEY_AUDIO_OFFSET    = "audOffUs";
+
+// -------------- DEFERRED NVS WRITES --------------
+// An NVS write (flash program / erase) stalls the flash cache on both cores
+// for milliseconds, so none is made on the beat path: writers mark their
+// data dirty and nvsIdleService() saves it from party_tick() while no beat
+// frame is prepared or pending and the MIDI clock is NVS_IDLE_TICK_FIRST ..
+// NVS_IDLE_TICK_LAST ticks into the beat, clear of the beat, half-beat
+// (12) and prepare (BEAT_PREP_TICK) work. party_stop() saves whatever is
+// still dirty.
+static constexpr uint8_t  NVS_IDLE_TICK_FIRST = 2;
+static constexpr uint8_t  NVS_IDLE_TICK_LAST  = 10;
+
+// -------------- BASELINE PROFILES (NVS, include/base_profile.h) --------------
+// Learned baselines (with the break floor as a ratio to them) are kept per
+// key = (BPM band, level band) in BASE_PROFILE_SLOTS slots of one NVS blob.
+// There is no input gain setting on this board, so the gain part of the key is
+// the groove rms itself in half-octave bands (mixer rec/booth gain moves it).
+// On the first qualified bar after entry or a hard reset the nearest profile
+// (|dBPM band| + |dlevel band| <= BASE_PROFILE_MAX_DIST) seeds the baselines;
+// BASE_PROFILE_CONFIRM_BARS qualified bars in a row must then sit within the
+// confirm band of it (rR and kR) before BASELINE_READY, one miss drops the
+// warm start and learning restarts cold from that bar.
+// A slot is refreshed in RAM once its key has held for a full quantile
+// horizon; the blob is written by nvsIdleService() at most every
+// BASE_PROFILE_SAVE_MIN_MS and only after a real change (plus on exit). NVS
+// itself spreads the rewrites over its pages (log-structured entries), so
+// this batching is all the wear control the flash needs.
+// The blob carries a magic, the BaseProfile layout version and a CRC-32;
+// a blob failing any of them (old layout, torn write) is dropped on load
+// and learning starts cold. Bump BASE_PROFILE_VERSION with the struct.
+static constexpr bool     BASE_PROFILE_ENABLE       = true;
+static constexpr uint8_t  BASE_PROFILE_SLOTS        = 8;
+static constexpr float    BASE_PROFILE_BPM_BAND     = 6.0f;
+static constexpr float    BASE_PROFILE_LEVEL_STEPS  = 2.0f;     // level bands per octave of rms
+static constexpr int      BASE_PROFILE_MAX_DIST     = 2;
+static constexpr float    BASE_PROFILE_SEED_BARS    = 8.0f;     // weight of the profile in the medians
+static constexpr uint8_t  BASE_PROFILE_CONFIRM_BARS = 2;
+static constexpr float    BASE_PROFILE_CONFIRM_MIN  = 0.67f;
+static constexpr float    BASE_PROFILE_CONFIRM_MAX  = 1.50f;
+static constexpr uint16_t BASE_PROFILE_HOLD_BARS    = 32;       // key stable this long before a refresh
+static constexpr float    BASE_PROFILE_SAVE_DELTA   = 0.10f;    // relative change that dirties a slot
+static constexpr uint32_t BASE_PROFILE_SAVE_MIN_MS  = 300000;
+static constexpr const char* NVS_KEY_BASE_PROFILES  = "baseProf";
+static constexpr uint32_t BASE_PROFILE_MAGIC        = 0x46505342u;   // "BSPF"
+static constexpr uint16_t BASE_PROFILE_VERSION      = 1;
+
+struct BaseProfileBlob {
+  uint32_t    magic;
+  uint16_t    version;
+  uint16_t    slots;
+  BaseProfile slot[BASE_PROFILE_SLOTS];
+  uint32_t    crc;                            // over everything above
+};
+
+static BaseProfile baseProfiles[BASE_PROFILE_SLOTS];
+static BaseProfileBlob baseProfileBlob;       // NVS image, built / checked outside the beat path
+static bool     baseProfilesDirty = false;
+static uint32_t baseProfilesSavedMs = 0;
+static uint32_t baseProfileSeq = 0;
+static int8_t   warmSlot = -1;                // profile under confirmation / confirmed
+static uint8_t  warmConfirmBars = 0;
+static bool     warmPending = false;
+static int8_t   profKeySlot = -1;             // slot matching the current key
+static uint8_t  profKeyBpm = 0;
+static int8_t   profKeyLevel = 0;
+static uint16_t profKeyBars = 0;
+static bool     profBfValid = false;          // break floor ratios of this session and key
+static float    profBfRms = 0.0f, profBfTr = 0.0f, profBfKVar = 0.0f;
+static uint32_t baselineStartMs = 0;          // learning (re)start, for the ready latency
+
+// -------------- WARM RESUME (RTC) --------------
+// Party state goes into the RTC snapshot (rtc_resume.h) at every downbeat.
+// After an unintended reset main.cpp re-enters party mode directly and
+// party_init() restores it without the splash: baselines (ready at once, the
+// snapshot is seconds old), the break floor (BREAK_CONFIRMED resumes as such,
+// other states as STANDARD), the tempo, the pattern engine position and the
+// bar phase. The RTC timer runs through the reset, so the first MIDI clock is
+// placed at the tick count since the snapshot's downbeat, provided that
+// downbeat is at most RESUME_PHASE_MAX_MS old.
+static constexpr bool     RESUME_ENABLE       = true;
+static constexpr uint32_t RESUME_PHASE_MAX_MS = 4000;
+
+struct PartyResumeSnap {
+  uint64_t rtcBeatUs;                 // RTC time of the downbeat
+  uint32_t barCount;
+  uint32_t periodUs;
+  uint8_t  beatInBar;
+  uint8_t  state;                     // ContextState
+  uint8_t  baseOk, breakOk;
+  float    baseRms, baseTr, baseKVar, baseKMean;
+  float    bandE[BAND_COUNT], bandV[BAND_COUNT];
+  float    breakRms, breakTr, breakKVar;
+  PatternSnapshot pat;
+};
+static_assert(sizeof(PartyResumeSnap) <= RESUME_PAYLOAD_MAX, "party snapshot too large for RTC slot");
+
+static PartyResumeSnap resumeSnap;
+static bool     resumed = false;              // this session started from a snapshot
+static bool     resumePhasePending = false;   // first MIDI clock still to be placed
+static bool     firstVisualsLogged = false;
+static uint32_t partyEntryMs = 0;
+
+static BeatOffsetEstimator offsetEst((uint32_t)((uint64_t)ONSET_HOP * 1000000ULL / I2S_SAMPLE_RATE));
+static int32_t  audioOffsetUs = 0;          // applied (> 0: audio after MIDI)
+static int32_t  audioOffsetSavedUs = 0;
+static uint32_t audioOffsetSavedMs = 0;
+static bool     audioOffsetDirty = false;   // saved by nvsIdleService()
+
+// Commit error (latch - tick) over one report period
+static uint32_t commitN = 0, commitFallback = 0, commitTickFirst = 0, commitReprepared = 0;
+static int64_t  commitErrSum = 0;
+static uint64_t commitErrSq = 0;
+static int32_t  commitErrMin = 0, commitErrMax = 0;
 
 // -------------- TEMPO INTEGRITY GUARD (req 12.3.1) --------------
 // Protects visual timing against erratic MIDI clock during BREAK sections.
@@ -183,11 +628,27 @@ static constexpr uint8_t CLOCK_HOLD_RESUME_BEATS = 8;     // consecutive stable
 // -------------- BPM RANGE + SPIKE GUARDS (D1 / D2) --------------
 // D1: reject any beat whose smoothed BPM lands outside the expected DJ range.
 // D2: reject a single-beat spike larger than BPM_SPIKE_MAX regardless of state.
-// Both guards fire before CLOCK_HOLD; lastBeatIntervalUs is left unchanged on reject.
+// Both guards fire before CLOCK_HOLD; the tempo period is left unchanged on reject.
 static constexpr float BPM_RANGE_MIN = 80.0f;   // D1: below this = corrupt clock
 static constexpr float BPM_RANGE_MAX = 160.0f;  // D1: above this = corrupt clock
 static constexpr float BPM_SPIKE_MAX = 20.0f;   // D2: max single-beat delta (BPM)
 
+// -------------- TEMPO TRACKER (PLL, include/tempo_tracker.h) --------------
+// BETA = 0.15 keeps the former 0.85 / 0.15 period IIR; ALPHA < 1 smooths the
+// beat phase behind predictedNextBeatUs(). D1 / D2 run inside the tracker,
+// CLOCK_HOLD is its accept hook (clockHoldAccept). Independent of logging.
+static constexpr float    TEMPO_PLL_ALPHA     = 0.5f;
+static constexpr float    TEMPO_PLL_BETA      = 0.15f;
+static constexpr float    TEMPO_CONF_ERR_FULL = 0.10f;   // mean |phase err| of 10% of a beat -> conf 0
+static constexpr uint8_t  TEMPO_LOCK_BEATS    = 8;
+static constexpr uint32_t TEMPO_INIT_PERIOD_US = 500000; // default ~120bpm
+
+static const TempoTracker::Config TEMPO_CFG = {
+  TEMPO_PLL_ALPHA, TEMPO_PLL_BETA, BPM_RANGE_MIN, BPM_RANGE_MAX, BPM_SPIKE_MAX,
+  TEMPO_CONF_ERR_FULL, TEMPO_LOCK_BEATS
+};
+static TempoTracker tempo(TEMPO_CFG, TEMPO_INIT_PERIOD_US);
+
 static bool     clockHoldActive      = false;
 static uint32_t bpmHoldIntervalUs    = 0;   // frozen timing reference (us/beat)
 static uint8_t  clockHoldStableBeats = 0;   // consecutive beats stable toward release
@@ -198,18 +659,181 @@ static volatile uint8_t  curBeatForEvents = 0;
 
 
 // ---------------- I2S accumulators ----------------
-static uint32_t barN = 0, winN = 0;
-static double barSumSq = 0.0, barTrSum = 0.0;
-static double winSumSq = 0.0, winTrSum = 0.0;
-static Welford barKickW, winKickW;
+// Two-level hierarchy: samples feed only winAcc. Each closed window is merged
+// into barAcc; finalizeBarNow() merges the partial window up to the downbeat
+// (its exact frame with BAR_SPLIT_ENABLE, see BAR SPLIT below).
+// winBarMark is the part of the current window already merged into the bar.
+// Both levels live on the loop core; samples arrive as AudioSegments from the
+// audio task (see AUDIO TASK below).
+static FeatureAcc barAcc, winAcc;
+static FeatureAcc winBarMark;
+
+// Per-segment stand-in when DEBUG_ACC_SHADOW is off: no state, no copies
+struct NoShadowAcc {
+  void reset() {}
+  void update(float, float) {}
+  void updateEnv(float) {}
+};
 
-// filter states
-static float envLP = 0.0f;
-static float hp_y = 0.0f;
-static float hp_x_prev = 0.0f;
+// Legacy double path, only fed when DEBUG_ACC_SHADOW is on
+struct ShadowAcc {
+  uint32_t n = 0;
+  double sumSq = 0.0, trSum = 0.0;
+  Welford kickW;
+  void reset() { n = 0; sumSq = 0.0; trSum = 0.0; kickW.reset(); }
+  void update(float x, float trAx) {
+    sumSq += (double)(x * x);
+    trSum += (double)trAx;
+    n++;
+  }
+  void updateEnv(float env) { kickW.update((double)env); }
+  void merge(const ShadowAcc& o) { n += o.n; sumSq += o.sumSq; trSum += o.trSum; kickW.merge(o.kickW); }
+  void merge(const NoShadowAcc&) {}
+  float rms() const { return (n > 0) ? sqrtf((float)(sumSq / (double)n)) : 0.0f; }
+  float tr()  const { return (n > 0) ? (float)(trSum / (double)n) : 0.0f; }
+};
+static ShadowAcc barShadow, winShadow;
+typedef std::conditional<DEBUG_ACC_SHADOW, ShadowAcc, NoShadowAcc>::type SegShadowAcc;
+static float shadowWinMaxErr = 0.0f;   // worst window deviation since last bar log
+
+// Filter-bank levels, merged exactly like barAcc / winAcc / winBarMark
+static BankAcc barBank, winBank;
+static BankAcc winBankMark;
+static OnsetAcc winOnset;   // window level only
+
+// 16th-note grid: one FeatureAcc per 16th of the bar (6 MIDI ticks). Every
+// segment carries the audio time of its middle frame (SampleClock), and the
+// loop core merges it into the 16th that time falls in: the marks below hold
+// when the recent 16ths began (the stamp of the clock tick that opened each,
+// or the audio clock's beat), and a segment past the newest mark is placed by
+// the tempo period from it (its tick may still be in the MIDI ring). So the
+// attribution does not depend on when the loop drains the ring; a segment is
+// at most one DMA block (5.3 ms) long against a 16th of ~120 ms at 125 BPM,
+// and the per-sample cost stays zero. Snapshotted at bar finalize.
+static constexpr uint8_t GRID_SLOTS = 16;
+static constexpr uint8_t GRID_TICKS_PER_SLOT = 24 / 4;
+static constexpr uint8_t GRID_MARKS = 8;   // two beats of 16ths: covers the ring's backlog
+static FeatureAcc gridAcc[GRID_SLOTS];
+
+struct GridMark { uint32_t us; uint8_t slot; };
+static GridMark gridMarks[GRID_MARKS];
+static uint8_t  gridMarkN = 0, gridMarkPos = 0;
+
+static void gridMarkReset() { gridMarkN = gridMarkPos = 0; }
+
+static void gridMarkAdd(uint32_t us, uint8_t slot) {
+  gridMarks[gridMarkPos] = { us, slot };
+  gridMarkPos = (uint8_t)((gridMarkPos + 1) % GRID_MARKS);
+  if (gridMarkN < GRID_MARKS) gridMarkN++;
+}
+
+// 16th of audio time tUs: the newest mark at or before it, plus whole 16ths
+// of the tempo period past that mark (at most to the end of its beat)
+static uint8_t gridSlotAt(uint32_t tUs) {
+  if (gridMarkN == 0) return 0;
+  const GridMark* m = nullptr;
+  for (uint8_t k = 1; k <= gridMarkN; k++) {                      // newest first
+    const GridMark& c = gridMarks[(gridMarkPos + GRID_MARKS - k) % GRID_MARKS];
+    m = &c;
+    if ((int32_t)(tUs - c.us) >= 0) break;                          // else: older than every mark, oldest
+  }
+  const uint32_t per = tempo.periodUs();
+  const int32_t  dt = (int32_t)(tUs - m->us);
+  uint32_t q = (per > 0 && dt > 0) ? (uint32_t)((uint64_t)dt * 4u / per) : 0;
+  const uint32_t toBeatEnd = 3u - (uint32_t)(m->slot % 4);
+  if (q > toBeatEnd) q = toBeatEnd;
+  return (uint8_t)(m->slot + q);
+}
+
+struct GridSnapshot {
+  float rms[GRID_SLOTS];
+  float tr[GRID_SLOTS];
+  float kick[GRID_SLOTS];   // kMean per slot (kick envelope level)
+  float fourOnFloor;        // mean kick on the quarter slots / mean kick on the others
+};
+static GridSnapshot lastGrid = {};
+
+// Finalized per-band features handed to the policy
+struct BandFeatures {
+  float energy[BAND_COUNT];
+  float var[BAND_COUNT];
+};
+static BandFeatures bankFeatures(const BankAcc& a) {
+  BandFeatures f;
+  for (uint8_t b = 0; b < BAND_COUNT; b++) { f.energy[b] = a.band[b].energy(); f.var[b] = a.band[b].var(); }
+  return f;
+}
+
+// ---------------- AUDIO TASK (core 0) ----------------
+// I2S reads and per-sample feature extraction run in a task pinned to core 0,
+// so a slow DMA buffer can no longer hold up MIDI handling or LED commits on
+// the loop core. The task publishes AudioSegments through a wait-free SPSC ring:
+// one per DMA read, plus one ending exactly at each 75 ms window boundary.
+// The loop core merges segments into the window / bar accumulators, so
+// onMonitorWindow() and finalizeBarNow() see the same inputs as before.
+static constexpr uint32_t AUDIO_TASK_STACK    = 4096;
+static constexpr UBaseType_t AUDIO_TASK_PRIO  = 5;     // above loop (1), below esp_timer (22)
+static constexpr BaseType_t  AUDIO_TASK_CORE  = 0;
+static constexpr uint16_t AUDIO_RING_LEN      = 32;    // ~160 ms of DMA reads
+static constexpr uint32_t AUDIO_RING_LOG_MS   = 30000; // AUDIO_RING status interval
+
+struct AudioSegment {
+  FeatureAcc acc;        // samples since the previous segment
+  BankAcc    bank;       // filter-bank bands over the same samples
+  OnsetAcc   onset;      // spectral-flux hops completed in the segment
+  AudioBeatEvent beat;   // beat tracker event in the segment (kind NONE if none)
+  uint32_t   beatUs;     // micros() of that event (audio time, not processing time)
+  uint32_t   hopUs;      // audio time (micros()) of the onset hop, when onset.frames == 1
+  uint32_t   midUs;      // audio time of the segment's middle frame (16th attribution)
+  uint32_t   endUs;      // micros() when the segment was closed
+  uint32_t   epoch;      // audioEpoch at capture; stale epochs are dropped
+  bool       winEnd;     // true: closes a WIN_SAMPLES monitor window
+  SegShadowAcc shadow;   // DEBUG_ACC_SHADOW only (empty otherwise, sits in winEnd's padding)
+  uint32_t   barSplit;   // barSplitSeq of the bar boundary this segment ends at (0 = none)
+  uint32_t   splitLateUs;// boundary frame was already consumed: split this much after it
+};
+
+// One onset hop (and so at most one tracker event) per segment
+static_assert(I2S_READ_FRAMES <= ONSET_HOP, "AudioSegment carries a single onset hop");
+
+static SpscRing<AudioSegment, AUDIO_RING_LEN> audioRing;
+static TaskHandle_t audioTaskHandle = nullptr;
+static volatile bool audioTaskRun = false;
+// Guards audioTaskHandle at exit: whichever side clears it owns the delete
+static portMUX_TYPE audioTaskMux = portMUX_INITIALIZER_UNLOCKED;
+// Bumped by the loop core to request a filter-state reset; the task applies it
+// before its next read and tags segments with it.
+static std::atomic<uint32_t> audioEpoch{0};
+// Bar boundary request: the loop stores the downbeat stamp, then bumps the
+// sequence; the task closes a segment at the frame captured at that stamp.
+static std::atomic<uint32_t> barSplitUs{0};
+static std::atomic<uint32_t> barSplitSeq{0};
+
+// I2S driver event queue + DMA accounting (written by the audio task only)
+static QueueHandle_t i2sEventQueue = nullptr;
+static volatile uint32_t i2sDmaBlocks   = 0;  // descriptors read
+static volatile uint32_t i2sDmaDropped  = 0;  // RX_Q_OVF: driver overwrote an unread descriptor
+static volatile uint32_t i2sDmaErrors   = 0;  // DMA_ERROR events
+static volatile uint32_t i2sShortReads  = 0;  // read returned less than a full descriptor
+static volatile uint32_t i2sBacklog     = 0;  // descriptors read with a newer one already waiting
+
+// Frame counter -> micros() timebase (audio task only, include/sample_clock.h)
+static SampleClock sampleClock(I2S_SAMPLE_RATE);
+static uint64_t    segStartFrame = 0;   // first frame of the open segment
+
+// filter states (audio task only)
+static CicDecimator3<ENV_DECIM> envDecim;
+static KickEnvLP   envLP;
+static TransientHP trHP;
+static FilterBank<BankSample, I2S_SAMPLE_RATE, ENV_DECIM> bank;
+
+// DEBUG_AUDIO_CYCLES: per-block EMA of cycles per sample (audio task writes)
+static volatile float audioCycPerSample = 0.0f, bankCycPerSample = 0.0f, onsetCycPerHop = 0.0f;
 
 // ---- Latest I2S snapshots for logging ----
 static volatile float lastWinRms = 0.0f, lastWinTr = 0.0f, lastWinKVar = 0.0f;
+static volatile float lastWinOnset = 0.0f;                 // mean flux per hop, all bands
+static volatile float lastWinOnsetBand[ONSET_BANDS] = {};
 static volatile uint32_t lastWinUs = 0;
 
 static volatile float lastBarRms = 0.0f, lastBarTr = 0.0f, lastBarKVar = 0.0f, lastBarKMean = 0.0f;
@@ -219,27 +843,56 @@ static volatile uint32_t lastBarUs = 0;
 static volatile float last_rR = 0.0f, last_tR = 0.0f, last_kR = 0.0f;
 static volatile float last_bfR = 0.0f, last_bfT = 0.0f, last_bfK = 0.0f;
 static volatile bool  last_hasBF = false;
+static volatile float last_kbR = 0.0f, last_bdR = 0.0f, last_hhR = 0.0f;   // bank ratios
 static volatile ContextState last_stateForBar = STANDARD;
+static volatile float last_intensity = -1.0f;   // < 0: no baseline yet (patterns use fixed caps)
 
 // ---------------- Party Mode globals ----------------
 static bool baseInited = false;
 static float baseRms = 0.0f, baseTr = 0.0f, baseKVar = 0.0f, baseKMean = 0.0f;
+static BandFeatures baseBand = {};   // bank baseline, updated with the one above
+
+// quantile state behind the base* values (BASELINE_QUANTILE)
+static QuantileHist qBaseRms, qBaseTr, qBaseKVar, qBaseKMean;
+static QuantileHist qBaseBandE[BAND_COUNT], qBaseBandV[BAND_COUNT];
+
+// legacy EMA baseline kept for comparison (DEBUG_BASELINE_SHADOW)
+static bool  emaInited = false;
+static uint16_t emaQualifiedBars = 0;
+static float emaRms = 0.0f, emaTr = 0.0f, emaKVar = 0.0f, emaKMean = 0.0f;
 
 // baseline readiness tracking
 static bool baselineReady = false;
 static uint16_t baselineQualifiedBars = 0;
 
 static bool breakInited = false;
+static bool breakSeeded = false;   // floor taken from a profile until the first BREAK bar
 static float breakRms = 0.0f, breakTr = 0.0f, breakKVar = 0.0f;
+// Intensity mapping, cached by intensityRefresh()
+static float intensityKRms = 0.0f, intensityKTr = 0.0f, intensityKKick = 0.0f;   // weight / baseline
+static float intensityLoGain = 0.0f, intensityLoOff = 0.0f;   // level <= 1: gain * level + off
 
 static ContextState state = STANDARD;
 
-// CAND tracking
-static uint32_t candEnterBar = 0;
+// CAND tracking (streaks count evaluations: bars or beats, see DECIDE_PER_BEAT)
+static uint8_t candEvals = 0;                // evaluations since CAND entry (0 = entry)
+static uint8_t candEnterStreak = 0;          // consecutive kick-absent evaluations in STD
 
 // Recovery tracking
-static uint8_t breakRecoveryBars = 0;        // policy wants 1
-static uint8_t candDeepStreak = 0;           // consecutive deep bars while in CAND
+static uint8_t breakRecoverStreak = 0;       // consecutive recover evaluations in BREAK
+static uint8_t candRecoverStreak = 0;        // consecutive recover evaluations in CAND
+static uint8_t candDeepStreak = 0;           // consecutive deep evaluations while in CAND
+
+// Decision latency: micros() of the first beat whose rolling window met each
+// transition's condition (0 = not met). Probed every beat in both modes.
+enum DecisionEvidence : uint8_t { EV_CAND_ENTER = 0, EV_DEEP, EV_CAND_RECOVER, EV_BREAK_RECOVER, EV_COUNT };
+static uint32_t evidenceSinceUs[EV_COUNT] = {};
+
+// Rolling 4-beat window: one FeatureAcc per closed beat (beatAcc <- winAcc via winBeatMark)
+static constexpr uint8_t ROLL_BEATS = 4;
+static FeatureAcc beatAcc, winBeatMark;
+static FeatureAcc beatRing[ROLL_BEATS];
+static uint8_t beatRingIdx = 0, beatRingFill = 0;
 static uint8_t stdKickGoneWinStreak = 0;     // only used while in STD
 
 // Rolling kR / bKVar history for CAND entry context logging (last 4 bars)
@@ -255,6 +908,7 @@ static uint8_t kickLostStreak = 0;
 static uint8_t returnBudget = 0;
 
 static float peak_bfR = 0.0f, peak_bfT = 0.0f, peak_bfK = 0.0f;
+static float peak_kbR = 0.0f;   // kick-band variance vs baseline, peak in return window
 
 // -------------- v8.1 Post-DROP verification --------------
 static bool dropVerifyActive = false;
@@ -265,6 +919,19 @@ static uint8_t dropVerifyGood = 0;
 static uint32_t dropOnsetBarStart = 0;
 static uint32_t dropEndBar = 0;
 
+// Buildup pre-arm
+static BuildupDetector buildup;
+static uint32_t kickGoneBar = 0;             // position where the STD kick-gone streak began
+static uint8_t  kickGoneBeat = 0;
+static uint32_t breakAnchorBar = 0;          // first bar without kick: phrase grid origin (0 = unknown)
+static uint32_t dropPrearmBar = 0;           // bar whose downbeat is prepared as DROP (0 = none)
+static bool     dropPrearmed = false;        // DROP entered by pre-arm, verification running
+static uint8_t  prearmMisses = 0;            // pre-armed DROPs cancelled in this break
+static uint32_t prearmHoldBar = 0;           // no pre-arm on boundaries up to this bar
+
+// Phrase boundaries
+static PhraseDetector phrase;
+
 // ---------------- FAILURE / MUSIC-STOP tracking ----------------
 static SystemMode sysMode = SYS_OK;
 static FailReason failReason = FAIL_NONE;
@@ -285,19 +952,55 @@ static constexpr uint32_t AUDIO_LOSS_US = 1500000;     // 1.5s
 static constexpr uint32_t STOP_COINCIDE_US = 1000000;  // 1.0s window
 static constexpr float    AUDIO_PRESENT_MIN_RMS = 0.004f;
 
+// -------------- AUDIO CLOCK (policy) --------------
+// Without a MIDI clock the audio beat tracker drives onMidiBeat() /
+// onMidiHalfBeat(). It takes the grid once AUDIO_CLOCK_LOCK_BEATS beats in a
+// row reach CONF_ON: from the GREEN wait, or instead of FAIL_CLOCK_LOST when
+// the MIDI clock drops. It gives it back after AUDIO_CLOCK_DROP_BEATS beats
+// below CONF_OFF, on audio loss (MUSIC_STOP) or at the first MIDI clock tick:
+// MIDI always wins.
+static constexpr float    AUDIO_CLOCK_CONF_ON    = 0.45f;
+static constexpr float    AUDIO_CLOCK_CONF_OFF   = 0.30f;
+static constexpr uint8_t  AUDIO_CLOCK_LOCK_BEATS = 8;
+static constexpr uint8_t  AUDIO_CLOCK_DROP_BEATS = 8;
+static constexpr uint32_t AUDIO_CLOCK_LOSS_US    = 2000000;  // no tracker beat at all (I2S stalled)
+static constexpr uint32_t AUDIO_BEAT_LOG_MS      = 30000;    // AUDIO_BEAT status interval
+
+static bool     audioClock = false;          // tracker currently drives the beat grid
+static uint8_t  audioBeatStreak = 0;         // consecutive tracker beats >= CONF_ON
+static uint8_t  audioBeatLowStreak = 0;      // consecutive tracker beats <  CONF_OFF
+static uint32_t lastAudioBeatUs = 0;
+static float    audioBeatBpm = 0.0f, audioBeatConf = 0.0f;
+
 // ---------------- Accumulator resets ----------------
 static void resetBarAcc() {
-  barN = 0;
-  barSumSq = 0.0;
-  barTrSum = 0.0;
-  barKickW.reset();
+  barAcc.reset();
+  barBank.reset();
+  for (uint8_t i = 0; i < GRID_SLOTS; i++) gridAcc[i].reset();
+  if (DEBUG_ACC_SHADOW) barShadow.reset();
+}
+
+static void resetBeatRing() {
+  beatAcc.reset();
+  for (uint8_t i = 0; i < ROLL_BEATS; i++) beatRing[i].reset();
+  beatRingIdx = beatRingFill = 0;
 }
 
 static void resetWinAcc() {
-  winN = 0;
-  winSumSq = 0.0;
-  winTrSum = 0.0;
-  winKickW.reset();
+  winAcc.reset();
+  winBarMark.reset();
+  winBeatMark.reset();
+  winBank.reset();
+  winBankMark.reset();
+  winOnset.reset();
+  if (DEBUG_ACC_SHADOW) winShadow.reset();
+}
+
+// Relative deviation of the fixed-point result vs the double reference
+static float shadowErr(float fx, float ref) {
+  const float d = fabsf(fx - ref);
+  if (d <= FA_SHADOW_ABS_TOL) return 0.0f;
+  return d / (fabsf(ref) + 1e-12f);
 }
 
 // ---------------- Logging helpers ----------------
@@ -308,6 +1011,19 @@ static void logTransition(ContextState from, ContextState to, const char* why) {
                 (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, why);
 }
 
+// Policy transition with decision mode and latency since the first beat of evidence
+static void logDecision(ContextState from, ContextState to, const char* why,
+                        DecisionEvidence ev, const DecisionGate& g) {
+  if (from == to) return;
+  const uint32_t since = evidenceSinceUs[ev];
+  const uint32_t latMs = (since == 0) ? 0 : (uint32_t)((micros() - since) / 1000);
+  Serial.printf("STATE %s->%s pos=%lu.%u why=%s dec=%s lat_ms=%lu\n",
+                ctxName(from), ctxName(to),
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, why,
+                g.name, (unsigned long)latMs);
+  for (uint8_t i = 0; i < EV_COUNT; i++) evidenceSinceUs[i] = 0;
+}
+
 static void logEvent(const char* e) {
   Serial.printf("EVENT %s pos=%lu.%u\n",
                 e, (unsigned long)curBarForEvents, (unsigned)curBeatForEvents);
@@ -315,8 +1031,7 @@ static void logEvent(const char* e) {
 
 // ---------------- BPM helper (used by failure-overlay logs) ----------------
 static float currentBPM() {
-  if (lastBeatIntervalUs == 0) return 0.0f;
-  return 60000000.0f / (float)lastBeatIntervalUs;
+  return tempo.bpm();
 }
 
 // PatternID enum is defined in party_patterns.h
@@ -372,16 +1087,319 @@ static void resetForHardReset();   // clears baseline
 static void resetForResumeLike();  // keeps baseline
 
 // ---------------- Party Mode helpers ----------------
-static void baselineInit(float rms, float tr, float kVar, float kMean) {
+// ---------------- Intensity mapping ----------------
+static float intensityLevel(float rms, float tr, float kVar) {
+  return intensityKRms * rms + intensityKTr * tr +
+         fminf(intensityKKick * kVar, INTENSITY_W_KICK * INTENSITY_TOP_LEVEL);
+}
+
+// Baseline or break floor moved: re-derive the per-window factors here
+// rather than dividing in every monitor window
+static void intensityRefresh() {
+  intensityKRms  = INTENSITY_W_RMS  / (baseRms  + 1e-9f);
+  intensityKTr   = INTENSITY_W_TR   / (baseTr   + 1e-9f);
+  intensityKKick = INTENSITY_W_KICK / (baseKVar + 1e-9f);
+  const float floorL = breakInited ? fminf(intensityLevel(breakRms, breakTr, breakKVar), 0.9f)
+                                   : INTENSITY_FLOOR_LEVEL;
+  intensityLoGain = PP_INTENSITY_AT_BASE / (1.0f - floorL);
+  intensityLoOff  = -floorL * intensityLoGain;
+}
+
+static void baselineInit(float rms, float tr, float kVar, float kMean, const BandFeatures& bands) {
+  baseRms = rms; baseTr = tr; baseKVar = kVar; baseKMean = kMean;
+  baseBand = bands;
+  baseInited = true;
+  intensityRefresh();
+  Serial.printf("BASE_INIT rms=%.4f tr=%.6f kVar=%.8f kMean=%.6f kbV=%.8f bdE=%.6f hhE=%.6f pos=%lu.%u\n",
+                rms, tr, kVar, kMean,
+                bands.var[BAND_KICK], bands.energy[BAND_BODY], bands.energy[BAND_HATS],
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents);
+}
+
+// Filter-bank ratios vs baseline: kick-band impulsiveness (kbR), body energy
+// (bdR) and hat energy (hhR). Zero until the baseline exists.
+static void bankRatios(const BandFeatures& f, float* kbR, float* bdR, float* hhR) {
+  if (!baseInited) { *kbR = *bdR = *hhR = 0.0f; return; }
+  *kbR = safeDiv(f.var[BAND_KICK],    baseBand.var[BAND_KICK]);
+  *bdR = safeDiv(f.energy[BAND_BODY], baseBand.energy[BAND_BODY]);
+  *hhR = safeDiv(f.energy[BAND_HATS], baseBand.energy[BAND_HATS]);
+}
+
+static void baselineQuantileReset() {
+  qBaseRms.reset(BASELINE_QUANTILE_HORIZON);
+  qBaseTr.reset(BASELINE_QUANTILE_HORIZON);
+  qBaseKVar.reset(BASELINE_QUANTILE_HORIZON);
+  qBaseKMean.reset(BASELINE_QUANTILE_HORIZON);
+  for (uint8_t b = 0; b < BAND_COUNT; b++) {
+    qBaseBandE[b].reset(BASELINE_QUANTILE_HORIZON);
+    qBaseBandV[b].reset(BASELINE_QUANTILE_HORIZON);
+  }
+  emaInited = false;
+  emaQualifiedBars = 0;
+  emaRms = emaTr = emaKVar = emaKMean = 0.0f;
+}
+
+// One qualified bar into the quantile state; base* become the medians.
+static void baselineQuantileAdd(float rms, float tr, float kVar, float kMean, const BandFeatures& bands) {
+  qBaseRms.add(rms);     baseRms   = qBaseRms.median();
+  qBaseTr.add(tr);       baseTr    = qBaseTr.median();
+  qBaseKVar.add(kVar);   baseKVar  = qBaseKVar.median();
+  qBaseKMean.add(kMean); baseKMean = qBaseKMean.median();
+  for (uint8_t b = 0; b < BAND_COUNT; b++) {
+    qBaseBandE[b].add(bands.energy[b]); baseBand.energy[b] = qBaseBandE[b].median();
+    qBaseBandV[b].add(bands.var[b]);    baseBand.var[b]    = qBaseBandV[b].median();
+  }
+}
+
+// Legacy EMA baseline with its own readiness and band gate, fed the bars the
+// quantile baseline takes; logs both side by side (DEBUG_BASELINE_SHADOW).
+static void baselineShadowUpdate(float rms, float tr, float kVar, float kMean) {
+  const char* took = "INIT";
+  if (!emaInited) {
+    emaRms = rms; emaTr = tr; emaKVar = kVar; emaKMean = kMean;
+    emaInited = true;
+    emaQualifiedBars = 1;
+  } else {
+    const bool ready = (emaQualifiedBars >= BASELINE_MIN_QUALIFIED_BARS);
+    const float kR = safeDiv(kVar, emaKVar);
+    const float rR = safeDiv(rms, emaRms);
+    const float tR = safeDiv(tr, emaTr);
+    const bool inBand = (kR >= BASELINE_UPDATE_KR_MIN && kR <= BASELINE_UPDATE_KR_MAX) &&
+                        ((rR >= BASELINE_UPDATE_RR_MIN && rR <= BASELINE_UPDATE_RR_MAX) ||
+                         (tR >= BASELINE_UPDATE_TR_MIN && tR <= BASELINE_UPDATE_TR_MAX));
+    if (ready && !inBand) {
+      took = "GATED";
+    } else {
+      const float a = ready ? BASE_ALPHA_STD : BASE_ALPHA_LEARNING;
+      emaRms   = (1.0f - a) * emaRms   + a * rms;
+      emaTr    = (1.0f - a) * emaTr    + a * tr;
+      emaKVar  = (1.0f - a) * emaKVar  + a * kVar;
+      emaKMean = (1.0f - a) * emaKMean + a * kMean;
+      if (!ready) emaQualifiedBars++;
+      took = "UPDATE";
+    }
+  }
+  Serial.printf("BASE_CMP pos=%lu.%u ema=%s rms=%.4f/%.4f tr=%.6f/%.6f kVar=%.6f/%.6f kMean=%.6f/%.6f (quantile/ema)\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, took,
+                baseRms, emaRms, baseTr, emaTr, baseKVar, emaKVar, baseKMean, emaKMean);
+}
+
+// ---------------- BASELINE PROFILES ----------------
+static uint8_t profBpmBand(float bpm) {
+  const float b = bpm / BASE_PROFILE_BPM_BAND;
+  return (uint8_t)((b < 0.0f) ? 0.0f : (b > 255.0f) ? 255.0f : b);
+}
+
+static int8_t profLevelBand(float rms) {
+  const float l = floorf(log2f(fmaxf(rms, 1e-6f)) * BASE_PROFILE_LEVEL_STEPS);
+  return (int8_t)((l < -127.0f) ? -127.0f : (l > 127.0f) ? 127.0f : l);
+}
+
+static uint8_t baseProfilesUsed() {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < BASE_PROFILE_SLOTS; i++) if (baseProfiles[i].used) n++;
+  return n;
+}
+
+static uint32_t baseProfileBlobCrc() {
+  return crc32_ieee(&baseProfileBlob, offsetof(BaseProfileBlob, crc));
+}
+
+static void baseProfilesLoad() {
+  memset(baseProfiles, 0, sizeof(baseProfiles));
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, true);
+  const size_t len = prefs.getBytesLength(NVS_KEY_BASE_PROFILES);
+  const char* drop = nullptr;                 // why a stored blob was not used
+  if (len != 0) {
+    if (len != sizeof(baseProfileBlob) ||
+        prefs.getBytes(NVS_KEY_BASE_PROFILES, &baseProfileBlob, sizeof(baseProfileBlob)) != sizeof(baseProfileBlob))
+      drop = "LAYOUT";
+    else if (baseProfileBlob.magic != BASE_PROFILE_MAGIC || baseProfileBlob.version != BASE_PROFILE_VERSION ||
+             baseProfileBlob.slots != BASE_PROFILE_SLOTS)
+      drop = "VERSION";
+    else if (baseProfileBlob.crc != baseProfileBlobCrc())
+      drop = "CRC";
+    else
+      memcpy(baseProfiles, baseProfileBlob.slot, sizeof(baseProfiles));
+  }
+  prefs.end();
+  baseProfileSeq = 0;
+  for (uint8_t i = 0; i < BASE_PROFILE_SLOTS; i++)
+    if (baseProfiles[i].used && baseProfiles[i].seq > baseProfileSeq) baseProfileSeq = baseProfiles[i].seq;
+  baseProfilesDirty = false;
+  baseProfilesSavedMs = millis();
+  Serial.printf("BASE_PROFILES loaded=%u/%u%s%s\n", (unsigned)baseProfilesUsed(), (unsigned)BASE_PROFILE_SLOTS,
+                drop ? " dropped=" : "", drop ? drop : "");
+}
+
+static void baseProfilesSave() {
+  if (!baseProfilesDirty) return;
+  baseProfileBlob.magic   = BASE_PROFILE_MAGIC;
+  baseProfileBlob.version = BASE_PROFILE_VERSION;
+  baseProfileBlob.slots   = BASE_PROFILE_SLOTS;
+  memcpy(baseProfileBlob.slot, baseProfiles, sizeof(baseProfiles));
+  baseProfileBlob.crc     = baseProfileBlobCrc();
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.putBytes(NVS_KEY_BASE_PROFILES, &baseProfileBlob, sizeof(baseProfileBlob));
+  prefs.end();
+  baseProfilesDirty = false;
+  baseProfilesSavedMs = millis();
+  Serial.printf("EVENT BASE_PROFILES_SAVED slots=%u/%u bytes=%u\n",
+                (unsigned)baseProfilesUsed(), (unsigned)BASE_PROFILE_SLOTS, (unsigned)sizeof(baseProfileBlob));
+}
+
+// New learning run (entry, hard reset, audio recovery): warm start allowed again
+static void baseProfileSessionReset() {
+  warmSlot = -1;
+  warmPending = false;
+  warmConfirmBars = 0;
+  profKeySlot = -1;
+  profKeyBars = 0;
+  profBfValid = false;
+  baselineStartMs = millis();
+}
+
+static void baselineMarkReady(const char* src) {
+  Serial.printf("EVENT BASELINE_READY pos=%lu.%u src=%s bars=%u ready_ms=%lu\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                src, (unsigned)baselineQualifiedBars,
+                (unsigned long)(millis() - baselineStartMs));
+}
+
+// Baselines from saved values (profile or resume snapshot); the medians hold
+// them at BASE_PROFILE_SEED_BARS bars of weight.
+static void baselineSeed(float rms, float tr, float kVar, float kMean,
+                         const float bandE[BAND_COUNT], const float bandV[BAND_COUNT]) {
   baseRms = rms; baseTr = tr; baseKVar = kVar; baseKMean = kMean;
+  for (uint8_t b = 0; b < BAND_COUNT; b++) { baseBand.energy[b] = bandE[b]; baseBand.var[b] = bandV[b]; }
+  if (BASELINE_QUANTILE) {
+    qBaseRms.seed(rms, BASE_PROFILE_SEED_BARS);
+    qBaseTr.seed(tr, BASE_PROFILE_SEED_BARS);
+    qBaseKVar.seed(kVar, BASE_PROFILE_SEED_BARS);
+    qBaseKMean.seed(kMean, BASE_PROFILE_SEED_BARS);
+    for (uint8_t b = 0; b < BAND_COUNT; b++) {
+      qBaseBandE[b].seed(bandE[b], BASE_PROFILE_SEED_BARS);
+      qBaseBandV[b].seed(bandV[b], BASE_PROFILE_SEED_BARS);
+    }
+  }
   baseInited = true;
-  Serial.printf("BASE_INIT rms=%.4f tr=%.6f kVar=%.8f kMean=%.6f pos=%lu.%u\n",
-                rms, tr, kVar, kMean, (unsigned long)curBarForEvents, (unsigned)curBeatForEvents);
+  intensityRefresh();
+}
+
+// First qualified bar: seed the baselines from the nearest stored profile.
+// Returns false when none is close enough (cold learning).
+static bool baseProfileWarmStart(float rms) {
+  if (!BASE_PROFILE_ENABLE) return false;
+  const uint8_t bb = profBpmBand(currentBPM());
+  const int8_t  lb = profLevelBand(rms);
+  int8_t best = -1;
+  int bestD = BASE_PROFILE_MAX_DIST + 1;
+  for (uint8_t i = 0; i < BASE_PROFILE_SLOTS; i++) {
+    const BaseProfile& p = baseProfiles[i];
+    if (!p.used) continue;
+    const int d = abs((int)p.bpmBand - (int)bb) + abs((int)p.levelBand - (int)lb);
+    if (d < bestD || (d == bestD && best >= 0 && p.seq > baseProfiles[best].seq)) { best = (int8_t)i; bestD = d; }
+  }
+  if (best < 0) return false;
+
+  const BaseProfile& p = baseProfiles[best];
+  baselineSeed(p.rms, p.tr, p.kVar, p.kMean, p.bandE, p.bandV);
+  warmSlot = best;
+  warmPending = true;
+  warmConfirmBars = 0;
+  Serial.printf("EVENT BASE_WARM_START pos=%lu.%u slot=%d dist=%d key=%u/%d prof_key=%u/%d rms=%.4f tr=%.6f kVar=%.8f kMean=%.6f\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (int)best, bestD,
+                (unsigned)bb, (int)lb, (unsigned)p.bpmBand, (int)p.levelBand, p.rms, p.tr, p.kVar, p.kMean);
+  return true;
+}
+
+// A qualified bar during warm confirmation. False (warm start dropped) on a miss.
+static bool baseProfileConfirmBar(float rms, float kVar) {
+  const BaseProfile& p = baseProfiles[warmSlot];
+  const float rR = safeDiv(rms, p.rms);
+  const float kR = safeDiv(kVar, p.kVar);
+  if (rR >= BASE_PROFILE_CONFIRM_MIN && rR <= BASE_PROFILE_CONFIRM_MAX &&
+      kR >= BASE_PROFILE_CONFIRM_MIN && kR <= BASE_PROFILE_CONFIRM_MAX) {
+    warmConfirmBars++;
+    return true;
+  }
+  Serial.printf("EVENT BASE_WARM_REJECTED pos=%lu.%u slot=%d rR=%.2f kR=%.2f confirmed=%u/%u\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (int)warmSlot,
+                rR, kR, (unsigned)warmConfirmBars, (unsigned)BASE_PROFILE_CONFIRM_BARS);
+  warmSlot = -1;
+  warmPending = false;
+  warmConfirmBars = 0;
+  return false;
+}
+
+// Ready qualified bar: once the key has held for BASE_PROFILE_HOLD_BARS, copy the
+// baselines into its slot (same key, else empty, else the oldest); flush batched.
+// A new key starts without break floor ratios: the last break was measured
+// against another key's baselines.
+static void baseProfileRefresh() {
+  if (!BASE_PROFILE_ENABLE || !baselineReady) return;
+  const uint8_t bb = profBpmBand(currentBPM());
+  const int8_t  lb = profLevelBand(baseRms);
+  if (profKeyBars == 0 || bb != profKeyBpm || lb != profKeyLevel) {
+    profKeyBpm = bb; profKeyLevel = lb;
+    profKeyBars = 1;
+    profKeySlot = -1;
+    profBfValid = false;
+  } else if (profKeyBars < BASE_PROFILE_HOLD_BARS) {
+    profKeyBars++;
+  }
+
+  if (profKeyBars >= BASE_PROFILE_HOLD_BARS) {
+    if (profKeySlot < 0) profKeySlot = baseProfileSlot(baseProfiles, BASE_PROFILE_SLOTS, bb, lb);
+    BaseProfile now = {};
+    now.bpmBand = bb;
+    now.levelBand = lb;
+    now.rms = baseRms; now.tr = baseTr; now.kVar = baseKVar; now.kMean = baseKMean;
+    for (uint8_t b = 0; b < BAND_COUNT; b++) { now.bandE[b] = baseBand.energy[b]; now.bandV[b] = baseBand.var[b]; }
+    if (profBfValid) {
+      now.hasBreak = 1;
+      now.bfRms = profBfRms; now.bfTr = profBfTr; now.bfKVar = profBfKVar;
+    }
+    if (baseProfileStore(baseProfiles[profKeySlot], now, BASE_PROFILE_SAVE_DELTA, &baseProfileSeq))
+      baseProfilesDirty = true;   // saved by nvsIdleService()
+  }
+}
+
+// BREAK entry: provisional floor from the learned floor ratios (this session's,
+// else the warm profile's), so the window checks have a floor during the first
+// BREAK bar; that bar's measurement replaces it.
+static void breakSeedFromProfile() {
+  if (!BASE_PROFILE_ENABLE || breakInited) return;
+  float r, t, k;
+  if (profBfValid) {
+    r = profBfRms; t = profBfTr; k = profBfKVar;
+  } else if (warmSlot >= 0 && !warmPending && baseProfiles[warmSlot].hasBreak) {
+    const BaseProfile& p = baseProfiles[warmSlot];
+    r = p.bfRms; t = p.bfTr; k = p.bfKVar;
+  } else {
+    return;
+  }
+  breakRms = r * baseRms; breakTr = t * baseTr; breakKVar = k * baseKVar;
+  breakInited = true;
+  breakSeeded = true;
+  intensityRefresh();
+}
+
+static void clearDecisionStreaks() {
+  candEvals = 0;
+  candEnterStreak = 0;
+  breakRecoverStreak = 0;
+  candRecoverStreak = 0;
+  candDeepStreak = 0;
 }
 
 static void breakReset() {
   breakInited = false;
+  breakSeeded = false;
   breakRms = breakTr = breakKVar = 0.0f;
+  intensityRefresh();
 }
 
 static void clearReturnTracking() {
@@ -390,6 +1408,7 @@ static void clearReturnTracking() {
   kickLostStreak = 0;
   returnBudget = 0;
   peak_bfR = peak_bfT = peak_bfK = 0.0f;
+  peak_kbR = 0.0f;
 }
 
 static void clearDropVerify() {
@@ -402,14 +1421,21 @@ static void breakUpdate(float rms, float tr, float kVar) {
   if (state != BREAK_CONFIRMED) return;
   if (returnActive) return; // freeze break floor during return evaluation
 
-  if (!breakInited) {
+  if (!breakInited || breakSeeded) {
     breakRms = rms; breakTr = tr; breakKVar = kVar;
     breakInited = true;
-    return;
+    breakSeeded = false;
+  } else {
+    breakRms  = (1.0f - BREAK_ALPHA) * breakRms  + BREAK_ALPHA * rms;
+    breakTr   = (1.0f - BREAK_ALPHA) * breakTr   + BREAK_ALPHA * tr;
+    breakKVar = (1.0f - BREAK_ALPHA) * breakKVar + BREAK_ALPHA * kVar;
+  }
+  if (baseInited) {                  // kept for the profiles, relative to the baseline
+    profBfRms = safeDiv(breakRms, baseRms);
+    profBfTr = safeDiv(breakTr, baseTr);
+    profBfKVar = safeDiv(breakKVar, baseKVar);
+    profBfValid = true;
   }
-  breakRms  = (1.0f - BREAK_ALPHA) * breakRms  + BREAK_ALPHA * rms;
-  breakTr   = (1.0f - BREAK_ALPHA) * breakTr   + BREAK_ALPHA * tr;
-  breakKVar = (1.0f - BREAK_ALPHA) * breakKVar + BREAK_ALPHA * kVar;
 }
 
 static bool baselineEligibleBar(float rms, float kVar, float rR, float tR, float kR) {
@@ -420,7 +1446,8 @@ static bool baselineEligibleBar(float rms, float kVar, float rR, float tR, float
 
   // After initialized but before ready: kick presence only - no band cap, allows convergence in any direction
   // Upper cap removed: false-low inits (quiet intro bar) would otherwise deadlock, blocking all groove bars
-  if (!baselineReady) return (kVar >= KICK_PRESENT_KVAR_ABS_MIN);
+  // Quantile baselines stay on this rule after ready: the median itself rejects outlier bars
+  if (!baselineReady || BASELINE_QUANTILE) return (kVar >= KICK_PRESENT_KVAR_ABS_MIN);
 
   // After ready: use representative bands to protect stable baseline from drift
   // kR must be in band (mandatory)
@@ -433,7 +1460,17 @@ static bool baselineEligibleBar(float rms, float kVar, float rR, float tR, float
   return (rRinBand || tRinBand);
 }
 
-static void baselineMaybeInitAndUpdate(float rms, float tr, float kVar, float kMean, float rR, float tR, float kR) {
+static void baselineColdStart(float rms, float tr, float kVar, float kMean, const BandFeatures& bands) {
+  baselineInit(rms, tr, kVar, kMean, bands); // logs BASE_INIT
+  if (BASELINE_QUANTILE) baselineQuantileAdd(rms, tr, kVar, kMean, bands);
+  if (BASELINE_QUANTILE && DEBUG_BASELINE_SHADOW) baselineShadowUpdate(rms, tr, kVar, kMean);
+  baselineQualifiedBars = 1;
+  baselineReady = (baselineQualifiedBars >= BASELINE_READY_BARS);
+  if (baselineReady) baselineMarkReady("COLD");
+}
+
+static void baselineMaybeInitAndUpdate(float rms, float tr, float kVar, float kMean, float rR, float tR, float kR,
+                                       const BandFeatures& bands) {
   if (state != STANDARD) return; // freeze outside STD
 
   if (!baselineEligibleBar(rms, kVar, rR, tR, kR)) {
@@ -441,7 +1478,7 @@ static void baselineMaybeInitAndUpdate(float rms, float tr, float kVar, float kM
       const char* why;
       if (rms < BASELINE_MIN_RMS)                                             why = "SILENCE";
       else if (kVar < KICK_PRESENT_KVAR_ABS_MIN)                             why = "NO_KICK";
-      else if (baselineReady && (kR < BASELINE_UPDATE_KR_MIN ||
+      else if (!BASELINE_QUANTILE && baselineReady && (kR < BASELINE_UPDATE_KR_MIN ||
                                  kR > BASELINE_UPDATE_KR_MAX))                why = "KR_OOB";
       else                                                                     why = "ENERGY_OOB";
       Serial.printf("BASE_SKIP pos=%lu.%u why=%s rms=%.4f kVar=%.6f kR=%.2f rR=%.2f tR=%.2f\n",
@@ -452,10 +1489,16 @@ static void baselineMaybeInitAndUpdate(float rms, float tr, float kVar, float kM
   }
 
   if (!baseInited) {
-    baselineInit(rms, tr, kVar, kMean); // logs BASE_INIT
-    baselineQualifiedBars = 1;
-    baselineReady = (baselineQualifiedBars >= BASELINE_MIN_QUALIFIED_BARS);
-    if (baselineReady) logEvent("BASELINE_READY");
+    if (!baseProfileWarmStart(rms)) {
+      baselineColdStart(rms, tr, kVar, kMean, bands);
+      return;
+    }
+    // warm start: this bar is the first one checked against the profile
+  }
+
+  if (warmPending && !baseProfileConfirmBar(rms, kVar)) {
+    baselineQuantileReset();                    // drop the seeded profile
+    baselineColdStart(rms, tr, kVar, kMean, bands);
     return;
   }
 
@@ -467,25 +1510,37 @@ static void baselineMaybeInitAndUpdate(float rms, float tr, float kVar, float kM
                   prevBlKVar, (int)baseInited, (int)baselineReady,
                   (unsigned)baselineQualifiedBars);
   }
-  const float a = baselineReady ? BASE_ALPHA_STD : BASE_ALPHA_LEARNING;
-  baseRms   = (1.0f - a) * baseRms   + a * rms;
-  baseTr    = (1.0f - a) * baseTr    + a * tr;
-  baseKVar  = (1.0f - a) * baseKVar  + a * kVar;
-  baseKMean = (1.0f - a) * baseKMean + a * kMean;
+  if (BASELINE_QUANTILE) {
+    baselineQuantileAdd(rms, tr, kVar, kMean, bands);
+    if (DEBUG_BASELINE_SHADOW) baselineShadowUpdate(rms, tr, kVar, kMean);
+  } else {
+    const float a = baselineReady ? BASE_ALPHA_STD : BASE_ALPHA_LEARNING;
+    baseRms   = (1.0f - a) * baseRms   + a * rms;
+    baseTr    = (1.0f - a) * baseTr    + a * tr;
+    baseKVar  = (1.0f - a) * baseKVar  + a * kVar;
+    baseKMean = (1.0f - a) * baseKMean + a * kMean;
+    for (uint8_t b = 0; b < BAND_COUNT; b++) {
+      baseBand.energy[b] = (1.0f - a) * baseBand.energy[b] + a * bands.energy[b];
+      baseBand.var[b]    = (1.0f - a) * baseBand.var[b]    + a * bands.var[b];
+    }
+  }
 
   if (!baselineReady) {
     baselineQualifiedBars++;
-    if (baselineQualifiedBars >= BASELINE_MIN_QUALIFIED_BARS) {
+    if (warmPending ? (warmConfirmBars >= BASE_PROFILE_CONFIRM_BARS)
+                    : (baselineQualifiedBars >= BASELINE_READY_BARS)) {
       baselineReady = true;
-      logEvent("BASELINE_READY");
+      warmPending = false;
+      baselineMarkReady((warmSlot >= 0) ? "WARM" : "COLD");
     }
   }
+  baseProfileRefresh();
 
   if (DEBUG_BASELINE_LOG) {
     Serial.printf("BASE_UPDATE pos=%lu.%u kR=%.2f rR=%.2f tR=%.2f kVar=%.8f->%.8f kMean=%.6f->%.6f qual=%u/%u\n",
                   (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
                   kR, rR, tR, prevBlKVar, baseKVar, prevBlKMean, baseKMean,
-                  (unsigned)baselineQualifiedBars, (unsigned)BASELINE_MIN_QUALIFIED_BARS);
+                  (unsigned)baselineQualifiedBars, (unsigned)BASELINE_READY_BARS);
   }
 }
 
@@ -499,7 +1554,7 @@ static void enterDrop(const char* whyEventName, const char* whyTransition) {
 
   // Clear return trackers
   clearReturnTracking();
-  breakRecoveryBars = 0;
+  breakRecoverStreak = 0;
 
   // Start post-drop verification (single sanity mechanism)
   dropVerifyActive = true;
@@ -523,6 +1578,7 @@ static void cancelDropBackToBreak(const char* why) {
     dropOnsetBarStart = 0;
     dropEndBar = 0;
     logTransition(p, state, "DROP_CANCEL_NO_BREAKFLOOR");
+    dropPrearmed = false;
     return;
   }
 
@@ -542,10 +1598,30 @@ static void cancelDropBackToBreak(const char* why) {
                 why, (unsigned)dropVerifyGood, (unsigned)DROP_VERIFY_WINDOWS);
 
   logTransition(p, state, "DROP_CANCEL_TO_BREAK");
+
+  // Missed pre-arm: back off before predicting another boundary
+  if (dropPrearmed) {
+    dropPrearmed = false;
+    if (prearmMisses < BUILDUP_BACKOFF_MAX) prearmMisses++;
+    prearmHoldBar = curBarForEvents + ((uint32_t)BUILDUP_BACKOFF_BARS << (prearmMisses - 1));
+    Serial.printf("EVENT DROP_PREARM_MISS pos=%lu.%u misses=%u hold=%lu score=%.2f\n",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                  (unsigned)prearmMisses, (unsigned long)prearmHoldBar, buildup.score());
+  }
 }
 
 // ---------------- v8 RETURN-IMPACT monitor (75ms windows) ----------------
-static void onMonitorWindow(float winRms, float winTr, float winKVar) {
+static void intensityUpdate(float winRms, float winTr, float winKVar) {
+  static constexpr float HI_GAIN = (1.0f - PP_INTENSITY_AT_BASE) / (INTENSITY_TOP_LEVEL - 1.0f);
+  const float level = intensityLevel(winRms, winTr, winKVar);
+  float target = (level <= 1.0f) ? intensityLoGain * level + intensityLoOff
+                                 : PP_INTENSITY_AT_BASE + HI_GAIN * (level - 1.0f);
+  target = (target < 0.0f) ? 0.0f : (target > 1.0f) ? 1.0f : target;
+  const float prev = last_intensity;
+  last_intensity = (prev < 0.0f) ? target : prev + INTENSITY_ALPHA * (target - prev);
+}
+
+static void onMonitorWindow(float winRms, float winTr, float winKVar, const BandFeatures& wb) {
   if (!baselineReady) return;
   if (!baseInited) return;
   if (sysMode == SYS_FAIL) return;
@@ -556,10 +1632,16 @@ static void onMonitorWindow(float winRms, float winTr, float winKVar) {
     const float w_kR = safeDiv(winKVar, baseKVar);
     if (w_kR < KICK_GONE_KR_MAX) stdKickGoneWinStreak++;
     else                        stdKickGoneWinStreak = 0;
+    if (stdKickGoneWinStreak == 1) { kickGoneBar = curBarForEvents; kickGoneBeat = curBeatForEvents; }
   } else {
     stdKickGoneWinStreak = 0;
   }
 
+  intensityUpdate(winRms, winTr, winKVar);
+
+  if (BUILDUP_PREARM_ENABLE && state == BREAK_CONFIRMED)
+    buildup.addWindow(winTr, wb.energy[BAND_HATS], wb.energy[BAND_BODY]);
+
   // We need break floor for any bfK-based logic (RETURN + VERIFY)
   if (!breakInited) {
     clearReturnTracking();
@@ -572,12 +1654,17 @@ static void onMonitorWindow(float winRms, float winTr, float winKVar) {
   const float w_bfT = safeDiv(winTr,   breakTr);
   const float w_bfK = safeDiv(winKVar, breakKVar);
 
+  // Filter-bank window ratios (vs baseline; logged with the return events)
+  float w_kbR, w_bdR, w_hhR;
+  bankRatios(wb, &w_kbR, &w_bdR, &w_hhR);
+
   // ---------------- POST-DROP verification (single sanity mechanism) ----------------
   if (state == DROP && dropVerifyActive) {
     if (w_bfK >= DROP_VERIFY_BF_K_MIN) dropVerifyGood++;
 
     if (dropVerifyGood >= DROP_VERIFY_MIN_GOOD) {
       dropVerifyActive = false;
+      dropPrearmed = false;
       Serial.printf("EVENT DROP_VERIFY_PASS pos=%lu.%u good=%u/%u\n",
                     (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
                     (unsigned)dropVerifyGood, (unsigned)DROP_VERIFY_WINDOWS);
@@ -612,8 +1699,9 @@ static void onMonitorWindow(float winRms, float winTr, float winKVar) {
       peak_bfR = peak_bfT = peak_bfK = 0.0f;
       returnWinStreak = 0;
 
-      Serial.printf("EVENT RETURN_START pos=%lu.%u w_bfK=%.2f\n",
-                    (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, w_bfK);
+      Serial.printf("EVENT RETURN_START pos=%lu.%u w_bfK=%.2f w_kbR=%.2f w_bdR=%.2f w_hhR=%.2f\n",
+                    (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, w_bfK,
+                    w_kbR, w_bdR, w_hhR);
     }
     return;
   }
@@ -633,108 +1721,106 @@ static void onMonitorWindow(float winRms, float winTr, float winKVar) {
   if (w_bfR > peak_bfR) peak_bfR = w_bfR;
   if (w_bfT > peak_bfT) peak_bfT = w_bfT;
   if (w_bfK > peak_bfK) peak_bfK = w_bfK;
+  if (w_kbR > peak_kbR) peak_kbR = w_kbR;
 
   const bool okKick = (peak_bfK >= DROP_BF_KV_MIN);
   const bool okLift = (peak_bfR >= DROP_BF_RMS_MIN) || (peak_bfT >= DROP_BF_TR_MIN);
 
   if (okKick && okLift) {
-    Serial.printf("EVENT DROP_CONFIRMED_RETURN pos=%lu.%u pk_bfK=%.2f pk_bfR=%.2f pk_bfT=%.2f\n",
+    Serial.printf("EVENT DROP_CONFIRMED_RETURN pos=%lu.%u pk_bfK=%.2f pk_bfR=%.2f pk_bfT=%.2f pk_kbR=%.2f\n",
                   (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
-                  peak_bfK, peak_bfR, peak_bfT);
+                  peak_bfK, peak_bfR, peak_bfT, peak_kbR);
     enterDrop("DROP_CONFIRMED", "RETURN_IMPACT_PEAKS");
     return;
   }
 
   if (returnBudget > 0) returnBudget--;
   if (returnBudget == 0) {
-    Serial.printf("EVENT RETURN_EXPIRE_NO_DROP pos=%lu.%u pk_bfK=%.2f pk_bfR=%.2f pk_bfT=%.2f\n",
+    Serial.printf("EVENT RETURN_EXPIRE_NO_DROP pos=%lu.%u pk_bfK=%.2f pk_bfR=%.2f pk_bfT=%.2f pk_kbR=%.2f\n",
                   (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
-                  peak_bfK, peak_bfR, peak_bfT);
+                  peak_bfK, peak_bfR, peak_bfT, peak_kbR);
     clearReturnTracking();
     return;
   }
 }
 
-// ---------------- Bar finalization (policy transitions) ----------------
-static void onBarFinalized(uint32_t finalizedBarNumber, float rms, float tr, float kVar, float kMean) {
-  const float rR    = baseInited ? safeDiv(rms,   baseRms)   : 0.0f;
-  const float tR    = baseInited ? safeDiv(tr,    baseTr)    : 0.0f;
-  const float kR    = baseInited ? safeDiv(kVar,  baseKVar)  : 0.0f;
-
-  // Audio degraded: no valid I2S data — skip all analysis, hold state at STANDARD
-  if (sysAudioDegraded) {
-    state = STANDARD;
-    last_rR = last_tR = last_kR = 0.0f;
-    last_bfR = last_bfT = last_bfK = 0.0f;
-    last_hasBF = false;
-    last_stateForBar = STANDARD;
-    return;
-  }
-
-  baselineMaybeInitAndUpdate(rms, tr, kVar, kMean, rR, tR, kR);
-
-  // kMeanR computed after baseline update so baseKMean is current
-  const float kMeanR = (baseInited && baseKMean > 0.0f) ? safeDiv(kMean, baseKMean) : 0.0f;
+// ---------------- Context transitions (bar- or beat-evaluated) ----------------
+struct CtxRatios { float rR, tR, kR, kMeanR; };
 
-  // Push bar kR and post-update bKVar into rolling history (used at CAND entry)
-  if (baseInited) {
-    kRHist[kRHistIdx % KR_HIST_LEN] = kR;
-    bKVHist[kRHistIdx % KR_HIST_LEN] = baseKVar;
-    kRHistIdx++;
-  }
-
-  if (!baselineReady) {
-    state = STANDARD;
-    candEnterBar = 0;
-    breakRecoveryBars = 0;
-    candDeepStreak = 0;
-    breakReset();
-    clearReturnTracking();
-    clearDropVerify();
+// 2D gate: kick impulsiveness low (kR) AND kick band energy not at baseline level (kMeanR)
+static bool condCandEnter(const CtxRatios& r) {
+  return (r.kR < KICK_GONE_KR_MAX) && (r.kMeanR < CAND_KMEANR_MAX) &&
+         (stdKickGoneWinStreak >= KICK_GONE_CONFIRM_WINDOWS);
+}
+static bool condDeepBreak(const CtxRatios& r) {
+  return (r.kR < DEEP_BREAK_KR_MAX) &&
+         ((r.rR < DEEP_BREAK_RMS_MAX) || (r.tR < DEEP_BREAK_TR_MAX)) &&
+         (r.kMeanR < BREAK_KMEANR_MAX); // kick band energy must genuinely collapse
+}
+// AND logic: both kick impulsiveness AND kick band energy must agree on recovery.
+// Symmetric with entry (which requires both kR and kMeanR to signal absence).
+// Prevents oscillation on sub-bass-heavy tracks where kMeanR stays near baseline
+// while kR remains low — OR logic would falsely recover on kMeanR alone.
+static bool condCandRecover(const CtxRatios& r) {
+  const bool kickPresent = (r.kR >= CAND_RECOVERY_KR_MIN) && (r.kMeanR >= RECOVERY_KMEANR_MIN);
+  return (r.rR >= RECOVERY_RR_MIN) && (r.tR >= RECOVERY_TR_MIN) && kickPresent;
+}
+static bool condBreakRecover(const CtxRatios& r) {
+  return (r.kR >= RECOVERY_KR_MIN) && ((r.rR >= RECOVERY_RR_MIN) || (r.tR >= RECOVERY_TR_MIN));
+}
 
-    last_rR = rR; last_tR = tR; last_kR = kR;
-    last_bfR = last_bfT = last_bfK = 0.0f;
-    last_hasBF = false;
-    last_stateForBar = state;
-    return;
+// Every beat, both modes: note the first beat whose rolling window meets the
+// condition of a transition open from the current state (for lat_ms).
+static void decisionProbe(const CtxRatios& r, uint32_t nowUs) {
+  const bool met[EV_COUNT] = {
+    (state == STANDARD)        && condCandEnter(r),
+    (state == BREAK_CANDIDATE) && condDeepBreak(r),
+    (state == BREAK_CANDIDATE) && condCandRecover(r),
+    (state == BREAK_CONFIRMED) && !returnActive && condBreakRecover(r),
+  };
+  for (uint8_t i = 0; i < EV_COUNT; i++) {
+    if (!met[i])                       evidenceSinceUs[i] = 0;
+    else if (evidenceSinceUs[i] == 0)  evidenceSinceUs[i] = nowUs | 1u;
   }
+}
 
+// One evaluation of the CAND / BREAK / recovery policy. Streaks count
+// evaluations; the gate says how many consecutive ones each edge needs.
+static void contextStep(const CtxRatios& r, const DecisionGate& g) {
   ContextState prev = state;
-  if (state != BREAK_CANDIDATE) candDeepStreak = 0;
+  if (state != STANDARD)        candEnterStreak = 0;
+  if (state != BREAK_CANDIDATE) { candDeepStreak = 0; candRecoverStreak = 0; }
+  if (state != BREAK_CONFIRMED) breakRecoverStreak = 0;
 
-  // ----- BREAK -> STANDARD recovery (bar-level) -----
+  // ----- BREAK -> STANDARD recovery -----
   // Priority: if returnActive is true, do not allow recovery to steal the moment
   if (state == BREAK_CONFIRMED && !returnActive) {
-    const bool ok = (kR >= RECOVERY_KR_MIN) &&
-                    ((rR >= RECOVERY_RR_MIN) || (tR >= RECOVERY_TR_MIN));
-    breakRecoveryBars = ok ? 1 : 0;
-    if (breakRecoveryBars >= 1) {
+    breakRecoverStreak = condBreakRecover(r) ? (uint8_t)(breakRecoverStreak + 1) : 0;
+    if (breakRecoverStreak >= g.recover) {
       state = STANDARD;
-      candEnterBar = 0;
-      breakRecoveryBars = 0;
-      candDeepStreak = 0;
+      clearDecisionStreaks();
       breakReset();
       clearReturnTracking();
       clearDropVerify();
-      logTransition(prev, state, "BREAK_RECOVER_BAR");
+      logDecision(prev, state, g.whyBreakRecover, EV_BREAK_RECOVER, g);
       prev = state;
     }
   }
 
   // ----- STANDARD -> CAND -----
-  // 2D gate: kick impulsiveness low (kR) AND kick band energy not at baseline level (kMeanR)
   if (state == STANDARD) {
-    if ((kR < KICK_GONE_KR_MAX) && (kMeanR < CAND_KMEANR_MAX) && (stdKickGoneWinStreak >= KICK_GONE_CONFIRM_WINDOWS)) {
+    candEnterStreak = condCandEnter(r) ? (uint8_t)(candEnterStreak + 1) : 0;
+    if (candEnterStreak >= g.candEnter) {
       state = BREAK_CANDIDATE;
-      candEnterBar = finalizedBarNumber;
-      breakRecoveryBars = 0;
-      candDeepStreak = 0;
+      clearDecisionStreaks();
       breakReset();
       clearReturnTracking();
       clearDropVerify();
-      logTransition(prev, state, "CAND_ENTER_KICK_ABSENCE");
+      logDecision(prev, state, "CAND_ENTER_KICK_ABSENCE", EV_CAND_ENTER, g);
+      // Kick left on a bar line: a streak starting late in a bar began at the next one
+      breakAnchorBar = (kickGoneBeat <= 2) ? kickGoneBar : kickGoneBar + 1;
       // Dump last 4 bars of kR and bKVar to show drift trajectory leading into CAND
-      Serial.printf("CAND_CONTEXT wStr=%u kMeanR=%.2f last%u_kR=", (unsigned)stdKickGoneWinStreak, kMeanR, (unsigned)KR_HIST_LEN);
+      Serial.printf("CAND_CONTEXT wStr=%u kMeanR=%.2f last%u_kR=", (unsigned)stdKickGoneWinStreak, r.kMeanR, (unsigned)KR_HIST_LEN);
       for (uint8_t i = 0; i < KR_HIST_LEN; i++) {
         uint8_t slot = (kRHistIdx - KR_HIST_LEN + i) % KR_HIST_LEN;
         Serial.printf("%.2f%s", kRHist[slot], (i < KR_HIST_LEN - 1) ? "," : "");
@@ -751,51 +1837,131 @@ static void onBarFinalized(uint32_t finalizedBarNumber, float rms, float tr, flo
 
   // ----- CAND -> BREAK OR recover to STD -----
   if (state == BREAK_CANDIDATE) {
-    const bool canEvalDeep = (finalizedBarNumber >= (candEnterBar + (uint32_t)CAND_MIN_BARS));
-    const bool deep = (kR < DEEP_BREAK_KR_MAX) &&
-                      ((rR < DEEP_BREAK_RMS_MAX) || (tR < DEEP_BREAK_TR_MAX)) &&
-                      (kMeanR < BREAK_KMEANR_MAX); // kick band energy must genuinely collapse
-
-    if (canEvalDeep && deep) candDeepStreak++;
-    else                     candDeepStreak = 0;
+    const bool canEvalDeep = (candEvals >= (uint8_t)(CAND_MIN_BARS * g.evalsPerBar));
+    candDeepStreak = (canEvalDeep && condDeepBreak(r)) ? (uint8_t)(candDeepStreak + 1) : 0;
 
-    if (candDeepStreak >= 2) {
+    if (candDeepStreak >= g.deep) {
       state = BREAK_CONFIRMED;
-      candDeepStreak = 0;
-      breakReset();           // break floor will init on first BREAK bar update below
+      clearDecisionStreaks();
+      breakReset();           // break floor will init on first BREAK bar update
+      breakSeedFromProfile(); // provisional until then, if one was learned
       clearReturnTracking();
       clearDropVerify();
       // Capture stable pre-BREAK tempo as reference for CLOCK_HOLD guard
-      bpmHoldIntervalUs    = lastBeatIntervalUs;
+      bpmHoldIntervalUs    = tempo.periodUs();
       clockHoldActive      = false;
       clockHoldStableBeats = 0;
-      logTransition(prev, state, "BREAK_CONFIRM_DEEP_2B");
+      logDecision(prev, state, g.whyDeep, EV_DEEP, g);
       prev = state;
     } else {
-      // AND logic: both kick impulsiveness AND kick band energy must agree on recovery.
-      // Symmetric with entry (which requires both kR and kMeanR to signal absence).
-      // Prevents oscillation on sub-bass-heavy tracks where kMeanR stays near baseline
-      // while kR remains low — OR logic would falsely recover on kMeanR alone.
       // Minimum 1 bar in CAND before recovery evaluated (prevents same-bar entry+recovery).
-      const bool canEvalRecover = (finalizedBarNumber > candEnterBar);
-      const bool kickPresent = (kR >= CAND_RECOVERY_KR_MIN) && (kMeanR >= RECOVERY_KMEANR_MIN);
-      const bool okRecover = canEvalRecover && (rR >= RECOVERY_RR_MIN) && (tR >= RECOVERY_TR_MIN) && kickPresent;
-      if (okRecover) {
+      const bool canEvalRecover = (candEvals >= g.recoverMinEvals);
+      candRecoverStreak = (canEvalRecover && condCandRecover(r)) ? (uint8_t)(candRecoverStreak + 1) : 0;
+      if (candRecoverStreak >= g.recover) {
         state = STANDARD;
-        candEnterBar = 0;
-        candDeepStreak = 0;
-        breakRecoveryBars = 0;
+        clearDecisionStreaks();
         breakReset();
         clearReturnTracking();
         clearDropVerify();
-        logTransition(prev, state, "CAND_RECOVER_BAR");
+        logDecision(prev, state, g.whyCandRecover, EV_CAND_RECOVER, g);
         prev = state;
+      } else if (candEvals < 255) {
+        candEvals++;
       }
     }
   }
+}
+
+// Close the beat that just ended into the rolling ring.
+static void beatRingPush() {
+  beatAcc.mergeSince(winAcc, winBeatMark);
+  beatRing[beatRingIdx] = beatAcc;
+  beatRingIdx = (uint8_t)((beatRingIdx + 1) % ROLL_BEATS);
+  if (beatRingFill < ROLL_BEATS) beatRingFill++;
+  beatAcc.reset();
+}
+
+// Ratios over the last ROLL_BEATS closed beats; false until the ring is full.
+static bool rollingRatios(CtxRatios* r) {
+  if (beatRingFill < ROLL_BEATS || !baseInited) return false;
+  FeatureAcc roll;
+  for (uint8_t i = 0; i < ROLL_BEATS; i++) roll.merge(beatRing[i]);
+  r->rR = safeDiv(roll.rms(),  baseRms);
+  r->tR = safeDiv(roll.tr(),   baseTr);
+  r->kR = safeDiv(roll.kVar(), baseKVar);
+  r->kMeanR = (baseKMean > 0.0f) ? safeDiv(roll.kMean(), baseKMean) : 0.0f;
+  return true;
+}
+
+// ---------------- Phrase boundaries (per bar) ----------------
+// Bar finalized (raw features; the grid does not need the baseline)
+static void phraseBar(uint32_t bar, float rms, float tr, float kVar, float kMean) {
+  if (!PHRASE_ENABLE) return;
+  if (phrase.onBar(bar, rms, tr, kVar, kMean)) {
+    Serial.printf("EVENT PHRASE_NOVELTY pos=%lu.%u bar=%lu nov=%.2f n4=%.2f n8=%.2f n16=%.2f\n",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (unsigned long)bar,
+                  phrase.novelty(), phrase.noveltyAt(0), phrase.noveltyAt(1), phrase.noveltyAt(2));
+  }
+}
+
+// ---------------- Bar finalization (policy transitions) ----------------
+static void onBarFinalized(uint32_t finalizedBarNumber, float rms, float tr, float kVar, float kMean,
+                           const BandFeatures& bands) {
+  const float rR    = baseInited ? safeDiv(rms,   baseRms)   : 0.0f;
+  const float tR    = baseInited ? safeDiv(tr,    baseTr)    : 0.0f;
+  const float kR    = baseInited ? safeDiv(kVar,  baseKVar)  : 0.0f;
+
+  // Audio degraded: no valid I2S data — skip all analysis, hold state at STANDARD
+  if (sysAudioDegraded) {
+    state = STANDARD;
+    last_rR = last_tR = last_kR = 0.0f;
+    last_bfR = last_bfT = last_bfK = 0.0f;
+    last_hasBF = false;
+    last_kbR = last_bdR = last_hhR = 0.0f;
+    last_stateForBar = STANDARD;
+    return;
+  }
+
+  phraseBar(finalizedBarNumber, rms, tr, kVar, kMean);
+  baselineMaybeInitAndUpdate(rms, tr, kVar, kMean, rR, tR, kR, bands);
+  intensityRefresh();
+
+  // Bank ratios after the baseline update, like kMeanR
+  float kbR, bdR, hhR;
+  bankRatios(bands, &kbR, &bdR, &hhR);
+  last_kbR = kbR; last_bdR = bdR; last_hhR = hhR;
+
+  // kMeanR computed after baseline update so baseKMean is current
+  const float kMeanR = (baseInited && baseKMean > 0.0f) ? safeDiv(kMean, baseKMean) : 0.0f;
+
+  // Push bar kR and post-update bKVar into rolling history (used at CAND entry)
+  if (baseInited) {
+    kRHist[kRHistIdx % KR_HIST_LEN] = kR;
+    bKVHist[kRHistIdx % KR_HIST_LEN] = baseKVar;
+    kRHistIdx++;
+  }
+
+  if (!baselineReady) {
+    state = STANDARD;
+    clearDecisionStreaks();
+    breakReset();
+    clearReturnTracking();
+    clearDropVerify();
+
+    last_rR = rR; last_tR = tR; last_kR = kR;
+    last_bfR = last_bfT = last_bfK = 0.0f;
+    last_hasBF = false;
+    last_stateForBar = state;
+    return;
+  }
+
+  // ----- Context transitions (at the downbeat this bar is the rolling window) -----
+  const CtxRatios r = { rR, tR, kR, kMeanR };
+  contextStep(r, DECIDE_PER_BEAT ? GATE_BEAT : GATE_BAR);
 
   // ----- Update BREAK floor (only in BREAK, frozen during returnActive) -----
   breakUpdate(rms, tr, kVar);
+  intensityRefresh();   // after this bar's floor update
 
   // ----- bf ratios for logging -----
   float bfR = 0, bfT = 0, bfK = 0;
@@ -813,14 +1979,64 @@ static void onBarFinalized(uint32_t finalizedBarNumber, float rms, float tr, flo
   last_stateForBar = state;
 }
 
+// ---------------- 16th grid snapshot ----------------
+// 0..9 per slot, relative to the bar's loudest slot
+static void gridProfile(const float* v, char* out) {
+  float mx = 0.0f;
+  for (uint8_t i = 0; i < GRID_SLOTS; i++) if (v[i] > mx) mx = v[i];
+  for (uint8_t i = 0; i < GRID_SLOTS; i++) out[i] = (char)('0' + (uint8_t)(clamp01(safeDiv(v[i], mx)) * 9.0f + 0.5f));
+  out[GRID_SLOTS] = '\0';
+}
+
+static void gridSnapshot(uint32_t finalizedBarNumber) {
+  float onQ = 0.0f, offQ = 0.0f;
+  for (uint8_t i = 0; i < GRID_SLOTS; i++) {
+    lastGrid.rms[i]  = gridAcc[i].rms();
+    lastGrid.tr[i]   = gridAcc[i].tr();
+    lastGrid.kick[i] = gridAcc[i].kMean();
+    if ((i & 3) == 0) onQ += lastGrid.kick[i];
+    else              offQ += lastGrid.kick[i];
+  }
+  lastGrid.fourOnFloor = safeDiv(onQ / 4.0f, offQ / 12.0f);
+
+  if (DEBUG_GRID_LOG) {
+    char k[GRID_SLOTS + 1], r[GRID_SLOTS + 1], t[GRID_SLOTS + 1];
+    gridProfile(lastGrid.kick, k);
+    gridProfile(lastGrid.rms, r);
+    gridProfile(lastGrid.tr, t);
+    Serial.printf("GRID bar=%lu k=%s r=%s t=%s q4=%.2f\n",
+                  (unsigned long)finalizedBarNumber, k, r, t, lastGrid.fourOnFloor);
+  }
+}
+
 // ---------------- Bar finalize (MIDI-synchronous) ----------------
+// Bar cut short by Start / SPP: drop what it gathered without finalizing.
+static void discardPartialBar() {
+  barAcc.mergeSince(winAcc, winBarMark);
+  barBank.mergeSince(winBank, winBankMark);
+  resetBarAcc();
+}
+
 static void finalizeBarNow(uint32_t stampUs, uint32_t finalizedBarNumber) {
-  float rms = 0.0f, tr = 0.0f, kVar = 0.0f, kMean = 0.0f;
-  if (barN > 0) {
-    rms = sqrtf((float)(barSumSq / (double)barN));
-    tr  = (float)(barTrSum / (double)barN);
-    kVar = barKickW.var();
-    kMean = (float)barKickW.mean;
+  barAcc.mergeSince(winAcc, winBarMark);   // partial window up to the downbeat
+  barBank.mergeSince(winBank, winBankMark);
+
+  const float rms   = barAcc.rms();
+  const float tr    = barAcc.tr();
+  const float kVar  = barAcc.kVar();
+  const float kMean = barAcc.kMean();
+
+  if (DEBUG_ACC_SHADOW && barShadow.n > 0) {
+    const float eR = shadowErr(rms,   barShadow.rms());
+    const float eT = shadowErr(tr,    barShadow.tr());
+    const float eK = shadowErr(kVar,  barShadow.kickW.var());
+    const float eM = shadowErr(kMean, (float)barShadow.kickW.mean);
+    const float worst = fmaxf(fmaxf(eR, eT), fmaxf(fmaxf(eK, eM), shadowWinMaxErr));
+    Serial.printf("ACC_SHADOW bar=%lu n=%lu eRms=%.2e eTr=%.2e eKVar=%.2e eKMean=%.2e winMax=%.2e %s\n",
+                  (unsigned long)finalizedBarNumber, (unsigned long)barAcc.n,
+                  eR, eT, eK, eM, shadowWinMaxErr,
+                  (worst <= FA_SHADOW_REL_TOL) ? "OK" : "OUT_OF_BOUND");
+    shadowWinMaxErr = 0.0f;
   }
 
   lastBarRms = rms;
@@ -829,94 +2045,167 @@ static void finalizeBarNow(uint32_t stampUs, uint32_t finalizedBarNumber) {
   lastBarKMean = kMean;
   lastBarUs = stampUs;
 
+  const BandFeatures bands = bankFeatures(barBank);
+  gridSnapshot(finalizedBarNumber);
+
   resetBarAcc();
-  onBarFinalized(finalizedBarNumber, rms, tr, kVar, kMean);
+  onBarFinalized(finalizedBarNumber, rms, tr, kVar, kMean, bands);
 }
 
-// ---------------- Beat log ----------------
-static void logBeatLine(uint32_t nowUs, bool isBarStart) {
-  const uint32_t dtUs = (lastBeatUs == 0) ? 0 : (nowUs - lastBeatUs);
-  if (dtUs > 0) {
-    const uint32_t candidateUs = (uint32_t)(0.85f * (float)lastBeatIntervalUs + 0.15f * (float)dtUs);
-    const float candBpm = 60000000.0f / (float)candidateUs;
-
-    // D1: range guard — reject smoothed BPM outside [BPM_RANGE_MIN, BPM_RANGE_MAX]
-    bool rejectTick = false;
-    if (candBpm < BPM_RANGE_MIN || candBpm > BPM_RANGE_MAX) {
-      Serial.printf("EVENT BPM_RANGE_REJECT pos=%lu.%u bpm=%.1f (range [%.0f,%.0f])\n",
-                    (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
-                    candBpm, BPM_RANGE_MIN, BPM_RANGE_MAX);
-      rejectTick = true;
-    }
-    // D2: spike guard — reject single-beat jump > BPM_SPIKE_MAX
-    else if (lastBeatIntervalUs > 0) {
-      const float curBpm = 60000000.0f / (float)lastBeatIntervalUs;
-      const float delta  = fabsf(candBpm - curBpm);
-      if (delta > BPM_SPIKE_MAX) {
-        Serial.printf("EVENT BPM_SPIKE_REJECT pos=%lu.%u candBpm=%.1f curBpm=%.1f delta=%.1f\n",
-                      (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
-                      candBpm, curBpm, delta);
-        rejectTick = true;
-      }
-    }
+// -------------- BAR SPLIT (sample-accurate bar boundaries) --------------
+// At the downbeat the audio of the closing bar is still partly in flight (up
+// to I2S_DMA_BUF_COUNT descriptors plus the block being processed). Instead
+// of finalizing when the tick is processed, the downbeat stamp is handed to
+// the audio task, which maps it to a frame through its sample-count timebase
+// (include/sample_clock.h) and closes a segment exactly there. The bar is
+// finalized when that segment is drained; segments drained meanwhile still
+// belong to it (last 16th of its grid). Typical wait: one to two DMA blocks.
+// Beat decisions are unaffected; a state the bar decides after the
+// downbeat's tick reaches the visuals from the next prepared beat.
+static constexpr bool     BAR_SPLIT_ENABLE     = true;
+static constexpr uint32_t BAR_SPLIT_TIMEOUT_US = 60000;   // > DMA queue + one block: I2S stalled
+static constexpr uint32_t BAR_SPLIT_LOG_MS     = 30000;   // BAR_SPLIT status interval
+
+static bool     barSplitPending = false;
+static uint32_t barSplitPendingSeq = 0;
+static uint32_t barSplitBar = 0;          // bar number to finalize
+static uint32_t barSplitStampUs = 0;      // downbeat stamp
+static uint32_t barSplitAskedUs = 0;      // micros() of the request
+
+// BAR_SPLIT counters (reset at every log line)
+static uint32_t barSplitCount = 0, barSplitLate = 0, barSplitTimeouts = 0;
+static uint32_t barSplitLateMaxUs = 0, barSplitWaitSumUs = 0, barSplitWaitMaxUs = 0;
+
+static void barSplitResolve() {
+  barSplitPending = false;
+  finalizeBarNow(barSplitStampUs, barSplitBar);
+}
 
-    if (!rejectTick) {
-    if (clockHoldActive) {
-      // Hold active: count toward release in STANDARD or DROP once clock re-stabilises.
-      // BREAK/CAND remain fully frozen. The stability gate (within CLOCK_HOLD_RESUME_BPM)
-      // is the real guard — no need to restrict by state beyond excluding BREAK/CAND.
-      if ((state == STANDARD || state == DROP) && bpmHoldIntervalUs > 0) {
-        const float holdBpm = 60000000.0f / (float)bpmHoldIntervalUs;
-        const float candBpm = 60000000.0f / (float)candidateUs;
-        if (fabsf(candBpm - holdBpm) <= CLOCK_HOLD_RESUME_BPM) {
-          clockHoldStableBeats++;
-          if (clockHoldStableBeats >= CLOCK_HOLD_RESUME_BEATS) {
-            clockHoldActive      = false;
-            clockHoldStableBeats = 0;
-            lastBeatIntervalUs   = candidateUs;
-            Serial.printf("EVENT CLOCK_HOLD_RELEASE pos=%lu.%u resumedBpm=%.1f\n",
-                          (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, candBpm);
-          }
-          // else: still counting; lastBeatIntervalUs stays frozen
-        } else {
-          clockHoldStableBeats = 0; // erratic even in STD; stay frozen
+// Downbeat of bar finalizedBarNumber + 1 at stampUs: finalize the bar once
+// its audio up to stampUs is in. Audio clock beats come out of the drained
+// stream itself, so their bar already ends at the right segment.
+static void barFinalizeRequest(uint32_t stampUs, uint32_t finalizedBarNumber) {
+  if (!BAR_SPLIT_ENABLE || audioClock) { finalizeBarNow(stampUs, finalizedBarNumber); return; }
+  if (barSplitPending) { barSplitTimeouts++; barSplitResolve(); }   // previous split never came
+
+  barSplitBar = finalizedBarNumber;
+  barSplitStampUs = stampUs;
+  barSplitAskedUs = micros();
+  barSplitUs.store(stampUs);
+  do { barSplitPendingSeq = barSplitSeq.fetch_add(1) + 1; } while (barSplitPendingSeq == 0);
+  barSplitPending = true;
+}
+
+// Split segment drained (after its merge): close the bar.
+static void barSplitOnSegment(const AudioSegment& seg) {
+  if (!barSplitPending || seg.barSplit != barSplitPendingSeq) return;
+  const uint32_t waitUs = micros() - barSplitAskedUs;
+  barSplitCount++;
+  barSplitWaitSumUs += waitUs;
+  if (waitUs > barSplitWaitMaxUs) barSplitWaitMaxUs = waitUs;
+  if (seg.splitLateUs > 0) {
+    barSplitLate++;
+    if (seg.splitLateUs > barSplitLateMaxUs) barSplitLateMaxUs = seg.splitLateUs;
+  }
+  barSplitResolve();
+}
+
+static void barSplitCheckTimeout(uint32_t nowUs) {
+  if (!barSplitPending || (uint32_t)(nowUs - barSplitAskedUs) < BAR_SPLIT_TIMEOUT_US) return;
+  barSplitTimeouts++;
+  barSplitResolve();
+}
+
+// Reset paths: the partial bar is discarded with the accumulators.
+static void barSplitCancel() { barSplitPending = false; }
+
+static void logBarSplit() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < BAR_SPLIT_LOG_MS) return;
+  lastLogMs = ms;
+  if (barSplitCount == 0 && barSplitTimeouts == 0) return;
+  Serial.printf("BAR_SPLIT bars=%lu late=%lu late_max_us=%lu wait_us=%lu/%lu timeout=%lu\n",
+                (unsigned long)barSplitCount, (unsigned long)barSplitLate, (unsigned long)barSplitLateMaxUs,
+                (unsigned long)(barSplitCount ? barSplitWaitSumUs / barSplitCount : 0),
+                (unsigned long)barSplitWaitMaxUs, (unsigned long)barSplitTimeouts);
+  barSplitCount = barSplitLate = barSplitTimeouts = 0;
+  barSplitLateMaxUs = barSplitWaitSumUs = barSplitWaitMaxUs = 0;
+}
+
+// ---------------- Beat log ----------------
+// ---------------- Tempo policy (tracker hooks) ----------------
+// CLOCK_HOLD as the tracker's accept hook: true lets this beat update the period.
+static bool clockHoldAccept(uint32_t rawIntervalUs, uint32_t candidateUs) {
+  if (clockHoldActive) {
+    // Hold active: count toward release in STANDARD or DROP once clock re-stabilises.
+    // BREAK/CAND remain fully frozen. The stability gate (within CLOCK_HOLD_RESUME_BPM)
+    // is the real guard — no need to restrict by state beyond excluding BREAK/CAND.
+    if ((state == STANDARD || state == DROP) && bpmHoldIntervalUs > 0) {
+      const float holdBpm = 60000000.0f / (float)bpmHoldIntervalUs;
+      const float candBpm = 60000000.0f / (float)candidateUs;
+      if (fabsf(candBpm - holdBpm) <= CLOCK_HOLD_RESUME_BPM) {
+        clockHoldStableBeats++;
+        if (clockHoldStableBeats >= CLOCK_HOLD_RESUME_BEATS) {
+          clockHoldActive      = false;
+          clockHoldStableBeats = 0;
+          Serial.printf("EVENT CLOCK_HOLD_RELEASE pos=%lu.%u resumedBpm=%.1f\n",
+                        (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, candBpm);
+          return true;
         }
+        // else: still counting; the period stays frozen
       } else {
-        // BREAK / CAND / DROP: fully frozen, reset stable-beat counter
-        clockHoldStableBeats = 0;
+        clockHoldStableBeats = 0; // erratic even in STD; stay frozen
       }
-      // lastBeatIntervalUs is NOT updated while hold is active
-
-    } else if (state == BREAK_CONFIRMED && bpmHoldIntervalUs > 0) {
-      // In BREAK, no hold yet: use raw tick BPM for immediate jump detection.
-      // Comparing against the IIR candidate would hide a sudden jump — the IIR
-      // absorbs only 15% per beat, so a 33 BPM raw jump appears as ~5 BPM per
-      // filtered step, never crossing the threshold while the reference slides.
-      // Using the raw tick catches the erratic beat on its very first occurrence.
-      const float holdBpm  = 60000000.0f / (float)bpmHoldIntervalUs;
-      const float rawBpm   = 60000000.0f / (float)dtUs;  // unsmoothed raw tick
-      const float bpmDelta = fabsf(rawBpm - holdBpm);
-      if (bpmDelta > CLOCK_HOLD_JUMP_BPM) {
-        clockHoldActive      = true;
-        clockHoldStableBeats = 0;
-        Serial.printf("EVENT CLOCK_HOLD_ENTER pos=%lu.%u holdBpm=%.1f rawBpm=%.1f delta=%.1f\n",
-                      (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
-                      holdBpm, rawBpm, bpmDelta);
-        // Don't update lastBeatIntervalUs — reject the erratic tick
-      } else {
-        // Stable tick in BREAK: accept IIR update for smooth visual timing.
-        // bpmHoldIntervalUs intentionally NOT updated — fixed at BREAK entry
-        // so the reference never drifts toward a gradually-converging erratic value.
-        lastBeatIntervalUs = candidateUs;
-      }
-
     } else {
-      // STANDARD / CAND / no hold reference: normal IIR update
-      lastBeatIntervalUs = candidateUs;
+      // BREAK / CAND / DROP: fully frozen, reset stable-beat counter
+      clockHoldStableBeats = 0;
     }
-    } // if (!rejectTick)
+    return false;                 // the period is NOT updated while hold is active
   }
-  lastBeatUs = nowUs;
+
+  if (state == BREAK_CONFIRMED && bpmHoldIntervalUs > 0) {
+    // In BREAK, no hold yet: use raw tick BPM for immediate jump detection.
+    // Comparing against the IIR candidate would hide a sudden jump — the IIR
+    // absorbs only 15% per beat, so a 33 BPM raw jump appears as ~5 BPM per
+    // filtered step, never crossing the threshold while the reference slides.
+    // Using the raw tick catches the erratic beat on its very first occurrence.
+    const float holdBpm  = 60000000.0f / (float)bpmHoldIntervalUs;
+    const float rawBpm   = 60000000.0f / (float)rawIntervalUs;  // unsmoothed raw tick
+    const float bpmDelta = fabsf(rawBpm - holdBpm);
+    if (bpmDelta > CLOCK_HOLD_JUMP_BPM) {
+      clockHoldActive      = true;
+      clockHoldStableBeats = 0;
+      Serial.printf("EVENT CLOCK_HOLD_ENTER pos=%lu.%u holdBpm=%.1f rawBpm=%.1f delta=%.1f\n",
+                    (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                    holdBpm, rawBpm, bpmDelta);
+      return false;               // reject the erratic tick
+    }
+    // Stable tick in BREAK: accept the update for smooth visual timing.
+    // bpmHoldIntervalUs intentionally NOT updated — fixed at BREAK entry
+    // so the reference never drifts toward a gradually-converging erratic value.
+  }
+  // STANDARD / CAND / no hold reference: normal update
+  return true;
+}
+
+// Feed one beat to the tracker; D1 / D2 rejections are policy events.
+static TempoBeat tempoOnBeat(uint32_t nowUs) {
+  const TempoBeat tb = tempo.onBeat(nowUs);
+  if (tb.verdict == TEMPO_REJECT_RANGE) {
+    Serial.printf("EVENT BPM_RANGE_REJECT pos=%lu.%u bpm=%.1f (range [%.0f,%.0f])\n",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                  tb.candBpm, BPM_RANGE_MIN, BPM_RANGE_MAX);
+  } else if (tb.verdict == TEMPO_REJECT_SPIKE) {
+    Serial.printf("EVENT BPM_SPIKE_REJECT pos=%lu.%u candBpm=%.1f curBpm=%.1f delta=%.1f\n",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                  tb.candBpm, tb.curBpm, fabsf(tb.candBpm - tb.curBpm));
+  }
+  return tb;
+}
+
+static void logBeatLine(uint32_t nowUs, bool isBarStart, const TempoBeat& tb) {
+  const uint32_t dtUs = tb.rawIntervalUs;
 
   // Suppress bar logs when there is no audio signal
   if (!seenAnyAudio || sysMode == SYS_FAIL) {
@@ -932,10 +2221,10 @@ static void logBeatLine(uint32_t nowUs, bool isBarStart) {
 
   // Compact bar-level format (when DEBUG_BEAT_LOG is off)
   if (isBarStart && !DEBUG_BEAT_LOG) {
-    Serial.printf("bar=%lu state=%s bpm=%.1f pat=%s rR=%.2f tR=%.2f kR=%.2f",
+    Serial.printf("bar=%lu state=%s bpm=%.1f conf=%.2f pat=%s rR=%.2f tR=%.2f kR=%.2f",
                   (unsigned long)barCount,
                   ctxName(last_stateForBar),
-                  60000000.0f / (float)lastBeatIntervalUs,
+                  tempo.bpm(), tempo.confidence(),
                   pp_patternName(pp_activePattern()),
                   last_rR, last_tR, last_kR);
 
@@ -947,14 +2236,19 @@ static void logBeatLine(uint32_t nowUs, bool isBarStart) {
       const float _kMeanR = (baseKMean > 0.0f) ? safeDiv(lastBarKMean, baseKMean) : 0.0f;
       const float _kCV    = (lastBarKMean > 0.0f) ? safeDiv(lastBarKVar, lastBarKMean) : 0.0f;
       Serial.printf(" kVar=%.6f kMean=%.6f blKV=%.6f kMeanR=%.2f kCV=%.4f", lastBarKVar, lastBarKMean, baseKVar, _kMeanR, _kCV);
+      Serial.printf(" kbR=%.2f bdR=%.2f hhR=%.2f", last_kbR, last_bdR, last_hhR);
     }
 
     if (last_hasBF) {
       Serial.printf(" bfK=%.2f", last_bfK);
     }
 
+    if (last_intensity >= 0.0f) {
+      Serial.printf(" int=%.2f", last_intensity);
+    }
+
     if (!baselineReady) {
-      Serial.printf(" qual=%u/%u", (unsigned)baselineQualifiedBars, (unsigned)BASELINE_MIN_QUALIFIED_BARS);
+      Serial.printf(" qual=%u/%u", (unsigned)baselineQualifiedBars, (unsigned)BASELINE_READY_BARS);
     }
 
     if (state == BREAK_CONFIRMED && returnActive) {
@@ -982,14 +2276,16 @@ static void logBeatLine(uint32_t nowUs, bool isBarStart) {
   snprintf(pos, sizeof(pos), "%lu.%u", (unsigned long)barCount, (unsigned)beatInBar);
 
   Serial.printf(
-    "pos=%s t_us=%lu dt_us=%lu ticks=%lu "
-    "wAge_ms=%lu wRms=%.4f wTr=%.5f wKVar=%.6f "
+    "pos=%s t_us=%lu dt_us=%lu ticks=%lu err_us=%ld next_us=%lu conf=%.2f "
+    "wAge_ms=%lu wRms=%.4f wTr=%.5f wKVar=%.6f wOn=%.3f(%.3f/%.3f/%.3f) "
     "bAge_ms=%lu bRms=%.4f bTr=%.5f bKVar=%.6f",
     pos,
     (unsigned long)nowUs,
     (unsigned long)dtUs,
     (unsigned long)ticksSinceBeat,
+    (long)tb.phaseErrUs, (unsigned long)tempo.predictedNextBeatUs(), tempo.confidence(),
     (unsigned long)wAgeMs, lastWinRms, lastWinTr, lastWinKVar,
+    lastWinOnset, lastWinOnsetBand[ONSET_LOW], lastWinOnsetBand[ONSET_MID], lastWinOnsetBand[ONSET_HIGH],
     (unsigned long)bAgeMs, lastBarRms, lastBarTr, lastBarKVar
   );
 
@@ -1009,7 +2305,7 @@ static void logBeatLine(uint32_t nowUs, bool isBarStart) {
       Serial.printf(" qual=%s(%u/%u)",
                     (baseInited ? "LEARN" : "OFF"),
                     (unsigned)baselineQualifiedBars,
-                    (unsigned)BASELINE_MIN_QUALIFIED_BARS);
+                    (unsigned)BASELINE_READY_BARS);
     }
 
     if (state == BREAK_CONFIRMED && returnActive) {
@@ -1032,6 +2328,220 @@ static void logBeatLine(uint32_t nowUs, bool isBarStart) {
 }
 
 // ---------------- MIDI processing ----------------
+// ---------------- Scheduled beat commits ----------------
+// esp_timer task: latch the pending frame unless the loop already did.
+static void beatCommitTimerCb(void*) {
+  const uint32_t nowUs = micros();
+  uint8_t expect = COMMIT_PENDING;
+  if (!beatCommitState.compare_exchange_strong(expect, (uint8_t)COMMIT_LATCHING)) return;
+  beatCommitUs = nowUs;
+  pp_commitPending();
+  beatCommitState.store(COMMIT_FIRED);   // publishes the latch and beatCommitUs
+}
+
+// Loop side: let a latch in progress finish. The esp_timer task outranks the
+// loop, so this spins for at most one hw_led_all_set().
+static uint8_t beatCommitSettle() {
+  uint8_t s = beatCommitState.load();
+  while (s == COMMIT_LATCHING) s = beatCommitState.load();
+  return s;
+}
+
+// Drop a prepared beat (resync / failure); the pending frame is latched so
+// no LED state is lost, and the next beat commits on its tick.
+static void beatCommitCancel() {
+  uint8_t expect = COMMIT_PENDING;
+  if (beatCommitState.compare_exchange_strong(expect, (uint8_t)COMMIT_IDLE)) {
+    if (beatCommitTimer) esp_timer_stop(beatCommitTimer);
+    pp_commitPending();
+  } else {
+    beatCommitSettle();
+  }
+  beatCommitState.store(COMMIT_IDLE);
+  beatPrepared = false;
+  commitAfterTick = false;
+}
+
+static void beatCommitRecord(int32_t errUs);
+
+// A latch the timer made after its tick: record it once it has fired
+static void beatCommitCollect() {
+  if (!commitAfterTick || beatCommitState.load() != COMMIT_FIRED) return;
+  commitAfterTick = false;
+  beatCommitRecord((int32_t)(beatCommitUs - commitAfterTickUs));
+  beatCommitState.store(COMMIT_IDLE);
+}
+
+// Tick BEAT_PREP_TICK: run the next beat ahead and arm the latch timer.
+static void beatPrepare() {
+  beatCommitCollect();
+  if (!BEAT_COMMIT_SCHEDULED || beatPrepared || sysMode == SYS_FAIL) return;
+  if (!tempo.hasPhase() || tempo.confidence() < BEAT_PREP_MIN_CONF) return;
+
+  const uint32_t beatUs = tempo.predictedNextBeatUs() + (uint32_t)audioOffsetUs;   // audible beat
+  const uint32_t target = beatUs - (uint32_t)BEAT_COMMIT_LEAD_US;
+  const int32_t  leadUs = (int32_t)(target - micros());
+  if (leadUs < (int32_t)BEAT_PREP_MIN_LEAD_US) return;
+
+  // Same advance as onMidiBeat()
+  uint32_t bar  = barCount;
+  uint8_t  beat = beatInBar;
+  if (beat == 0) beat = 1;
+  else if (beat < 4) beat++;
+  else { beat = 1; bar++; }
+
+  // Pre-armed DROP downbeat: render its first frame as DROP
+  const bool prearm = (beat == 1 && bar == dropPrearmBar && state == BREAK_CONFIRMED);
+  beatPrepared = true;
+  if (pp_prepareBeat((uint8_t)bar, beat, beatUs, prearm ? DROP : state, tempo.periodUs(), last_intensity)) {
+    beatCommitTargetUs = target;
+    beatCommitState.store(COMMIT_PENDING);
+    esp_timer_start_once(beatCommitTimer, (uint64_t)leadUs);
+  }
+}
+
+static void beatCommitRecord(int32_t errUs) {
+  if (commitN == 0 || errUs < commitErrMin) commitErrMin = errUs;
+  if (commitN == 0 || errUs > commitErrMax) commitErrMax = errUs;
+  commitErrSum += errUs;
+  commitErrSq  += (uint64_t)((int64_t)errUs * errUs);
+  commitN++;
+}
+
+// Beat tick arrived (tickUs = RX stamp). Returns true if the beat's frame was
+// prepared ahead, i.e. pp_onBeat() must not run again.
+static bool beatCommitOnTick(uint32_t tickUs) {
+  beatCommitCollect();
+  if (!beatPrepared) { commitFallback++; return false; }
+  beatPrepared = false;
+
+  uint8_t expect = COMMIT_PENDING;
+  if (beatCommitState.compare_exchange_strong(expect, (uint8_t)COMMIT_IDLE)) {
+    esp_timer_stop(beatCommitTimer);
+    if (pp_reprepareBeat(state, tempo.periodUs(), last_intensity)) commitReprepared++;
+
+    // Audible beat after the tick (audio offset): latch at tick + shift,
+    // re-armed from the tick so an early tick does not keep a late prediction
+    const int32_t shiftUs = audioOffsetUs - BEAT_COMMIT_LEAD_US;
+    const int32_t waitUs = (shiftUs > 0) ? (int32_t)(tickUs + (uint32_t)shiftUs - micros()) : 0;
+    if (waitUs > 0) {
+      commitAfterTick = true;
+      commitAfterTickUs = tickUs;
+      beatCommitState.store(COMMIT_PENDING);
+      esp_timer_start_once(beatCommitTimer, (uint64_t)waitUs);
+      return true;
+    }
+
+    // Tick before the timer: latch now
+    const uint32_t nowUs = micros();
+    pp_commitPending();
+    commitTickFirst++;
+    beatCommitRecord((int32_t)(nowUs - tickUs));
+  } else {
+    if (expect == COMMIT_LATCHING) expect = beatCommitSettle();
+    if (expect == COMMIT_FIRED) beatCommitRecord((int32_t)(beatCommitUs - tickUs));
+    if (pp_reprepareBeat(state, tempo.periodUs(), last_intensity)) {   // latched with the old state
+      pp_commitPending();
+      commitReprepared++;
+    }
+  }
+  beatCommitState.store(COMMIT_IDLE);
+  return true;
+}
+
+static void logBeatCommit() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < MIDI_JITTER_LOG_MS) return;
+  lastLogMs = ms;
+  if (!BEAT_COMMIT_SCHEDULED || (commitN == 0 && commitFallback == 0)) return;
+  const float mean = (commitN > 0) ? (float)commitErrSum / (float)commitN : 0.0f;
+  const float var  = (commitN > 1)
+                     ? (float)(((double)commitErrSq - (double)commitN * mean * mean) / (double)(commitN - 1))
+                     : 0.0f;
+  Serial.printf("BEAT_COMMIT n=%lu err_us=%.0f sd_us=%.0f span_us=%ld..%ld lead_us=%ld tickFirst=%lu onTick=%lu reprep=%lu\n",
+                (unsigned long)commitN, mean, (var > 0.0f) ? sqrtf(var) : 0.0f,
+                (long)commitErrMin, (long)commitErrMax, (long)BEAT_COMMIT_LEAD_US,
+                (unsigned long)commitTickFirst, (unsigned long)commitFallback,
+                (unsigned long)commitReprepared);
+  commitN = commitFallback = commitTickFirst = commitReprepared = 0;
+  commitErrSum = 0; commitErrSq = 0;
+  commitErrMin = commitErrMax = 0;
+}
+
+// ---------------- AUDIO / MIDI OFFSET ----------------
+static constexpr int32_t AUDIO_OFFSET_MIN_US =
+  -(int32_t)((24 - BEAT_PREP_TICK) * (uint32_t)(60000000.0f / (BPM_RANGE_MAX * 24.0f))
+             - BEAT_PREP_MIN_LEAD_US - AUDIO_OFFSET_PREP_MARGIN_US);
+static_assert(AUDIO_OFFSET_MIN_US < 0, "no room for audio ahead of MIDI");
+
+static int32_t audioOffsetClamp(int32_t us) {
+  if (us > AUDIO_OFFSET_LIMIT_US) return AUDIO_OFFSET_LIMIT_US;
+  if (us < AUDIO_OFFSET_MIN_US) return AUDIO_OFFSET_MIN_US;
+  return us;
+}
+
+static void audioOffsetLoad() {
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, true);
+  audioOffsetUs = audioOffsetClamp(prefs.getInt(NVS_KEY_AUDIO_OFFSET, 0));
+  prefs.end();
+  audioOffsetSavedUs = audioOffsetUs;
+  audioOffsetSavedMs = millis();
+  audioOffsetDirty = false;
+}
+
+static void audioOffsetSave() {
+  audioOffsetDirty = false;
+  if (audioOffsetUs == audioOffsetSavedUs) return;
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.putInt(NVS_KEY_AUDIO_OFFSET, audioOffsetUs);
+  prefs.end();
+  Serial.printf("EVENT AUDIO_OFFSET_SAVED offset_us=%ld was_us=%ld\n",
+                (long)audioOffsetUs, (long)audioOffsetSavedUs);
+  audioOffsetSavedUs = audioOffsetUs;
+  audioOffsetSavedMs = millis();
+}
+
+// A bar estimate closed (beat path): move the applied offset toward the
+// agreed mean; the NVS write is left to nvsIdleService()
+static void audioOffsetUpdate() {
+  if (offsetEst.bars() < AUDIO_OFFSET_MIN_BARS || offsetEst.stdUs() > AUDIO_OFFSET_MAX_STD_US) return;
+  const int32_t target = audioOffsetClamp(offsetEst.offsetUs());
+  audioOffsetUs += (int32_t)lroundf(AUDIO_OFFSET_GAIN * (float)(target - audioOffsetUs));
+
+  const uint32_t delta = (uint32_t)abs(audioOffsetUs - audioOffsetSavedUs);
+  if (delta >= AUDIO_OFFSET_SAVE_DELTA_US) audioOffsetDirty = true;
+}
+
+static void logAudioOffset() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < AUDIO_OFFSET_LOG_MS) return;
+  lastLogMs = ms;
+  Serial.printf("AUDIO_OFFSET est_us=%ld std_us=%lu bars=%u/%u rej=%lu last_us=%ld prom=%.1f applied_us=%ld saved_us=%ld\n",
+                (long)offsetEst.offsetUs(), (unsigned long)offsetEst.stdUs(),
+                (unsigned)offsetEst.bars(), (unsigned)BEAT_OFFSET_BARS,
+                (unsigned long)offsetEst.rejectedBars(), (long)offsetEst.lastBarUs(),
+                offsetEst.lastProminence(), (long)audioOffsetUs, (long)audioOffsetSavedUs);
+}
+
+// ---------------- Deferred NVS writes ----------------
+static bool nvsIdle() {
+  if (beatPrepared || beatCommitState.load() != COMMIT_IDLE) return false;
+  if (!midiRunning || midiStopped || audioClock) return true;   // no MIDI beat grid to stay clear of
+  return tickInBeat >= NVS_IDLE_TICK_FIRST && tickInBeat <= NVS_IDLE_TICK_LAST;
+}
+
+// One write per call: each is a separate flash stall
+static void nvsIdleService() {
+  if ((!audioOffsetDirty && !baseProfilesDirty) || !nvsIdle()) return;
+  const uint32_t ms = millis();
+  if (audioOffsetDirty && (uint32_t)(ms - audioOffsetSavedMs) >= AUDIO_OFFSET_SAVE_MIN_MS) audioOffsetSave();
+  else if (baseProfilesDirty && (uint32_t)(ms - baseProfilesSavedMs) >= BASE_PROFILE_SAVE_MIN_MS) baseProfilesSave();
+}
+
 static void resetForHardReset() {
   sysAudioDegraded   = false;
   audioDegradedSince = 0;
@@ -1040,7 +2550,12 @@ static void resetForHardReset() {
   ticksSinceBeat = 0;
   barCount = 1;
   beatInBar = 0;
-  lastBeatUs = 0;
+  gridSlot = 0;
+  gridMarkReset();
+  tempo.resync();
+  beatCommitCancel();
+  barSplitCancel();
+  offsetEst.resync();
 
   clockHoldActive      = false;
   bpmHoldIntervalUs    = 0;
@@ -1052,13 +2567,16 @@ static void resetForHardReset() {
   stdKickGoneWinStreak = 0;
 
   resetBarAcc();
+  resetBeatRing();
   resetWinAcc();
-  envLP = 0.0f;
-  hp_y = 0.0f;
-  hp_x_prev = 0.0f;
+  audioEpoch.fetch_add(1);   // audio task resets its filter states
 
   baseInited = false;
   baseRms = baseTr = baseKVar = baseKMean = 0.0f;
+  baseBand = BandFeatures();
+  last_intensity = -1.0f;
+  baselineQuantileReset();
+  baseProfileSessionReset();
   baselineReady = false;
   baselineQualifiedBars = 0;
 
@@ -1067,21 +2585,27 @@ static void resetForHardReset() {
   clearDropVerify();
 
   state = STANDARD;
-  candEnterBar = 0;
-  breakRecoveryBars = 0;
-  candDeepStreak = 0;
+  clearDecisionStreaks();
 
   lastWinUs = 0;
   lastBarUs = 0;
-  lastWinRms = lastWinTr = lastWinKVar = 0.0f;
+  lastWinRms = lastWinTr = lastWinKVar = lastWinOnset = 0.0f;
   lastBarRms = lastBarTr = lastBarKVar = 0.0f;
   last_rR = last_tR = last_kR = 0.0f;
   last_bfR = last_bfT = last_bfK = 0.0f;
   last_hasBF = false;
+  last_kbR = last_bdR = last_hhR = 0.0f;
   last_stateForBar = STANDARD;
 
   dropOnsetBarStart = 0;
   dropEndBar = 0;
+  buildup.reset();
+  breakAnchorBar = 0;
+  dropPrearmBar = 0;
+  dropPrearmed = false;
+  prearmMisses = 0;
+  prearmHoldBar = 0;
+  phrase.reset();
 
   pp_reset();
 }
@@ -1091,7 +2615,12 @@ static void resetForResumeLike() {
   ticksSinceBeat = 0;
   barCount = 1;
   beatInBar = 0;
-  lastBeatUs = 0;
+  gridSlot = 0;
+  gridMarkReset();
+  tempo.resync();
+  beatCommitCancel();
+  barSplitCancel();
+  offsetEst.resync();
 
   clockHoldActive      = false;
   bpmHoldIntervalUs    = 0;
@@ -1103,31 +2632,36 @@ static void resetForResumeLike() {
   curBeatForEvents = 0;
 
   resetBarAcc();
+  resetBeatRing();
   resetWinAcc();
-  envLP = 0.0f;
-  hp_y = 0.0f;
-  hp_x_prev = 0.0f;
+  audioEpoch.fetch_add(1);   // audio task resets its filter states
 
   breakReset();
   clearReturnTracking();
   clearDropVerify();
 
   state = STANDARD;
-  candEnterBar = 0;
-  breakRecoveryBars = 0;
-  candDeepStreak = 0;
+  clearDecisionStreaks();
 
   lastWinUs = 0;
   lastBarUs = 0;
-  lastWinRms = lastWinTr = lastWinKVar = 0.0f;
+  lastWinRms = lastWinTr = lastWinKVar = lastWinOnset = 0.0f;
   lastBarRms = lastBarTr = lastBarKVar = 0.0f;
   last_rR = last_tR = last_kR = 0.0f;
   last_bfR = last_bfT = last_bfK = 0.0f;
   last_hasBF = false;
+  last_kbR = last_bdR = last_hhR = 0.0f;
   last_stateForBar = STANDARD;
 
   dropOnsetBarStart = 0;
   dropEndBar = 0;
+  buildup.reset();
+  breakAnchorBar = 0;
+  dropPrearmBar = 0;
+  dropPrearmed = false;
+  prearmMisses = 0;
+  prearmHoldBar = 0;
+  phrase.reset();
 
   pp_reset();
 }
@@ -1148,14 +2682,13 @@ static void enterFailure(FailReason r) {
 
   sysMode = SYS_FAIL;
   failReason = r;
+  beatCommitCancel();
 
   state = STANDARD;
   breakReset();
   clearReturnTracking();
   clearDropVerify();
-  candEnterBar = 0;
-  breakRecoveryBars = 0;
-  candDeepStreak = 0;
+  clearDecisionStreaks();
 
   Serial.printf("EVENT FAIL reason=CLOCK_LOST pos=%lu.%u bpm=%.1f ctx=%s clockAge_ms=%lu audioAge_ms=%lu\n",
     (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
@@ -1172,6 +2705,7 @@ static void enterMusicStop() {
   audioDegradedSince = 0;
 
   midiRunning = false;
+  midiStopped = false;
 
   resetForResumeLike();
 
@@ -1189,15 +2723,67 @@ static void clearStopLatches() {
   audioLostAtUs = 0;
 }
 
+// ---------------- AUDIO CLOCK (source switching) ----------------
+static bool audioClockLocked(uint32_t nowUs) {
+  return AUDIO_BEAT_ENABLE && audioBeatStreak >= AUDIO_CLOCK_LOCK_BEATS &&
+         (uint32_t)(nowUs - lastAudioBeatUs) <= AUDIO_CLOCK_LOSS_US;
+}
+
+// Tracker takes the grid. The bar position is kept (MIDI_LOST: patterns run
+// on across the switch); a fresh start resets it before calling this.
+static void audioClockEngage(const char* why) {
+  audioClock = true;
+  audioBeatLowStreak = 0;
+  seenAnyClock = false;
+  lastClockUs = 0;
+  midiRunning = false;
+  tickInBeat = 0;
+  tempo.resync();
+  beatCommitCancel();
+  if (barCount == 0) { barCount = 1; beatInBar = 0; }
+  Serial.printf("EVENT CLOCK_SOURCE src=AUDIO why=%s pos=%lu.%u bpm=%.1f conf=%.2f\n",
+                why, (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                audioBeatBpm, audioBeatConf);
+}
+
+// Tracker lets go of the grid (to MIDI or NONE); the caller decides what runs next.
+static void audioClockRelease(const char* to, const char* why) {
+  if (!audioClock) return;
+  audioClock = false;
+  beatCommitCancel();
+  Serial.printf("EVENT CLOCK_SOURCE src=%s why=%s pos=%lu.%u bpm=%.1f conf=%.2f\n",
+                to, why,
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                audioBeatBpm, audioBeatConf);
+}
+
+// MIDI clock gone for good: audio clock if the tracker is locked, else FAIL
+static void onClockLost(uint32_t nowUs) {
+  if (audioClockLocked(nowUs)) { audioClockEngage("MIDI_LOST"); return; }
+  enterFailure(FAIL_CLOCK_LOST);
+}
+
 static void processFailureWatchdog() {
   const uint32_t nowUs = micros();
 
   const bool clockPresent = seenAnyClock && ((uint32_t)(nowUs - lastClockUs) <= CLOCK_LOSS_US);
   const bool audioPresent = seenAnyAudio && ((uint32_t)(nowUs - lastAudioUs) <= AUDIO_LOSS_US);
 
+  // --- Audio clock: no MIDI to lose; audio loss ends the set ---
+  if (audioClock) {
+    const bool audioLost = seenAnyAudio && ((uint32_t)(nowUs - lastAudioUs) > AUDIO_LOSS_US);
+    if (audioLost || (uint32_t)(nowUs - lastAudioBeatUs) > AUDIO_CLOCK_LOSS_US) {
+      audioClockRelease("NONE", "AUDIO_LOST");
+      enterMusicStop();
+    }
+    clearStopLatches();
+    return;
+  }
+
   // --- Recovery from SYS_FAIL ---
-  // SYS_FAIL is only entered on MIDI clock loss. As soon as clock returns,
-  // auto-recover. Audio may still be degraded — handled below.
+  // SYS_FAIL is only entered on MIDI clock loss the audio clock could not
+  // cover. As soon as clock returns, auto-recover; a locked audio clock also
+  // ends it. Audio may still be degraded — handled below.
   if (sysMode == SYS_FAIL) {
     if (clockPresent) {
       const uint32_t clockAgeMs = (uint32_t)((nowUs - lastClockUs) / 1000);
@@ -1211,7 +2797,12 @@ static void processFailureWatchdog() {
       // fall through: check degraded state with current signal conditions
     } else {
       clearStopLatches();
-      return; // still waiting for MIDI
+      if (audioClockLocked(nowUs)) {
+        sysMode = SYS_OK;
+        failReason = FAIL_NONE;
+        audioClockEngage("MIDI_LOST");
+      }
+      return; // still waiting for MIDI (or running on the audio clock)
     }
   }
 
@@ -1238,6 +2829,10 @@ static void processFailureWatchdog() {
     // Reset baseline for fast re-learning from the restored signal
     baseInited = false;
     baseRms = baseTr = baseKVar = baseKMean = 0.0f;
+    baseBand = BandFeatures();
+    last_intensity = -1.0f;
+    baselineQuantileReset();
+    baseProfileSessionReset();
     baselineReady = false;
     baselineQualifiedBars = 0;
   }
@@ -1278,21 +2873,156 @@ static void processFailureWatchdog() {
       clearStopLatches();
       return;
     }
-    // Not coincident: clock was lost independently → FAIL
-    enterFailure(FAIL_CLOCK_LOST);
+    // Not coincident: clock was lost independently → audio clock or FAIL
+    onClockLost(nowUs);
     clearStopLatches();
     return;
   }
 
   // Only clock latched: wait up to STOP_COINCIDE_US to see if audio also drops
   if ((uint32_t)(nowUs - clockLostAtUs) >= STOP_COINCIDE_US) {
-    enterFailure(FAIL_CLOCK_LOST); // audio didn't drop → pure MIDI loss
+    onClockLost(nowUs);            // audio didn't drop → pure MIDI loss
     clearStopLatches();
   }
 }
 
-static void onMidiBeat() {
-  const uint32_t nowUs = micros();
+// ---------------- Buildup pre-arm (every beat) ----------------
+// Downbeat of a pre-armed bar: enter DROP on the tick, ahead of the impact.
+static void buildupPrearmHit() {
+  dropPrearmBar = 0;
+  if (state != BREAK_CONFIRMED || !breakInited) return;
+  Serial.printf("EVENT DROP_PREARM_HIT pos=%lu.%u score=%.2f\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, buildup.score());
+  enterDrop("DROP_PREARMED", "BUILDUP_PREDICTED");
+  dropPrearmed = true;
+}
+
+// Beat closed: advance the detector; on beat 4 decide whether the coming
+// downbeat is prepared as DROP.
+static void buildupBeat() {
+  if (!BUILDUP_PREARM_ENABLE) return;
+  if (state != BREAK_CONFIRMED) {
+    dropPrearmBar = 0;
+    if (state == DROP && dropPrearmed) return;   // may be cancelled back to BREAK: keep the history
+    if (buildup.beats() > 0) buildup.reset();
+    dropPrearmed = false;
+    prearmMisses = 0;
+    prearmHoldBar = 0;
+    return;
+  }
+
+  if (buildup.onBeat()) {
+    Serial.printf("EVENT %s pos=%lu.%u score=%.2f tr=%.1f(%.2f) hh=%.1f(%.2f) tilt=%.1f(%.2f)\n",
+                  buildup.armed() ? "BUILDUP_ARMED" : "BUILDUP_DISARMED",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, buildup.score(),
+                  buildup.slopeDbPerBar(BUILDUP_TR),   buildup.fitR2(BUILDUP_TR),
+                  buildup.slopeDbPerBar(BUILDUP_HATS), buildup.fitR2(BUILDUP_HATS),
+                  buildup.slopeDbPerBar(BUILDUP_TILT), buildup.fitR2(BUILDUP_TILT));
+  }
+
+  dropPrearmBar = 0;
+  if (beatInBar != 4 || !buildup.armed() || !breakInited || returnActive) return;
+  const uint32_t next = barCount + 1;
+  const bool onPhrase = PHRASE_ENABLE && phrase.gridValid();
+  if (onPhrase) {
+    if (phrase.nextStart(barCount) != next) return;
+  } else {
+    if (breakAnchorBar == 0 || next <= breakAnchorBar || (next - breakAnchorBar) % BUILDUP_PHRASE_BARS != 0) return;
+  }
+  if (next <= prearmHoldBar) return;
+  dropPrearmBar = next;
+  Serial.printf("EVENT DROP_PREARM pos=%lu.%u bar=%lu grid=%s anchor=%lu misses=%u score=%.2f\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (unsigned long)next,
+                onPhrase ? "PHRASE" : "ANCHOR", (unsigned long)breakAnchorBar,
+                (unsigned)prearmMisses, buildup.score());
+}
+
+// ---------------- Phrase boundaries (per beat) ----------------
+// Beat 4: if the coming downbeat is on the phrase grid, the pattern window
+// ends there (before beatPrepare() runs that downbeat).
+static void phraseBeat() {
+  if (!PHRASE_ENABLE || beatInBar != 4) return;
+  const uint32_t next = barCount + 1;
+  if (phrase.nextStart(barCount) != next) return;
+  pp_phraseStart();
+  Serial.printf("EVENT PHRASE_START pos=%lu.%u bar=%lu phase=%u contrast=%.2f\n",
+                (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (unsigned long)next,
+                (unsigned)phrase.phase(), phrase.contrast());
+}
+
+// ---------------- WARM RESUME ----------------
+static void resumeStore(uint32_t beatUs) {
+  PartyResumeSnap& s = resumeSnap;
+  s.rtcBeatUs = resume_rtc_us() - (uint64_t)(micros() - beatUs);
+  s.barCount  = barCount;
+  s.beatInBar = beatInBar;
+  s.periodUs  = tempo.periodUs();
+  s.state     = (uint8_t)state;
+  s.baseOk    = baselineReady ? 1 : 0;
+  s.baseRms = baseRms; s.baseTr = baseTr; s.baseKVar = baseKVar; s.baseKMean = baseKMean;
+  for (uint8_t b = 0; b < BAND_COUNT; b++) { s.bandE[b] = baseBand.energy[b]; s.bandV[b] = baseBand.var[b]; }
+  s.breakOk   = (breakInited && !breakSeeded) ? 1 : 0;
+  s.breakRms = breakRms; s.breakTr = breakTr; s.breakKVar = breakKVar;
+  pp_snapshot(&s.pat);
+  resume_store(&s, sizeof(s));
+}
+
+// party_init() after resume_load(): restore what the snapshot holds
+static void resumeApply() {
+  const PartyResumeSnap& s = resumeSnap;
+  if (s.periodUs > 0) tempo.setPeriod(s.periodUs);
+  if (s.baseOk) {
+    baselineSeed(s.baseRms, s.baseTr, s.baseKVar, s.baseKMean, s.bandE, s.bandV);
+    baselineReady = true;
+    baselineQualifiedBars = BASELINE_READY_BARS;
+    baselineMarkReady("RESUME");
+    if (s.breakOk && s.state == BREAK_CONFIRMED) {
+      state = BREAK_CONFIRMED;
+      breakRms = s.breakRms; breakTr = s.breakTr; breakKVar = s.breakKVar;
+      breakInited = true;
+      intensityRefresh();
+      bpmHoldIntervalUs = s.periodUs;
+    }
+  }
+  pp_restore(s.pat);
+  barCount  = (s.barCount > 0) ? s.barCount : 1;  // until the first clock is placed
+  beatInBar = 0;
+  skipBarFinalize = true;
+  resumePhasePending = true;
+  Serial.printf("EVENT RESUME pos=%lu.%u state=%s bpm=%.1f base=%u break=%u pat=%s\n",
+                (unsigned long)s.barCount, (unsigned)s.beatInBar, ctxName(state),
+                (s.periodUs > 0) ? 60000000.0f / (float)s.periodUs : 0.0f,
+                (unsigned)s.baseOk, (unsigned)(state == BREAK_CONFIRMED),
+                pp_patternName(pp_activePattern()));
+}
+
+// First MIDI clock after a resume: this clock is `ticks` ticks after the
+// snapshot's downbeat on the RTC timer; continue the bar from there.
+static void resumeProjectPhase(uint32_t tickUs) {
+  resumePhasePending = false;
+  const PartyResumeSnap& s = resumeSnap;
+  const uint64_t rtcTick = resume_rtc_us() - (uint64_t)(micros() - tickUs);
+  if (rtcTick <= s.rtcBeatUs || s.periodUs == 0) return;
+  const uint64_t gapUs = rtcTick - s.rtcBeatUs;
+  if (gapUs > (uint64_t)RESUME_PHASE_MAX_MS * 1000ull) {
+    Serial.printf("EVENT RESUME_PHASE_SKIP gap_ms=%lu\n", (unsigned long)(gapUs / 1000));
+    return;
+  }
+  const float ticksF = (float)gapUs * 24.0f / (float)s.periodUs;
+  const uint32_t ticks = (uint32_t)lroundf(ticksF);
+  const uint32_t pos = (uint32_t)((s.beatInBar > 0) ? s.beatInBar - 1 : 0) + ticks / 24;
+  tickInBeat = (uint8_t)(ticks % 24);
+  barCount   = s.barCount + pos / 4;
+  beatInBar  = (uint8_t)(pos % 4 + 1);
+  if (tickInBeat == 0) beatInBar--;   // onMidiBeat() advances (0 -> 1 keeps the bar)
+  curBarForEvents  = barCount;
+  curBeatForEvents = beatInBar;
+  Serial.printf("EVENT RESUME_PHASE pos=%lu.%u tick=%u gap_ms=%lu ticks=%.2f\n",
+                (unsigned long)barCount, (unsigned)beatInBar, (unsigned)tickInBeat,
+                (unsigned long)(gapUs / 1000), ticksF);
+}
+
+static void onMidiBeat(uint32_t nowUs) {
 
   bool isBarStart = false;
   if (beatInBar == 0) { beatInBar = 1; isBarStart = true; }
@@ -1309,9 +3039,7 @@ static void onMidiBeat() {
     breakReset();
     clearReturnTracking();
     clearDropVerify();
-    candEnterBar = 0;
-    breakRecoveryBars = 0;
-    candDeepStreak = 0;
+    clearDecisionStreaks();
     dropOnsetBarStart = 0;
     dropEndBar = 0;
     logTransition(prev, state, "DROP_TIMEOUT_FROM_ONSET");
@@ -1320,44 +3048,225 @@ static void onMidiBeat() {
   // In FAIL state: suppress all audio analysis and visual output driven by beats.
   if (sysMode == SYS_FAIL) { ticksSinceBeat = 0; return; }
 
+  if (isBarStart && dropPrearmBar != 0 && dropPrearmBar == barCount) buildupPrearmHit();
+  buildupBeat();
+  phraseBeat();
+
+  // Rolling 4-beat window: probe every beat (decision latency, both modes);
+  // in DECIDE_PER_BEAT mode also decide on beats 2..4 (the downbeat decides
+  // through onBarFinalized(), whose bar is the same 4 beats).
+  beatRingPush();
+  CtxRatios roll;
+  if (baselineReady && !sysAudioDegraded && rollingRatios(&roll)) {
+    decisionProbe(roll, nowUs);
+    if (DECIDE_PER_BEAT && !isBarStart) contextStep(roll, GATE_BEAT);
+  }
+
   // finalize previous bar at start of current bar (barCount >= 2)
   if (isBarStart && barCount >= 2) {
-    finalizeBarNow(nowUs, barCount - 1);
+    if (skipBarFinalize) discardPartialBar();
+    else                 barFinalizeRequest(nowUs, barCount - 1);
+  }
+  if (isBarStart) skipBarFinalize = false;
+
+  const TempoBeat tb = tempoOnBeat(nowUs);
+
+  if (!beatCommitOnTick(nowUs)) {
+    pp_setContext(state, tempo.periodUs(), last_intensity);
+    pp_onBeat(barCount, beatInBar);
   }
+  logBeatLine(nowUs, isBarStart, tb);
 
-  pp_setContext(state, lastBeatIntervalUs);
-  pp_onBeat(barCount, beatInBar);
-  logBeatLine(nowUs, isBarStart);
+  if (!firstVisualsLogged) {
+    firstVisualsLogged = true;
+    const uint32_t ms = millis();
+    Serial.printf("EVENT FIRST_VISUALS pos=%lu.%u boot_ms=%lu entry_ms=%lu src=%s\n",
+                  (unsigned long)curBarForEvents, (unsigned)curBeatForEvents,
+                  (unsigned long)ms, (unsigned long)(ms - partyEntryMs), resumed ? "RESUME" : "COLD");
+  }
+  if (RESUME_ENABLE && isBarStart) resumeStore(nowUs);
 
   ticksSinceBeat = 0;
 }
 
 static void onMidiHalfBeat() { if (sysMode != SYS_FAIL) pp_onHalfBeat(); }
 
-static void processMidi() {
+// UART RX event handler (HardwareSerial event task): stamp and queue every byte.
+static void midiRxHandler() {
+  const uint32_t rxUs = micros();
   while (MidiSerial.available() > 0) {
-    const uint8_t b = (uint8_t)MidiSerial.read();
+    MidiRxByte e;
+    e.b = (uint8_t)MidiSerial.read();
+    e.rxUs = rxUs;
+    midiRing.push(e);
+  }
+  loopNotify(LOOP_EV_MIDI);
+}
 
-    if (b == 0xFA) { Serial.printf("[MIDI_START] t_us=%lu\n", (unsigned long)micros()); }
-    else if (b == 0xFB) { Serial.printf("[MIDI_CONTINUE] t_us=%lu\n", (unsigned long)micros()); }
-    else if (b == 0xFC) { Serial.printf("[MIDI_STOP] t_us=%lu\n", (unsigned long)micros()); }
-    else if (b == 0xF8) { // CLOCK
-      const uint32_t nowUs = micros();
-      lastClockUs = nowUs;
-      seenAnyClock = true;
+static void midiJitterReset() {
+  jitRx.reset();
+  jitPoll.reset();
+  jitHavePrev = false;
+  jitLagSum = 0;
+  jitLagMax = 0;
+}
 
-      if (!midiRunning) {
-        midiRunning = true;
-        if (barCount == 0) { barCount = 1; beatInBar = 0; }
-      }
+// Same tick, two clocks: arrival (RX handler) vs. drain (loop poll)
+static void midiJitterAdd(uint32_t rxUs, uint32_t pollUs) {
+  if (jitHavePrev) {
+    const uint32_t dtRx = rxUs - jitPrevRxUs;
+    if (dtRx <= CLOCK_LOSS_US) {        // skip gaps (stop / clock loss)
+      jitRx.add(dtRx);
+      jitPoll.add(pollUs - jitPrevPollUs);
+    }
+  }
+  jitHavePrev   = true;
+  jitPrevRxUs   = rxUs;
+  jitPrevPollUs = pollUs;
+  const uint32_t lag = pollUs - rxUs;
+  jitLagSum += lag;
+  if (lag > jitLagMax) jitLagMax = lag;
+}
+
+static void logMidiJitter() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < MIDI_JITTER_LOG_MS) return;
+  lastLogMs = ms;
+  if (jitRx.n < 2) return;
+  Serial.printf("MIDI_JITTER ticks=%lu stamp=%s rx_sd_us=%.1f rx_span_us=%lu..%lu "
+                "poll_sd_us=%.1f poll_span_us=%lu..%lu lag_us=%lu/%lu ring=%u/%u ovf=%lu\n",
+                (unsigned long)jitRx.n, MIDI_STAMP_AT_RX ? "rx" : "poll",
+                jitRx.sd(), (unsigned long)jitRx.minUs, (unsigned long)jitRx.maxUs,
+                jitPoll.sd(), (unsigned long)jitPoll.minUs, (unsigned long)jitPoll.maxUs,
+                (unsigned long)(jitLagSum / jitRx.n), (unsigned long)jitLagMax,
+                (unsigned)midiRing.highWater(), (unsigned)midiRing.capacity(),
+                (unsigned long)midiRing.overflows());
+  const bool havePrev = jitHavePrev;
+  midiJitterReset();
+  jitHavePrev = havePrev;                           // keep the interval chain
+}
 
-      if (tickInBeat == 0)  { onMidiBeat(); }
-      if (tickInBeat == 12) { onMidiHalfBeat(); }
+// Song Position Pointer: place bar / beat / tick so the next clock is the
+// first tick of 16th `spp` (6 clocks per 16th).
+static void midiSongPosition(uint16_t spp) {
+  resetForResumeLike();                     // re-align analysis; keeps baseline
+  const uint32_t bar  = (uint32_t)(spp / 16) + 1;
+  const uint8_t  six  = (uint8_t)(spp % 16);
+  const uint8_t  beat = (uint8_t)(six / 4 + 1);
+  barCount   = bar;
+  tickInBeat = (uint8_t)((six % 4) * GRID_TICKS_PER_SLOT);
+  if (tickInBeat == 0) beatInBar = (uint8_t)(beat - 1);   // onMidiBeat() advances (0 -> 1 keeps the bar)
+  else                 beatInBar = beat;                  // mid-beat: no beat event until the next one
+  gridSlot = six;
+  curBarForEvents  = barCount;
+  curBeatForEvents = beat;
+  skipBarFinalize  = true;
+}
+
+static void onMidiTransport(MidiMsgType t, uint16_t spp, uint32_t tUs) {
+  switch (t) {
+    case MIDI_MSG_START:                    // next clock = bar 1 beat 1
+      resetForResumeLike();
+      midiRunning = true;
+      midiStopped = false;
+      skipBarFinalize = true;
+      Serial.printf("EVENT MIDI_START pos=%lu.%u t_us=%lu\n",
+                    (unsigned long)barCount, (unsigned)beatInBar, (unsigned long)tUs);
+      break;
+    case MIDI_MSG_CONTINUE:                 // resume from the current / SPP position
+      midiRunning = true;
+      midiStopped = false;
+      tempo.resync();
+      Serial.printf("EVENT MIDI_CONTINUE pos=%lu.%u tick=%u t_us=%lu\n",
+                    (unsigned long)barCount, (unsigned)beatInBar, (unsigned)tickInBeat, (unsigned long)tUs);
+      break;
+    case MIDI_MSG_STOP:                     // hold position; clock may keep running
+      midiStopped = true;
+      beatCommitCancel();
+      Serial.printf("EVENT MIDI_STOP pos=%lu.%u tick=%u t_us=%lu\n",
+                    (unsigned long)barCount, (unsigned)beatInBar, (unsigned)tickInBeat, (unsigned long)tUs);
+      break;
+    case MIDI_MSG_SPP:
+      midiSongPosition(spp);
+      Serial.printf("EVENT MIDI_SPP spp=%u pos=%lu.%u tick=%u\n",
+                    (unsigned)spp, (unsigned long)curBarForEvents, (unsigned)curBeatForEvents, (unsigned)tickInBeat);
+      break;
+    default:
+      break;
+  }
+}
+
+static void logClockStats() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < CLOCK_STATS_LOG_MS) return;
+  lastLogMs = ms;
+  if (clkMinute.intervals() == 0 && clkMinute.drops() == 0) return;
+  char line[192];
+  clkMinute.summary(line, sizeof(line));
+  Serial.printf("CLOCK_STATS win=%lus %s\n", (unsigned long)(CLOCK_STATS_LOG_MS / 1000), line);
+  clkMinute.reset();
+}
 
-      tickInBeat = (uint8_t)((tickInBeat + 1) % 24);
-      ticksSinceBeat++;
+static void dumpClockSession() {
+  if (clkSession.intervals() == 0) return;
+  char line[512];
+  clkSession.summary(line, sizeof(line));
+  Serial.printf("CLOCK_STATS win=session %s\n", line);
+  clkSession.histogram(line, sizeof(line));
+  Serial.printf("CLOCK_HIST jit_us=%s\n", line);
+}
+
+static void processMidi() {
+  MidiRxByte e;
+  MidiMsg m;
+  while (midiRing.pop(e)) {
+    const uint32_t pollUs = micros();
+    const uint32_t tUs = MIDI_STAMP_AT_RX ? e.rxUs : pollUs;
+    loopLat[LOOP_EV_MIDI].add(pollUs - e.rxUs);
+
+    const MidiMsgType t = midiParser.push(e.b, &m);
+    if (t == MIDI_MSG_NONE || t == MIDI_MSG_CHANNEL || t == MIDI_MSG_SYSTEM) continue;
+    if (t != MIDI_MSG_CLOCK) { onMidiTransport(t, m.spp, tUs); continue; }
+
+    // CLOCK
+    const uint32_t nowUs = tUs;
+    if (audioClock) {                     // MIDI wins: next tick is a beat
+      audioClockRelease("MIDI", "MIDI");
+      tempo.resync();
+      tickInBeat = 0;
+    }
+    if (resumePhasePending) resumeProjectPhase(nowUs);
+    lastClockUs = nowUs;
+    seenAnyClock = true;
+    midiJitterAdd(e.rxUs, pollUs);
+    clkMinute.add(nowUs);
+    clkSession.add(nowUs);
+    if (midiStopped) continue;            // transport stopped: position holds
+
+    if (!midiRunning) {
+      midiRunning = true;
+      if (barCount == 0) { barCount = 1; beatInBar = 0; }
     }
+
+    if (tickInBeat == 0) {
+      if (AUDIO_OFFSET_ENABLE && offsetEst.onBeat(nowUs)) audioOffsetUpdate();
+      onMidiBeat(nowUs);
+    }
+    if (tickInBeat == 12) { onMidiHalfBeat(); }
+    if (tickInBeat == BEAT_PREP_TICK) { beatPrepare(); }
+
+    gridSlot = (uint8_t)(((beatInBar > 0) ? (beatInBar - 1) * 4 : 0) + tickInBeat / GRID_TICKS_PER_SLOT);
+    if (tickInBeat % GRID_TICKS_PER_SLOT == 0) gridMarkAdd(nowUs, gridSlot);
+
+    tickInBeat = (uint8_t)((tickInBeat + 1) % 24);
+    ticksSinceBeat++;
   }
+  logMidiJitter();
+  logBeatCommit();
+  logClockStats();
+  if (AUDIO_OFFSET_ENABLE) logAudioOffset();
 }
 
 // ---------------- I2S INIT ----------------
@@ -1369,8 +3278,8 @@ static void i2sInit() {
   cfg.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
   cfg.communication_format = I2S_COMM_FORMAT_STAND_I2S;
   cfg.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
-  cfg.dma_buf_count = 6;
-  cfg.dma_buf_len = 256;
+  cfg.dma_buf_count = I2S_DMA_BUF_COUNT;
+  cfg.dma_buf_len = I2S_DMA_BUF_LEN;
   cfg.use_apll = false;
 
   i2s_pin_config_t pins = {};
@@ -1379,65 +3288,377 @@ static void i2sInit() {
   pins.data_out_num = I2S_PIN_NO_CHANGE;
   pins.data_in_num = I2S_PIN_DATA;
 
-  ESP_ERROR_CHECK(i2s_driver_install(I2S_PORT, &cfg, 0, nullptr));
+  // Driver event queue: one I2S_EVENT_RX_DONE per completed DMA descriptor
+  ESP_ERROR_CHECK(i2s_driver_install(I2S_PORT, &cfg, I2S_EVENT_QUEUE_LEN, &i2sEventQueue));
   ESP_ERROR_CHECK(i2s_set_pin(I2S_PORT, &pins));
   ESP_ERROR_CHECK(i2s_zero_dma_buffer(I2S_PORT));
 }
 
-// ---------------- AUDIO PROCESS ----------------
-static void processAudio() {
-  static int32_t buf[I2S_READ_FRAMES * 2];
-  size_t bytesRead = 0;
+// ---------------- FILTER BANK (audio task) ----------------
+// ---------------- AUDIO TASK BODY (core 0) ----------------
+// endFrame: first frame after the segment
+static void audioSegPush(AudioSegment& seg, uint32_t epoch, bool winEnd, uint64_t endFrame) {
+  seg.endUs = micros();
+  seg.midUs = sampleClock.valid() ? sampleClock.usAt((segStartFrame + endFrame) / 2) : seg.endUs;
+  segStartFrame = endFrame;
+  seg.epoch = epoch;
+  seg.winEnd = winEnd;
+  audioRing.push(seg);
+  seg.acc.reset();
+  seg.bank.reset();
+  seg.onset.reset();
+  seg.shadow.reset();
+  seg.beat.kind = ABEAT_NONE;
+  seg.barSplit = 0;
+  seg.splitLateUs = 0;
+}
 
-  if (i2s_read(I2S_PORT, buf, sizeof(buf), &bytesRead, 5 / portTICK_PERIOD_MS) != ESP_OK || bytesRead == 0)
-    return;
+// One completed descriptor without waiting; 0 if none is ready
+static size_t i2sReadNow(int32_t* dst) {
+  static constexpr size_t BYTES = I2S_READ_FRAMES * 2 * sizeof(int32_t);
+  size_t bytes = 0;
+  if (i2s_read(I2S_PORT, dst, BYTES, &bytes, 0) != ESP_OK) return 0;
+  if (bytes > 0 && bytes < BYTES) i2sShortReads++;
+  return bytes;
+}
+
+static void audioTask(void*) {
+  static int32_t bufs[2][I2S_READ_FRAMES * 2];   // current block + lookahead
+  AudioSegment seg = {};
+  uint32_t winFill = 0;          // samples into the current monitor window
+  uint32_t epoch = audioEpoch.load();
+  uint64_t frameCount = 0;       // frames captured since the task started (timebase)
+  uint32_t splitSeq = barSplitSeq.load();
+  uint64_t splitAt = 0;          // frame the pending bar boundary falls on
+  bool     splitArmed = false;
+
+  while (audioTaskRun) {
+    // Sleep until the driver reports a completed descriptor; the 20 ms bound
+    // only exists so audioTaskStop() is noticed when the I2S clock is absent.
+    i2s_event_t evt;
+    if (xQueueReceive(i2sEventQueue, &evt, 20 / portTICK_PERIOD_MS) != pdTRUE) continue;
+    if (evt.type == I2S_EVENT_RX_Q_OVF) {
+      // The driver dropped its oldest unread descriptor. Its frames still
+      // advance the timebase, so audio time stays continuous over the gap.
+      i2sDmaDropped++;
+      frameCount += (uint64_t)I2S_READ_FRAMES;
+    } else if (evt.type == I2S_EVENT_DMA_ERROR) {
+      i2sDmaErrors++;
+      continue;
+    } else if (evt.type != I2S_EVENT_RX_DONE) {
+      continue;
+    }
+
+    // Drain every completed descriptor, not one per event: the event queue
+    // is only I2S_EVENT_QUEUE_LEN deep and the driver drops its oldest events
+    // when it is full, so one read per event would leave a standing backlog
+    // that delays every later block. Events for descriptors already drained
+    // just read nothing. A lookahead read tells whether a block is the newest
+    // one (arrived ~ now: SampleClock observes it) or backlog.
+    uint8_t  cur = 0;
+    size_t   bytesRead = i2sReadNow(bufs[cur]);
+    uint32_t readUs = micros();
+    while (bytesRead > 0) {
+      const int32_t* buf = bufs[cur];
+      const size_t   nextBytes = i2sReadNow(bufs[cur ^ 1]);
+      const uint32_t nextUs = micros();
+      const bool     newest = (nextBytes == 0);
+      if (!newest) i2sBacklog++;
+      i2sDmaBlocks++;
+
+      const uint32_t e = audioEpoch.load();
+      if (e != epoch) {
+        epoch = e;
+        envDecim.reset();
+        envLP.reset();
+        trHP.reset();
+        bank.reset();
+        onset_reset();
+        seg.acc.reset();
+        seg.bank.reset();
+        seg.onset.reset();
+        seg.shadow.reset();
+        segStartFrame = frameCount;
+        winFill = 0;
+        splitArmed = false;
+      }
 
-  const int frames = (bytesRead / 4) / 2;
+      const int frames = (bytesRead / 4) / 2;
+      const uint64_t blockStart = frameCount;
+      frameCount += (uint64_t)frames;
+      if (newest) sampleClock.observe(frameCount, readUs);   // ~ when its last sample arrived
+
+      // Bar boundary: close a segment right before its frame. A frame already
+      // consumed (the loop was late) splits at the start of this block.
+      const uint32_t req = barSplitSeq.load();
+      if (req != splitSeq) {
+        splitSeq = req;
+        splitAt = sampleClock.sampleAt(barSplitUs.load());
+        splitArmed = true;
+      }
+      int splitIdx = -1;
+      if (splitArmed && splitAt < frameCount) {
+        splitArmed = false;
+        if (splitAt > blockStart) {
+          splitIdx = (int)(splitAt - blockStart);
+          seg.splitLateUs = 0;
+        } else {
+          splitIdx = 0;
+          seg.splitLateUs = (uint32_t)((blockStart - splitAt) * 1000000ull / I2S_SAMPLE_RATE);
+        }
+      }
+      uint32_t cycBlock0 = 0, cycBank = 0, cycOnset = 0, onsetHops = 0;
+      if (DEBUG_AUDIO_CYCLES) cycBlock0 = ESP.getCycleCount();
 
-  for (int i = 0; i < frames; i++) {
-    const int32_t vL = buf[i * 2 + 0] >> 8;
-    const int32_t vR = buf[i * 2 + 1] >> 8;
-    const float x = 0.5f * ((float)vL + (float)vR) * (1.0f / 8388608.0f);
+      for (int i = 0; i < frames; i++) {
+        if (i == splitIdx) {
+          seg.barSplit = splitSeq;
+          audioSegPush(seg, epoch, false, blockStart + (uint64_t)i);
+        }
 
-    const float ax = fabsf(x);
+        const int32_t vL = buf[i * 2 + 0] >> 8;
+        const int32_t vR = buf[i * 2 + 1] >> 8;
+        const int32_t xQ24 = vL + vR;                       // 0.5*(L+R) in Q24, exact
+        const float x = (float)xQ24 * (1.0f / 16777216.0f);
 
-    const float hp = HP_ALPHA * (hp_y + x - hp_x_prev);
-    hp_x_prev = x;
-    hp_y = hp;
-    const float trAx = fabsf(hp);
+        const float trAx = fabsf(trHP.process(x));
 
-    envLP += LP_ENV_ALPHA * (ax - envLP);
+        seg.acc.add(xQ24, fa_toQ28(trAx));
 
-    barSumSq += (double)(x * x);
-    barTrSum += (double)trAx;
-    barKickW.update((double)envLP);
-    barN++;
+        // Kick envelope at fs / ENV_DECIM
+        float envIn;
+        const uint32_t axQ21 = (uint32_t)((xQ24 < 0) ? -xQ24 : xQ24) >> 3;
+        if (envDecim.push(axQ21, &envIn)) {
+          const float env = envLP.process(envIn);
+          seg.acc.addEnv(fa_toQ28(env));
+          if (DEBUG_ACC_SHADOW) seg.shadow.updateEnv(env);
+        }
 
-    winSumSq += (double)(x * x);
-    winTrSum += (double)trAx;
-    winKickW.update((double)envLP);
-    winN++;
+        // Filter bank (same env-rate tick as the CIC above: both run in phase)
+        uint32_t c0 = 0;
+        if (DEBUG_AUDIO_CYCLES) c0 = ESP.getCycleCount();
+        bank.push(xQ24, seg.bank);
+        if (DEBUG_AUDIO_CYCLES) cycBank += ESP.getCycleCount() - c0;
+
+        if (ONSET_FFT_ENABLE) {
+          if (DEBUG_AUDIO_CYCLES) c0 = ESP.getCycleCount();
+          float flux[ONSET_BANDS];
+          if (onset_push(x, flux)) {
+            seg.onset.add(flux);
+            // Hop centre in audio time: the flux peaks in the hop its onset fell in
+            seg.hopUs = sampleClock.usAt(blockStart + (uint64_t)(i + 1) - ONSET_HOP / 2);
+            AudioBeatEvent ev;
+            if (AUDIO_BEAT_ENABLE &&
+                abeat_push(AUDIO_BEAT_LOW_WEIGHT * flux[ONSET_LOW] + flux[ONSET_MID] + flux[ONSET_HIGH], &ev)) {
+              seg.beat = ev;
+              seg.beatUs = seg.hopUs - (uint32_t)(ev.lateHops * (float)ONSET_HOP * (1000000.0f / I2S_SAMPLE_RATE));
+            }
+            if (DEBUG_AUDIO_CYCLES) { cycOnset += ESP.getCycleCount() - c0; onsetHops++; }
+          }
+        }
 
-    if (winN >= WIN_SAMPLES) {
-      const float winRms  = sqrtf((float)(winSumSq / (double)winN));
-      const float winTr   = (float)(winTrSum / (double)winN);
-      const float winKVar = winKickW.var();
+        if (DEBUG_ACC_SHADOW) seg.shadow.update(x, trAx);
 
-      lastWinRms = winRms;
-      lastWinTr  = winTr;
-      lastWinKVar = winKVar;
-      lastWinUs = micros();
+        if (++winFill >= WIN_SAMPLES) {
+          audioSegPush(seg, epoch, true, blockStart + (uint64_t)(i + 1));
+          winFill = 0;
+        }
+      }
 
-      if (winRms >= AUDIO_PRESENT_MIN_RMS) {
-        lastAudioUs = lastWinUs;
-        seenAnyAudio = true;
+      if (DEBUG_AUDIO_CYCLES && frames > 0) {
+        const float perSample = (float)(ESP.getCycleCount() - cycBlock0) / (float)frames;
+        audioCycPerSample += (perSample - audioCycPerSample) * (1.0f / 64.0f);
+        bankCycPerSample  += ((float)cycBank / (float)frames - bankCycPerSample) * (1.0f / 64.0f);
+        if (onsetHops > 0)
+          onsetCycPerHop += ((float)cycOnset / (float)onsetHops - onsetCycPerHop) * (1.0f / 64.0f);
       }
 
-      onMonitorWindow(winRms, winTr, winKVar);
+      if (seg.acc.n > 0) audioSegPush(seg, epoch, false, frameCount);
+      loopNotify(LOOP_EV_AUDIO);
+
+      cur ^= 1;
+      bytesRead = nextBytes;
+      readUs = nextUs;
+    }
+  }
+
+  portENTER_CRITICAL(&audioTaskMux);
+  const bool mine = (audioTaskHandle != nullptr);
+  audioTaskHandle = nullptr;
+  portEXIT_CRITICAL(&audioTaskMux);
+  if (mine) vTaskDelete(nullptr);
+  for (;;) vTaskDelay(portMAX_DELAY);   // audioTaskStop() timed out and deletes us
+}
+
+static void audioTaskStart() {
+  audioRing.reset();
+  sampleClock.reset();
+  segStartFrame = 0;                 // the task counts frames from 0
+  bank.reset();
+  onset_init(I2S_SAMPLE_RATE);
+  abeat_init((float)I2S_SAMPLE_RATE / (float)ONSET_HOP);
+  audioCycPerSample = bankCycPerSample = onsetCycPerHop = 0.0f;
+  i2sDmaBlocks = i2sDmaDropped = i2sDmaErrors = i2sShortReads = i2sBacklog = 0;
+  audioTaskRun = true;
+  xTaskCreatePinnedToCore(audioTask, "party_audio", AUDIO_TASK_STACK, nullptr,
+                          AUDIO_TASK_PRIO, &audioTaskHandle, AUDIO_TASK_CORE);
+}
+
+// Returns with the task gone, so the driver can be uninstalled. A task that
+// has not left the read loop after 200 ms (stuck in i2s_read or the event
+// queue) is deleted from here: uninstalling under it would free the DMA
+// buffers and the queue it is blocked on.
+static void audioTaskStop() {
+  audioTaskRun = false;
+  const uint32_t t0 = millis();
+  while (audioTaskHandle != nullptr && (millis() - t0) < 200) delay(1);
+
+  portENTER_CRITICAL(&audioTaskMux);
+  TaskHandle_t h = audioTaskHandle;
+  audioTaskHandle = nullptr;
+  portEXIT_CRITICAL(&audioTaskMux);
+  if (h != nullptr) {
+    Serial.printf("EVENT AUDIO_TASK_KILLED wait_ms=%lu\n", (unsigned long)(millis() - t0));
+    vTaskDelete(h);
+  }
+}
+
+// ---------------- AUDIO PROCESS (loop core: drain ring) ----------------
+static void onAudioWindowClosed(uint32_t stampUs) {
+  const float winRms  = winAcc.rms();
+  const float winTr   = winAcc.tr();
+  const float winKVar = winAcc.kVar();
+  const BandFeatures winBands = bankFeatures(winBank);
+
+  if (DEBUG_ACC_SHADOW) {
+    const float e = fmaxf(fmaxf(shadowErr(winRms, winShadow.rms()),
+                                shadowErr(winTr,  winShadow.tr())),
+                          shadowErr(winKVar, winShadow.kickW.var()));
+    if (e > shadowWinMaxErr) shadowWinMaxErr = e;
+  }
+
+  lastWinRms = winRms;
+  lastWinTr  = winTr;
+  lastWinKVar = winKVar;
+  lastWinOnset = winOnset.strength();
+  for (uint8_t b = 0; b < ONSET_BANDS; b++) lastWinOnsetBand[b] = winOnset.band(b);
+  lastWinUs = stampUs;
+
+  if (winRms >= AUDIO_PRESENT_MIN_RMS) {
+    lastAudioUs = lastWinUs;
+    seenAnyAudio = true;
+  }
+
+  onMonitorWindow(winRms, winTr, winKVar, winBands);
+
+  barAcc.mergeSince(winAcc, winBarMark);
+  barBank.mergeSince(winBank, winBankMark);
+  beatAcc.mergeSince(winAcc, winBeatMark);
+  resetWinAcc();
+}
+
+static void logAudioRing() {
+  static uint32_t lastLogMs = 0;
+  static uint32_t lastOvf = 0, lastDmaDrop = 0;
+  const uint32_t ms = millis();
+  const uint32_t ovf = audioRing.overflows();
+  const uint32_t dmaDrop = i2sDmaDropped;
+  if (ovf == lastOvf && dmaDrop == lastDmaDrop && (uint32_t)(ms - lastLogMs) < AUDIO_RING_LOG_MS) return;
+  lastLogMs = ms;
+  Serial.printf("AUDIO_RING hwm=%u/%u ovf=%lu dma=%lu dmaDrop=%lu dmaErr=%lu short=%lu backlog=%lu%s%s\n",
+                (unsigned)audioRing.highWater(), (unsigned)audioRing.capacity(),
+                (unsigned long)ovf, (unsigned long)i2sDmaBlocks, (unsigned long)dmaDrop,
+                (unsigned long)i2sDmaErrors, (unsigned long)i2sShortReads, (unsigned long)i2sBacklog,
+                (ovf != lastOvf) ? " OVERFLOW" : "", (dmaDrop != lastDmaDrop) ? " DMA_DROP" : "");
+  if (DEBUG_AUDIO_CYCLES) {
+    const uint32_t cpuHz = ESP.getCpuFreqMHz() * 1000000UL;
+    Serial.printf("AUDIO_CYCLES perSample=%.0f bank=%.0f budget=%lu onsetHop=%.0f win=%lu/%lu\n",
+                  audioCycPerSample, bankCycPerSample, (unsigned long)(cpuHz / I2S_SAMPLE_RATE),
+                  onsetCycPerHop,
+                  (unsigned long)(audioCycPerSample * (float)WIN_SAMPLES),
+                  (unsigned long)(cpuHz / 1000UL * MONITOR_WIN_MS));
+  }
+  lastOvf = ovf;
+  lastDmaDrop = dmaDrop;
+}
+
+// ---------------- AUDIO CLOCK (tracker events, loop core) ----------------
+// 16th of the bar from the time since the last tracker beat (no clock ticks)
+static uint8_t audioGridSlot(uint32_t nowUs) {
+  const uint32_t per = tempo.periodUs();
+  uint32_t q = (per > 0) ? (uint32_t)((uint64_t)(nowUs - lastAudioBeatUs) * 4u / per) : 0;
+  if (q > 3) q = 3;
+  return (uint8_t)(((beatInBar > 0) ? (beatInBar - 1) * 4 : 0) + q);
+}
 
-      resetWinAcc();
+static void onAudioBeat(const AudioBeatEvent& ev, uint32_t atUs) {
+  if (ev.kind == ABEAT_BEAT) {
+    lastAudioBeatUs = atUs;
+    audioBeatBpm  = ev.bpm;
+    audioBeatConf = ev.conf;
+    if (ev.conf >= AUDIO_CLOCK_CONF_ON) { if (audioBeatStreak < 255) audioBeatStreak++; }
+    else audioBeatStreak = 0;
+    if (ev.conf < AUDIO_CLOCK_CONF_OFF) { if (audioBeatLowStreak < 255) audioBeatLowStreak++; }
+    else audioBeatLowStreak = 0;
+  }
+  if (seenAnyClock) return;                  // MIDI clock owns the grid (also in FAIL)
+
+  if (!audioClock) {
+    if (ev.kind != ABEAT_BEAT || !audioClockLocked(atUs)) return;
+    resetForResumeLike();
+    audioClockEngage("NO_MIDI");
+  } else if (audioBeatLowStreak >= AUDIO_CLOCK_DROP_BEATS) {
+    audioClockRelease("NONE", "LOW_CONF");
+    resetForResumeLike();
+    noMidiStartMs = millis();                // back to the GREEN wait with a full window
+    return;
+  }
+
+  if (ev.kind == ABEAT_BEAT) {
+    onMidiBeat(atUs);
+    gridSlot = audioGridSlot(atUs);
+    gridMarkAdd(atUs, gridSlot);
+  } else {
+    onMidiHalfBeat();
+  }
+}
+
+static void logAudioBeat() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < AUDIO_BEAT_LOG_MS) return;
+  lastLogMs = ms;
+  Serial.printf("AUDIO_BEAT bpm=%.1f conf=%.2f streak=%u src=%s\n",
+                audioBeatBpm, audioBeatConf, (unsigned)audioBeatStreak,
+                audioClock ? "AUDIO" : (seenAnyClock ? "MIDI" : "NONE"));
+}
+
+// discard=true: drain without analysis (no clock yet); tracker events are
+// still handled so the audio clock can lock.
+static void processAudio(bool discard) {
+  AudioSegment seg;
+  while (audioRing.pop(seg)) {
+    loopLat[LOOP_EV_AUDIO].add(micros() - seg.endUs);
+    if (AUDIO_OFFSET_ENABLE && seg.onset.frames > 0) offsetEst.addOnset(seg.hopUs, seg.onset.band(ONSET_LOW));
+    if (!discard && seg.epoch == audioEpoch.load()) {
+      winAcc.merge(seg.acc);
+      gridAcc[gridSlotAt(seg.midUs)].merge(seg.acc);
+      winBank.merge(seg.bank);
+      winOnset.merge(seg.onset);
+      if (DEBUG_ACC_SHADOW) { winShadow.merge(seg.shadow); barShadow.merge(seg.shadow); }
+
+      if (seg.winEnd) onAudioWindowClosed(seg.endUs);
+      if (seg.barSplit != 0) barSplitOnSegment(seg);
     }
+    // After the merge: a downbeat sees the segment it falls in, like a MIDI beat
+    if (AUDIO_BEAT_ENABLE && seg.beat.kind != ABEAT_NONE) onAudioBeat(seg.beat, seg.beatUs);
+  }
+  if (BAR_SPLIT_ENABLE) {
+    barSplitCheckTimeout(micros());
+    logBarSplit();
   }
+  logAudioRing();
+  if (AUDIO_BEAT_ENABLE) logAudioBeat();
 }
 
 // ---------------- BUTTONS (RED universal reset) ----------------
@@ -1490,40 +3711,129 @@ static void processButtons() {
   redWasPressed = redIsPressed;
 }
 
+// ---------------- EVENT LOOP (loop core: wait) ----------------
+static void loopEventsStart() {
+  for (uint8_t i = 0; i < LOOP_EV_COUNT; i++) loopLat[i].reset();
+  loopWakes = 0;
+  btnEdgeUs = 0;
+  btnSettleUntilMs = 0;
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+  xTaskNotifyStateClear(loopTaskHandle);
+  for (uint8_t i = 0; i < 4; i++) attachInterrupt(digitalPinToInterrupt(HW_BTN_PIN[i]), btnEdgeIsr, CHANGE);
+}
+
+static void loopEventsStop() {
+  for (uint8_t i = 0; i < 4; i++) detachInterrupt(digitalPinToInterrupt(HW_BTN_PIN[i]));
+  loopTaskHandle = nullptr;
+}
+
+static void logLoopEvents() {
+  static uint32_t lastLogMs = 0;
+  const uint32_t ms = millis();
+  if ((uint32_t)(ms - lastLogMs) < LOOP_EVENTS_LOG_MS) return;
+  lastLogMs = ms;
+  const EventLatency* l = loopLat;
+  Serial.printf("LOOP_EVENTS wakes=%lu audio_us=%lu/%lu(%lu) midi_us=%lu/%lu(%lu) "
+                "btn_us=%lu/%lu(%lu) render_late_us=%lu/%lu(%lu)\n",
+                (unsigned long)loopWakes,
+                (unsigned long)l[LOOP_EV_AUDIO].meanUs(),  (unsigned long)l[LOOP_EV_AUDIO].maxUs,  (unsigned long)l[LOOP_EV_AUDIO].n,
+                (unsigned long)l[LOOP_EV_MIDI].meanUs(),   (unsigned long)l[LOOP_EV_MIDI].maxUs,   (unsigned long)l[LOOP_EV_MIDI].n,
+                (unsigned long)l[LOOP_EV_BTN].meanUs(),    (unsigned long)l[LOOP_EV_BTN].maxUs,    (unsigned long)l[LOOP_EV_BTN].n,
+                (unsigned long)l[LOOP_EV_RENDER].meanUs(), (unsigned long)l[LOOP_EV_RENDER].maxUs, (unsigned long)l[LOOP_EV_RENDER].n);
+  for (uint8_t i = 0; i < LOOP_EV_COUNT; i++) loopLat[i].reset();
+  loopWakes = 0;
+}
+
+// End of party_tick(): sleep until an event bit is set or the render deadline.
+static void loopWaitEvent() {
+  logLoopEvents();
+  if (!LOOP_EVENT_WAIT) { delay(1); return; }
+
+  const uint32_t sleepUs = micros();
+  uint32_t waitUs = LOOP_RENDER_US;
+  if ((int32_t)(millis() - btnSettleUntilMs) < 0) waitUs = 1000;   // debounce polling
+  const uint32_t deadlineUs = sleepUs + waitUs;
+
+  uint32_t bits = 0;
+  xTaskNotifyWait(0, 0xFFFFFFFFu, &bits, pdMS_TO_TICKS((waitUs + 999) / 1000));
+  const uint32_t wakeUs = micros();
+  loopWakes++;
+
+  if (bits & (1u << LOOP_EV_BTN)) {
+    const uint32_t edgeUs = btnEdgeUs;
+    btnEdgeUs = 0;
+    if (edgeUs != 0) loopLat[LOOP_EV_BTN].add(wakeUs - edgeUs);
+    btnSettleUntilMs = millis() + LOOP_BTN_SETTLE_MS;
+  }
+  if (bits == 0 && (int32_t)(wakeUs - deadlineUs) >= 0) loopLat[LOOP_EV_RENDER].add(wakeUs - deadlineUs);
+}
+
 // ---------------- MODE INTERFACE ----------------
 void party_init() {
-  Serial.println("[PARTY] Entered Party Mode.");
-
-  // Party mode splash: 2× all-wing pulse
-  uint8_t on[4] = {180, 180, 180, 180};
-  uint8_t off4[4] = {0, 0, 0, 0};
-  for (int f = 0; f < 2; f++) { hw_led_all_set(on); delay(150); hw_led_all_set(off4); delay(100); }
+  partyEntryMs = millis();
+  firstVisualsLogged = false;
+  resumePhasePending = false;
+  resumed = RESUME_ENABLE && resume_load(&resumeSnap, sizeof(resumeSnap));
+  Serial.println(resumed ? "[PARTY] Resuming Party Mode (RTC snapshot)." : "[PARTY] Entered Party Mode.");
+
+  // Party mode splash: 2× all-wing pulse (skipped on resume: music is playing)
+  if (!resumed) {
+    uint8_t on[4] = {180, 180, 180, 180};
+    uint8_t off4[4] = {0, 0, 0, 0};
+    for (int f = 0; f < 2; f++) { hw_led_all_set(on); delay(150); hw_led_all_set(off4); delay(100); }
+  }
 
 #ifndef USE_WOKWI
   // DFPlayer is left running during party mode (~45mA).
   // Sleep mode was removed — reliable wake-from-sleep via UART requires
   // hardware investigation (MOSFET on VCC) before re-enabling.
 #endif
+  midiRing.reset();
+  midiJitterReset();
+  midiParser.reset();
+  clkMinute.reset();
+  clkSession.reset();
+  offsetEst.reset();
+  audioOffsetLoad();
+  if (BASE_PROFILE_ENABLE) baseProfilesLoad();
+  baselineQuantileReset();           // histogram horizons; the rest starts cleared (or by party_stop)
+  baseProfileSessionReset();
+  if (resumed) resumeApply();
+  tempo.setAcceptHook(clockHoldAccept);
+  if (!beatCommitTimer) {
+    esp_timer_create_args_t targs = {};
+    targs.callback = beatCommitTimerCb;
+    targs.dispatch_method = ESP_TIMER_TASK;
+    targs.name = "beatCommit";
+    ESP_ERROR_CHECK(esp_timer_create(&targs, &beatCommitTimer));
+  }
+  loopEventsStart();                  // before any producer can notify
   MidiSerial.begin(MIDI_BAUD_RATE, SERIAL_8N1, MIDI_PIN_RX, -1);
+  MidiSerial.setRxFIFOFull(1);        // RX event per byte: stamp = arrival, not FIFO batch
+  MidiSerial.onReceive(midiRxHandler);
 
   i2sInit();
   resetBarAcc();
+  resetBeatRing();
   resetWinAcc();
+  audioTaskStart();
 
   curBarForEvents = 0;
   curBeatForEvents = 0;
   noMidiStartMs = millis();
 
   Serial.printf("[PARTY] MIDI: listening on pin %d at %d bps\n", MIDI_PIN_RX, MIDI_BAUD_RATE);
+  Serial.printf("[PARTY] Audio/MIDI offset: %ld us (NVS)\n", (long)audioOffsetUs);
   Serial.println("[PARTY] I2S: initialized.");
   Serial.printf("[PARTY] Visual patterns: %d loaded.\n", PAT_COUNT);
   Serial.println("[PARTY] Waiting for MIDI clock...");
 }
 
 void party_tick() {
+  processAudio(!seenAnyClock && !audioClock);  // drain the audio ring first so a downbeat sees every merged segment
   processMidi(); // always runs — detects first MIDI tick and sets seenAnyClock
 
-  if (!seenAnyClock) {
+  if (!seenAnyClock && !audioClock) {
     // Waiting for MIDI clock: flash GREEN slowly (500ms on/off)
     const uint32_t ms = millis();
     hw_led_duty(GREEN, ((ms / 500) & 1) ? 180 : 0);
@@ -1535,24 +3845,34 @@ void party_tick() {
       delay(200);
       ESP.restart();
     }
+    loopWaitEvent();
     return;
   }
 
-  processAudio();
   processFailureWatchdog();
   processButtons();
   visualsRender();
-  delay(1);
+  nvsIdleService();
+  loopWaitEvent();
 }
 
 void party_stop() {
+  dumpClockSession();
+  audioOffsetSave();
+  baseProfilesSave();
+  resume_clear();                    // deliberate exit: the next boot selects a mode
   hw_led_all_off();                          // zero all LED duties immediately
   resetForHardReset();               // reset FSM, baselines, accumulators, visuals
-  i2s_driver_uninstall(I2S_PORT);   // free DMA buffers
+  audioTaskStop();                   // audio task must be out of i2s_read before uninstall
+  i2s_driver_uninstall(I2S_PORT);   // free DMA buffers (and the driver event queue)
+  i2sEventQueue = nullptr;
+  MidiSerial.onReceive(nullptr);     // stop the RX handler before the ring goes idle
   MidiSerial.end();                  // release UART1 so Game Mode can use it for DFPlayer
+  loopEventsStop();
 
   // Reset failure-tracking state not covered by resetForHardReset()
   midiRunning        = false;
+  midiStopped        = false;
   sysMode            = SYS_OK;
   failReason         = FAIL_NONE;
   sysAudioDegraded   = false;
@@ -1561,6 +3881,9 @@ void party_stop() {
   seenAnyAudio       = false;
   clockLostLatched   = false;
   audioLostLatched   = false;
+  audioClock         = false;
+  audioBeatStreak    = 0;
+  audioBeatLowStreak = 0;
 
   Serial.println("[PARTY] Mode stopped.");
 }
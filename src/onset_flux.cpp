@@ -0,0 +1,159 @@
+#include "onset_flux.h"
+#include <math.h>
+
+static constexpr uint16_t FFT_M  = ONSET_FFT_N / 2;    // complex FFT size
+static constexpr uint16_t N_BINS = ONSET_FFT_N / 2 + 1;
+static_assert(ONSET_FFT_N == 512 && ONSET_HOP == 256, "radix-4 digit reversal below is for a 256-point complex FFT");
+
+// Magnitude scale: 2 / sum(hann) so a full-scale sine reads 1.0
+static constexpr float MAG_NORM = 2.0f / (ONSET_FFT_N / 2);
+
+// sinf(2*pi*k/512), k = 0..128 (quarter wave; the rest by symmetry)
+static const float SIN_Q[129] = {
+  0.000000000f, 0.012271538f, 0.024541229f, 0.036807223f, 0.049067674f, 0.061320736f,
+  0.073564564f, 0.085797312f, 0.098017140f, 0.110222207f, 0.122410675f, 0.134580709f,
+  0.146730474f, 0.158858143f, 0.170961889f, 0.183039888f, 0.195090322f, 0.207111376f,
+  0.219101240f, 0.231058108f, 0.242980180f, 0.254865660f, 0.266712757f, 0.278519689f,
+  0.290284677f, 0.302005949f, 0.313681740f, 0.325310292f, 0.336889853f, 0.348418680f,
+  0.359895037f, 0.371317194f, 0.382683432f, 0.393992040f, 0.405241314f, 0.416429560f,
+  0.427555093f, 0.438616239f, 0.449611330f, 0.460538711f, 0.471396737f, 0.482183772f,
+  0.492898192f, 0.503538384f, 0.514102744f, 0.524589683f, 0.534997620f, 0.545324988f,
+  0.555570233f, 0.565731811f, 0.575808191f, 0.585797857f, 0.595699304f, 0.605511041f,
+  0.615231591f, 0.624859488f, 0.634393284f, 0.643831543f, 0.653172843f, 0.662415778f,
+  0.671558955f, 0.680600998f, 0.689540545f, 0.698376249f, 0.707106781f, 0.715730825f,
+  0.724247083f, 0.732654272f, 0.740951125f, 0.749136395f, 0.757208847f, 0.765167266f,
+  0.773010453f, 0.780737229f, 0.788346428f, 0.795836905f, 0.803207531f, 0.810457198f,
+  0.817584813f, 0.824589303f, 0.831469612f, 0.838224706f, 0.844853565f, 0.851355193f,
+  0.857728610f, 0.863972856f, 0.870086991f, 0.876070094f, 0.881921264f, 0.887639620f,
+  0.893224301f, 0.898674466f, 0.903989293f, 0.909167983f, 0.914209756f, 0.919113852f,
+  0.923879533f, 0.928506080f, 0.932992799f, 0.937339012f, 0.941544065f, 0.945607325f,
+  0.949528181f, 0.953306040f, 0.956940336f, 0.960430519f, 0.963776066f, 0.966976471f,
+  0.970031253f, 0.972939952f, 0.975702130f, 0.978317371f, 0.980785280f, 0.983105487f,
+  0.985277642f, 0.987301418f, 0.989176510f, 0.990902635f, 0.992479535f, 0.993906970f,
+  0.995184727f, 0.996312612f, 0.997290457f, 0.998118113f, 0.998795456f, 0.999322385f,
+  0.999698819f, 0.999924702f, 1.000000000f,
+};
+
+static inline float sin512(uint16_t k) {
+  k &= (ONSET_FFT_N - 1);
+  if (k <= 128) return  SIN_Q[k];
+  if (k <= 256) return  SIN_Q[256 - k];
+  if (k <= 384) return -SIN_Q[k - 256];
+  return -SIN_Q[512 - k];
+}
+static inline float cos512(uint16_t k) { return sin512(k + 128); }
+
+// ---- Static workspace ----
+static float    ring[ONSET_FFT_N];       // last N samples, ringPos = oldest
+static uint16_t ringPos = 0, ringFill = 0, hopFill = 0;
+static float    work[2 * FFT_M];         // interleaved re / im
+static float    prevMag[N_BINS];
+static bool     havePrev = false;
+static uint16_t binLo[ONSET_BANDS], binHi[ONSET_BANDS];   // [lo, hi)
+
+void onset_init(uint32_t sampleRate) {
+  const float binHz = (float)sampleRate / (float)ONSET_FFT_N;
+  uint16_t lo = (uint16_t)(ONSET_LOW_LO_HZ / binHz + 0.5f);
+  if (lo < 1) lo = 1;
+  const uint16_t loMid  = (uint16_t)(ONSET_LOW_HI_HZ / binHz + 0.5f);
+  const uint16_t loHigh = (uint16_t)(ONSET_MID_HI_HZ / binHz + 0.5f);
+  binLo[ONSET_LOW]  = lo;     binHi[ONSET_LOW]  = loMid;
+  binLo[ONSET_MID]  = loMid;  binHi[ONSET_MID]  = loHigh;
+  binLo[ONSET_HIGH] = loHigh; binHi[ONSET_HIGH] = N_BINS;
+  onset_reset();
+}
+
+void onset_reset() {
+  for (uint16_t i = 0; i < ONSET_FFT_N; i++) ring[i] = 0.0f;
+  ringPos = ringFill = hopFill = 0;
+  havePrev = false;
+}
+
+// In-place 256-point complex radix-4 DIF FFT, forward (e^-i), natural order out.
+static void fftRadix4(float* z) {
+  for (uint16_t len = FFT_M; len >= 4; len >>= 2) {
+    const uint16_t q  = len >> 2;
+    const uint16_t tw = ONSET_FFT_N / len;          // W_len^j == W_512^(j*tw)
+    for (uint16_t base = 0; base < FFT_M; base += len) {
+      for (uint16_t j = 0; j < q; j++) {
+        float* a = z + 2 * (base + j);
+        float* b = a + 2 * q;
+        float* c = b + 2 * q;
+        float* d = c + 2 * q;
+        const float t0r = a[0] + c[0], t0i = a[1] + c[1];
+        const float t1r = a[0] - c[0], t1i = a[1] - c[1];
+        const float t2r = b[0] + d[0], t2i = b[1] + d[1];
+        const float t3r = b[1] - d[1], t3i = d[0] - b[0];   // -i * (b - d)
+
+        a[0] = t0r + t2r; a[1] = t0i + t2i;
+        const float y1r = t1r + t3r, y1i = t1i + t3i;
+        const float y2r = t0r - t2r, y2i = t0i - t2i;
+        const float y3r = t1r - t3r, y3i = t1i - t3i;
+
+        if (j == 0) {
+          b[0] = y1r; b[1] = y1i; c[0] = y2r; c[1] = y2i; d[0] = y3r; d[1] = y3i;
+          continue;
+        }
+        // (y) * (cos - i sin)
+        const uint16_t k1 = j * tw, k2 = 2 * k1, k3 = 3 * k1;
+        const float c1 = cos512(k1), s1 = sin512(k1);
+        const float c2 = cos512(k2), s2 = sin512(k2);
+        const float c3 = cos512(k3), s3 = sin512(k3);
+        b[0] = y1r * c1 + y1i * s1; b[1] = y1i * c1 - y1r * s1;
+        c[0] = y2r * c2 + y2i * s2; c[1] = y2i * c2 - y2r * s2;
+        d[0] = y3r * c3 + y3i * s3; d[1] = y3i * c3 - y3r * s3;
+      }
+    }
+  }
+
+  // Base-4 digit reversal (4 digits for 256 points)
+  for (uint16_t p = 0; p < FFT_M; p++) {
+    const uint16_t r = ((p & 0x03) << 6) | ((p & 0x0C) << 2) | ((p & 0x30) >> 2) | ((p & 0xC0) >> 6);
+    if (r > p) {
+      float t;
+      t = z[2 * p];     z[2 * p]     = z[2 * r];     z[2 * r]     = t;
+      t = z[2 * p + 1]; z[2 * p + 1] = z[2 * r + 1]; z[2 * r + 1] = t;
+    }
+  }
+}
+
+bool onset_push(float x, float flux[ONSET_BANDS]) {
+  ring[ringPos] = x;
+  ringPos = (ringPos + 1) & (ONSET_FFT_N - 1);
+  if (ringFill < ONSET_FFT_N) ringFill++;
+  if (++hopFill < ONSET_HOP) return false;
+  hopFill = 0;
+  if (ringFill < ONSET_FFT_N) return false;
+
+  // Hann window, even / odd samples packed as re / im
+  for (uint16_t n = 0; n < ONSET_FFT_N; n++) {
+    const float w = 0.5f - 0.5f * cos512(n);
+    work[n] = w * ring[(ringPos + n) & (ONSET_FFT_N - 1)];
+  }
+  fftRadix4(work);
+
+  // Split the packed spectrum into the real-input spectrum, bins 0..N/2
+  for (uint8_t b = 0; b < ONSET_BANDS; b++) flux[b] = 0.0f;
+  uint8_t band = 0;
+  for (uint16_t k = 0; k < N_BINS; k++) {
+    const uint16_t kk = k & (FFT_M - 1), kn = (FFT_M - k) & (FFT_M - 1);
+    const float zr = work[2 * kk], zi = work[2 * kk + 1];
+    const float nr = work[2 * kn], ni = -work[2 * kn + 1];       // conj(Z[M-k])
+    const float er = 0.5f * (zr + nr), ei = 0.5f * (zi + ni);    // even part
+    const float orr = 0.5f * (zi - ni), oi = -0.5f * (zr - nr);  // odd part, -i/2 (Z - conj)
+    const float c = cos512(k), s = sin512(k);
+    const float xr = er + orr * c + oi * s;
+    const float xi = ei + oi * c - orr * s;
+    const float mag = sqrtf(xr * xr + xi * xi) * MAG_NORM;
+
+    if (havePrev && k >= binLo[ONSET_LOW]) {
+      while (band < ONSET_BANDS - 1 && k >= binHi[band]) band++;
+      const float d = mag - prevMag[k];
+      if (d > 0.0f) flux[band] += d;
+    }
+    prevMag[k] = mag;
+  }
+
+  if (!havePrev) { havePrev = true; return false; }
+  return true;
+}
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <math.h>
+#include <atomic>
 #include "hw.h"
 #include "party_patterns.h"
 
@@ -12,8 +13,13 @@ static constexpr float   CAP_DROP        = 1.00f;
 static constexpr float   CAND_DIM        = 0.55f;
 static constexpr uint8_t BASE_BRIGHT     = 235;
 static constexpr uint8_t PATTERN_LEN_BARS = 8;
+static constexpr uint8_t PHRASE_HOLD_BARS = 16;  // phrase-driven window runs this long without a start
+static constexpr uint8_t PHRASE_MIN_WINDOW_BARS = 4; // shorter windows only realign at a phrase start
 static constexpr float   BREAK_FADE_BEATS = 2.0f;
 static constexpr float   DROP_OVERLAP_FRAC = 0.10f;
+static constexpr float   INTENSITY_DEPTH  = 0.50f;  // cap x (1 + DEPTH * (intensity - PP_INTENSITY_AT_BASE))
+static constexpr float   INTENSITY_FILL_ON  = 0.75f; // STD: the diagonal partner fills in above this
+static constexpr float   INTENSITY_FILL_MAX = 0.50f; // partner level at intensity 1
 
 // ============================================================
 // INTERNAL TYPES
@@ -25,6 +31,7 @@ enum VisualMode : uint8_t { VIS_STD=0, VIS_BREAK=1, VIS_DROP=2, VIS_DEBUG=3 };
 // ============================================================
 static ContextState ppState          = STANDARD;
 static uint32_t     ppBeatIntervalUs = 500000;  // default 120 BPM
+static float        ppIntensity      = -1.0f;   // < 0: not supplied
 
 // ============================================================
 // ROTATION ORDERS
@@ -37,6 +44,17 @@ static const Color CCW_ORDER[4] = { BLUE, YELLOW, GREEN, RED };
 // ============================================================
 static float wingRequest[4] = {0,0,0,0};
 
+// Deferred commit (pp_prepareBeat): commitRequests() fills ppPending instead
+// of the LEDs; pp_commitPending() latches it. ppPending and ppPendingArmed
+// are all the latch side (timer task) touches: the loop writes ppPending
+// only while disarmed and then arms, the latch disarms after its LED write.
+// Everything else, ppNext* included, is loop-only; the caller keeps the two
+// sides from latching and re-preparing at once.
+static bool             ppDefer         = false;
+static uint8_t          ppPending[4]    = {0,0,0,0};
+static std::atomic<bool> ppPendingArmed{false};
+static uint32_t         ppBeatUs        = 0;     // start time of the current beat
+
 static inline float pp_clamp01(float x) {
   return (x < 0.0f) ? 0.0f : (x > 1.0f ? 1.0f : x);
 }
@@ -75,12 +93,30 @@ static float getStateCap() {
   }
 }
 
+// STD density: above INTENSITY_FILL_ON every lit wing pulls its diagonal
+// partner (CW order +2) up to a share of its own level.
+static void intensityFill() {
+  const float f = INTENSITY_FILL_MAX * (ppIntensity - INTENSITY_FILL_ON) / (1.0f - INTENSITY_FILL_ON);
+  float fill[4];
+  for (int i = 0; i < 4; i++) fill[(i + 2) % 4] = wingRequest[i] * f;
+  for (int i = 0; i < 4; i++) if (wingRequest[i] < fill[i]) wingRequest[i] = fill[i];
+}
+
 static void commitRequests() {
   float cap = getStateCap();
+  if (ppIntensity >= 0.0f) {
+    cap = pp_clamp01(cap * (1.0f + INTENSITY_DEPTH * (ppIntensity - PP_INTENSITY_AT_BASE)));
+    if (ppState != BREAK_CONFIRMED && ppState != DROP && ppIntensity > INTENSITY_FILL_ON) intensityFill();
+  }
   uint8_t duties[4];
   for (int i = 0; i < 4; i++) {
     duties[i] = dutyFromLevel(wingRequest[i] * cap, BASE_BRIGHT);
   }
+  if (ppDefer) {
+    for (int i = 0; i < 4; i++) ppPending[i] = duties[i];
+    ppPendingArmed.store(true);
+    return;
+  }
   hw_led_all_set(duties);
 }
 
@@ -106,6 +142,8 @@ static const PatternID DRP_PATTERNS[3] = { PAT_DRP_01, PAT_DRP_02, PAT_DRP_03 };
 static uint8_t  patWindowBar       = 0;
 static uint8_t  patWindowBeat      = 1;
 static uint32_t ppBeatIndex        = 0;  // monotonic beat counter
+static bool     ppPhraseDriven     = false; // pp_phraseStart() seen: windows end at phrase starts
+static bool     ppPhrasePending    = false; // next downbeat is a phrase start
 
 // BREAK crossfade state
 static bool     breakFading        = false;
@@ -135,6 +173,97 @@ static bool     drp03OddBar        = true; // odd bar = expand from BLUE; even =
 static VisualMode visMode          = VIS_STD;
 static ContextState prevStateForPat = STANDARD;
 
+// ============================================================
+// ENGINE STATE SNAPSHOT (scheduled beat commits)
+// ============================================================
+// pp_prepareBeat() runs the next beat on the live state and keeps the result
+// in ppNext; the live state (ppBefore, the shown beat) is put back so
+// pp_render() keeps fading / shimmering it until the latch. The loop picks
+// up ppNext once the frame is latched; ppBefore stays until the beat's tick
+// so the beat can be run again with the tick's context state.
+struct EngineState {
+  ContextState state;
+  uint32_t     beatIntervalUs;
+  float        intensity;
+  uint32_t     beatUs;
+  PatternID    active;
+  uint8_t      stdIdx, brkIdx, drpIdx, savedDrpIdx;
+  bool         locked;
+  uint8_t      windowBar, windowBeat;
+  uint32_t     beatIndex;
+  bool         phraseDriven, phrasePending;
+  bool         brkFading;
+  Color        brkFrom, brkTo, brkLast;
+  uint32_t     brkStartUs, brkDurUs;
+  uint8_t      dropStep;
+  uint32_t     lastHalfUs, halfUs;
+  bool         drp02Axis13;
+  uint8_t      drp03HalfStep;
+  bool         drp03OddBar;
+  VisualMode   vis;
+  ContextState prevState;
+};
+
+static EngineState   ppBefore;                 // live state the beat was prepared from
+static EngineState   ppNext;                   // state after the prepared beat
+static bool          ppPrepValid    = false;   // ppBefore valid until the beat's tick
+static bool          ppNextValid    = false;   // ppNext not yet picked up
+static uint8_t       ppPrepBar = 0, ppPrepBeat = 1;
+static uint32_t      ppPrepBeatUs   = 0;
+static ContextState  ppPrepState    = STANDARD;   // context state the beat was prepared with
+
+static void engineSave(EngineState& e) {
+  e.state = ppState; e.beatIntervalUs = ppBeatIntervalUs; e.intensity = ppIntensity;
+  e.beatUs = ppBeatUs;
+  e.active = activePattern;
+  e.stdIdx = stdPatternIdx; e.brkIdx = brkPatternIdx;
+  e.drpIdx = drpPatternIdx; e.savedDrpIdx = savedDrpPatternIdx;
+  e.locked = ppPatternLocked;
+  e.windowBar = patWindowBar; e.windowBeat = patWindowBeat;
+  e.beatIndex = ppBeatIndex;
+  e.phraseDriven = ppPhraseDriven; e.phrasePending = ppPhrasePending;
+  e.brkFading = breakFading;
+  e.brkFrom = breakFrom; e.brkTo = breakTo; e.brkLast = brkLastWing;
+  e.brkStartUs = breakFadeStartUs; e.brkDurUs = breakFadeDurUs;
+  e.dropStep = dropStep;
+  e.lastHalfUs = lastHalfBeatUs; e.halfUs = halfBeatUs;
+  e.drp02Axis13 = drp02Axis13;
+  e.drp03HalfStep = drp03HalfStep; e.drp03OddBar = drp03OddBar;
+  e.vis = visMode;
+  e.prevState = prevStateForPat;
+}
+
+static void engineLoad(const EngineState& e) {
+  ppState = e.state; ppBeatIntervalUs = e.beatIntervalUs; ppIntensity = e.intensity;
+  ppBeatUs = e.beatUs;
+  activePattern = e.active;
+  stdPatternIdx = e.stdIdx; brkPatternIdx = e.brkIdx;
+  drpPatternIdx = e.drpIdx; savedDrpPatternIdx = e.savedDrpIdx;
+  ppPatternLocked = e.locked;
+  patWindowBar = e.windowBar; patWindowBeat = e.windowBeat;
+  ppBeatIndex = e.beatIndex;
+  ppPhraseDriven = e.phraseDriven; ppPhrasePending = e.phrasePending;
+  breakFading = e.brkFading;
+  breakFrom = e.brkFrom; breakTo = e.brkTo; brkLastWing = e.brkLast;
+  breakFadeStartUs = e.brkStartUs; breakFadeDurUs = e.brkDurUs;
+  dropStep = e.dropStep;
+  lastHalfBeatUs = e.lastHalfUs; halfBeatUs = e.halfUs;
+  drp02Axis13 = e.drp02Axis13;
+  drp03HalfStep = e.drp03HalfStep; drp03OddBar = e.drp03OddBar;
+  visMode = e.vis;
+  prevStateForPat = e.prevState;
+}
+
+// Loop side: once the timer has latched the pending frame, continue from the
+// prepared beat. A live frame rendered while the latch fired may have
+// overwritten it, so the latched frame is written again.
+static void latchPickup() {
+  if (!ppNextValid || ppPendingArmed.load()) return;
+  ppNextValid = false;
+  engineLoad(ppNext);
+  hw_led_all_set(ppPending);
+}
+
 // ============================================================
 // PATTERN IMPLEMENTATIONS
 // ============================================================
@@ -183,7 +312,7 @@ static void patBrk01OnBeat(uint8_t bar, uint8_t beat) {
     breakTo   = next;
     brkLastWing = next;
     breakFading = true;
-    breakFadeStartUs = micros();
+    breakFadeStartUs = ppBeatUs;
     breakFadeDurUs = (uint32_t)(BREAK_FADE_BEATS * (float)ppBeatIntervalUs);
   }
 }
@@ -195,7 +324,7 @@ static void patBrk02OnBeat(uint8_t bar, uint8_t beat) {
   breakTo   = w;
   if (beat == 1) {
     breakFading = true;
-    breakFadeStartUs = micros();
+    breakFadeStartUs = ppBeatUs;
     breakFadeDurUs = 4 * ppBeatIntervalUs;
   }
 }
@@ -208,7 +337,7 @@ static void patBrk03OnBeat(uint8_t bar, uint8_t beat) {
     breakTo   = next;
     brkLastWing = next;
     breakFading = true;
-    breakFadeStartUs = micros();
+    breakFadeStartUs = ppBeatUs;
     breakFadeDurUs = (uint32_t)(BREAK_FADE_BEATS * (float)ppBeatIntervalUs);
   }
 }
@@ -222,7 +351,7 @@ static void patDrp01OnBeat(uint8_t bar, uint8_t beat) {
   } else {
     dropStep = (8 - (totalHalfBeats % 8)) % 8;
   }
-  lastHalfBeatUs = micros();
+  lastHalfBeatUs = ppBeatUs;
 }
 
 static void patDrp01OnHalfBeat() {
@@ -235,7 +364,7 @@ static void patDrp02OnBeat(uint8_t bar, uint8_t beat) {
   (void)beat;
   drp02Axis13 = (bar == 1 || bar == 2 || bar == 5 || bar == 6);
   dropStep = 0;
-  lastHalfBeatUs = micros();
+  lastHalfBeatUs = ppBeatUs;
 }
 
 static void patDrp02OnHalfBeat() {
@@ -258,7 +387,7 @@ static void patDrp03OnBeat(uint8_t bar, uint8_t beat) {
   } else {
     drp03HalfStep = (beat - 1) * 2;
   }
-  lastHalfBeatUs = micros();
+  lastHalfBeatUs = ppBeatUs;
 }
 
 static void patDrp03OnHalfBeat() {
@@ -409,9 +538,10 @@ const char* pp_ctxName(ContextState s) {
 
 PatternID pp_activePattern() { return activePattern; }
 
-void pp_setContext(ContextState state, uint32_t beatIntervalUs) {
+void pp_setContext(ContextState state, uint32_t beatIntervalUs, float intensity) {
   ppState          = state;
   ppBeatIntervalUs = beatIntervalUs;
+  ppIntensity      = (intensity > 1.0f) ? 1.0f : intensity;
 }
 
 void pp_setPattern(PatternID p) {
@@ -456,7 +586,7 @@ void pp_selectForState(ContextState s) {
   patWindowBeat = 1;
 }
 
-void pp_onBeat(uint8_t bar, uint8_t beat) {
+static void beatAt(uint8_t bar, uint8_t beat) {
   ppBeatIndex++;
   bool isBarStart = (beat == 1);
 
@@ -486,15 +616,23 @@ void pp_onBeat(uint8_t bar, uint8_t beat) {
                   60000000.0f / (float)ppBeatIntervalUs);
   }
 
-  // Advance pattern window
+  // Advance pattern window: a phrase start ends it; without one it runs
+  // PATTERN_LEN_BARS (PHRASE_HOLD_BARS while phrase-driven, then back to fixed)
   if (isBarStart) {
     patWindowBar++;
-    if (patWindowBar > PATTERN_LEN_BARS) {
+    const bool phraseStart = ppPhrasePending;
+    ppPhrasePending = false;
+    const uint8_t windowLen = ppPhraseDriven ? PHRASE_HOLD_BARS : PATTERN_LEN_BARS;
+    if (phraseStart && (shouldSelect || patWindowBar <= PHRASE_MIN_WINDOW_BARS)) {
+      patWindowBar = 1;                    // just selected / barely started: realign only
+    } else if (phraseStart || patWindowBar > windowLen) {
+      if (!phraseStart) ppPhraseDriven = false;
       if (!ppPatternLocked) {
         pp_selectForState(ppState);
-        Serial.printf("PATTERN_SWITCH pat=%s bpm=%.1f\n",
+        Serial.printf("PATTERN_SWITCH pat=%s bpm=%.1f why=%s\n",
                       pp_patternName(activePattern),
-                      60000000.0f / (float)ppBeatIntervalUs);
+                      60000000.0f / (float)ppBeatIntervalUs,
+                      phraseStart ? "PHRASE" : (windowLen == PATTERN_LEN_BARS ? "WINDOW" : "PHRASE_HOLD"));
       }
       patWindowBar = 1;
     }
@@ -504,10 +642,27 @@ void pp_onBeat(uint8_t bar, uint8_t beat) {
     if (patWindowBeat > 4) patWindowBeat = 1;
   }
 
-  patternOnBeat(patWindowBar, patWindowBeat);
+  // Patterns are written for an 8-bar window
+  patternOnBeat((uint8_t)((patWindowBar - 1) % PATTERN_LEN_BARS + 1), patWindowBeat);
+}
+
+void pp_phraseStart() {
+  ppPhraseDriven  = true;
+  ppPhrasePending = true;
+  // A prepared beat carries its own copies
+  if (ppNextValid) { ppNext.phraseDriven = true; ppNext.phrasePending = true; }
+  if (ppPrepValid) { ppBefore.phraseDriven = true; ppBefore.phrasePending = true; }
+}
+
+void pp_onBeat(uint8_t bar, uint8_t beat) {
+  latchPickup();
+  ppPrepValid = false;
+  ppBeatUs = micros();
+  beatAt(bar, beat);
 }
 
 void pp_onHalfBeat() {
+  latchPickup();
   refreshVisualMode();
   if (visMode == VIS_STD) {
     // Generic STD dark gap: hard cut off between every beat.
@@ -518,11 +673,7 @@ void pp_onHalfBeat() {
   }
 }
 
-void pp_render() {
-  refreshVisualMode();
-
-  const uint32_t nowUs = micros();
-
+static void renderAt(uint32_t nowUs) {
   if (visMode == VIS_BREAK) {
     if (!breakFading) return;
     const uint32_t dt = nowUs - breakFadeStartUs;
@@ -580,6 +731,87 @@ void pp_render() {
   // VIS_STD: no continuous render; patterns commit on beat events
 }
 
+void pp_render() {
+  latchPickup();
+  refreshVisualMode();
+  renderAt(micros());   // while a frame is pending: the shown beat, still fading
+}
+
+// Runs the beat from the live state into the pending frame, then puts the
+// live state back (see ENGINE STATE SNAPSHOT).
+static void prepareFromLive(uint8_t bar, uint8_t beat, uint32_t beatUs, ContextState state,
+                            uint32_t beatIntervalUs, float intensity) {
+  EngineState live;
+  engineSave(live);
+  pp_setContext(state, beatIntervalUs, intensity);
+  ppBeatUs = beatUs;
+  ppDefer  = true;
+  beatAt(bar, beat);
+  if (visMode != VIS_STD) renderAt(beatUs);   // first frame of the beat
+  ppDefer  = false;
+  if (!ppPendingArmed.load()) return;   // nothing to latch: the beat takes over now
+  engineSave(ppNext);
+  engineLoad(live);
+  ppNextValid = true;
+}
+
+bool pp_prepareBeat(uint8_t bar, uint8_t beat, uint32_t beatUs, ContextState state,
+                    uint32_t beatIntervalUs, float intensity) {
+  latchPickup();
+  engineSave(ppBefore);
+  ppPrepBar    = bar;
+  ppPrepBeat   = beat;
+  ppPrepBeatUs = beatUs;
+  ppPrepState  = state;
+  ppPrepValid  = true;
+  prepareFromLive(bar, beat, beatUs, state, beatIntervalUs, intensity);
+  return ppPendingArmed.load();
+}
+
+bool pp_reprepareBeat(ContextState state, uint32_t beatIntervalUs, float intensity) {
+  if (!ppPrepValid) return false;
+  ppPrepValid = false;
+  if (state == ppPrepState) return false;
+  ppPendingArmed.store(false);
+  ppNextValid    = false;
+  engineLoad(ppBefore);
+  prepareFromLive(ppPrepBar, ppPrepBeat, ppPrepBeatUs, state, beatIntervalUs, intensity);
+  return ppPendingArmed.load();
+}
+
+bool pp_commitPending() {
+  if (!ppPendingArmed.load()) return false;
+  hw_led_all_set(ppPending);
+  ppPendingArmed.store(false);   // the loop picks up ppNext once it sees this
+  return true;
+}
+
+void pp_snapshot(PatternSnapshot* s) {
+  latchPickup();
+  EngineState e;
+  if (ppNextValid) e = ppNext;   // beat prepared, latch still to come
+  else             engineSave(e);
+  s->active      = (uint8_t)e.active;
+  s->stdIdx      = e.stdIdx;
+  s->brkIdx      = e.brkIdx;
+  s->drpIdx      = e.drpIdx;
+  s->savedDrpIdx = e.savedDrpIdx;
+  s->windowBar   = e.windowBar;
+  s->state       = (uint8_t)e.prevState;
+}
+
+void pp_restore(const PatternSnapshot& s) {
+  activePattern      = (s.active < PAT_COUNT) ? (PatternID)s.active : PAT_STD_01;
+  stdPatternIdx      = s.stdIdx % 6;
+  brkPatternIdx      = s.brkIdx % 3;
+  drpPatternIdx      = s.drpIdx % 3;
+  savedDrpPatternIdx = s.savedDrpIdx % 3;
+  patWindowBar       = (s.windowBar <= PHRASE_HOLD_BARS) ? s.windowBar : 0;
+  patWindowBeat      = 1;
+  prevStateForPat    = (s.state <= DROP) ? (ContextState)s.state : STANDARD;
+  ppState            = prevStateForPat;
+}
+
 void pp_reset() {
   activePattern   = PAT_STD_01;
   ppPatternLocked = false;
@@ -589,6 +821,8 @@ void pp_reset() {
   patWindowBar    = 0;
   patWindowBeat   = 1;
   ppBeatIndex     = 0;
+  ppPhraseDriven  = false;
+  ppPhrasePending = false;
   breakFading     = false;
   brkLastWing     = BLUE;
   dropStep        = 0;
@@ -601,5 +835,9 @@ void pp_reset() {
   visMode         = VIS_STD;
   prevStateForPat = STANDARD;
   ppState         = STANDARD;
+  ppDefer         = false;
+  ppPendingArmed.store(false);
+  ppPrepValid     = false;
+  ppNextValid     = false;
   hw_led_all_off();
 }
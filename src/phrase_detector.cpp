@@ -0,0 +1,108 @@
+#include "phrase_detector.h"
+#include <math.h>
+
+static constexpr float   LEVEL_FLOOR = 1e-12f;          // log of silence stays finite
+static constexpr float   SIGMA_FLOOR = 0.15f;           // nepers: a flat window still has a spread
+static const uint8_t     LAG_BARS[PHRASE_LAGS] = { 4, 8, 16 };
+
+void PhraseDetector::reset() {
+  for (uint8_t i = 0; i < PHRASE_RING_BARS; i++)
+    for (uint8_t d = 0; d < PHRASE_DIMS; d++) ring[i][d] = 0.0f;
+  for (uint8_t l = 0; l < PHRASE_LAGS; l++) {
+    for (uint8_t d = 0; d < PHRASE_DIMS; d++) sum[l][d] = sumSq[l][d] = 0.0f;
+    lastLagNovelty[l] = 0.0f;
+  }
+  for (uint8_t k = 0; k < PHRASE_GRID_BARS; k++) slot[k] = 0.0f;
+  pos = fill = 0;
+  lastNovelty = 0.0f;
+}
+
+// Window sums recomputed from the ring (the newest bar is at pos - 1)
+void PhraseDetector::resum() {
+  for (uint8_t l = 0; l < PHRASE_LAGS; l++) {
+    for (uint8_t d = 0; d < PHRASE_DIMS; d++) sum[l][d] = sumSq[l][d] = 0.0f;
+    const uint8_t n = (fill < LAG_BARS[l]) ? fill : LAG_BARS[l];
+    for (uint8_t j = 1; j <= n; j++) {
+      const float* v = ring[(pos + PHRASE_RING_BARS - j) % PHRASE_RING_BARS];
+      for (uint8_t d = 0; d < PHRASE_DIMS; d++) { sum[l][d] += v[d]; sumSq[l][d] += v[d] * v[d]; }
+    }
+  }
+}
+
+bool PhraseDetector::onBar(uint32_t bar, float rms, float tr, float kVar, float kMean) {
+  const float x[PHRASE_DIMS] = {
+    logf(fmaxf(rms, LEVEL_FLOOR)), logf(fmaxf(tr, LEVEL_FLOOR)),
+    logf(fmaxf(kVar, LEVEL_FLOOR)), logf(fmaxf(kMean, LEVEL_FLOOR)),
+  };
+
+  // Novelty against each window of previous bars that is full
+  float nov = 0.0f;
+  uint8_t lags = 0;
+  for (uint8_t l = 0; l < PHRASE_LAGS; l++) {
+    lastLagNovelty[l] = 0.0f;
+    if (fill < LAG_BARS[l]) continue;
+    const float n = (float)LAG_BARS[l];
+    float z2 = 0.0f;
+    for (uint8_t d = 0; d < PHRASE_DIMS; d++) {
+      const float mean = sum[l][d] / n;
+      const float var = fmaxf(sumSq[l][d] / n - mean * mean, 0.0f) + SIGMA_FLOOR * SIGMA_FLOOR;
+      const float dx = x[d] - mean;
+      z2 += dx * dx / var;
+    }
+    lastLagNovelty[l] = sqrtf(z2 / (float)PHRASE_DIMS);
+    nov += lastLagNovelty[l];
+    lags++;
+  }
+  lastNovelty = (lags > 0) ? nov / (float)lags : 0.0f;
+
+  // Slide the windows: the new bar enters, the bar LAG_BARS back leaves
+  for (uint8_t l = 0; l < PHRASE_LAGS; l++) {
+    const bool full = (fill >= LAG_BARS[l]);
+    const float* old = ring[(pos + PHRASE_RING_BARS - LAG_BARS[l]) % PHRASE_RING_BARS];
+    for (uint8_t d = 0; d < PHRASE_DIMS; d++) {
+      sum[l][d]   += x[d];
+      sumSq[l][d] += x[d] * x[d];
+      if (full) {
+        sum[l][d]   -= old[d];
+        sumSq[l][d] -= old[d] * old[d];
+      }
+    }
+  }
+  for (uint8_t d = 0; d < PHRASE_DIMS; d++) ring[pos][d] = x[d];
+  pos = (uint8_t)((pos + 1) % PHRASE_RING_BARS);
+  if (fill < PHRASE_RING_BARS) fill++;
+  if (pos == 0) resum();                         // once per ring: drop float drift
+
+  // Phrase grid
+  const uint8_t k = (uint8_t)(bar % PHRASE_GRID_BARS);
+  for (uint8_t i = 0; i < PHRASE_GRID_BARS; i++) slot[i] *= PHRASE_SLOT_DECAY;
+  if (lastNovelty > PHRASE_NOISE) slot[k] += lastNovelty - PHRASE_NOISE;
+  const bool strong = (lags > 0 && lastNovelty >= PHRASE_STRONG);
+  if (strong)
+    for (uint8_t i = 0; i < PHRASE_GRID_BARS; i++) if (i != k) slot[i] *= 0.5f;
+  return strong;
+}
+
+uint8_t PhraseDetector::phase() const {
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < PHRASE_GRID_BARS; i++) if (slot[i] > slot[best]) best = i;
+  return best;
+}
+
+float PhraseDetector::contrast() const {
+  float total = 0.0f;
+  for (uint8_t i = 0; i < PHRASE_GRID_BARS; i++) total += slot[i];
+  if (total <= 0.0f) return 0.0f;
+  return slot[phase()] * (float)PHRASE_GRID_BARS / total;
+}
+
+bool PhraseDetector::gridValid() const {
+  return fill >= PHRASE_MIN_BARS && contrast() >= PHRASE_MIN_CONTRAST;
+}
+
+uint32_t PhraseDetector::nextStart(uint32_t bar) const {
+  if (!gridValid()) return 0;
+  const uint32_t k = phase();
+  const uint32_t next = bar + 1;
+  return next + (k + PHRASE_GRID_BARS - next % PHRASE_GRID_BARS) % PHRASE_GRID_BARS;
+}
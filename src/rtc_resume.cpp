@@ -0,0 +1,106 @@
+#include "rtc_resume.h"
+#include "crc32.h"
+#include <Arduino.h>
+#include <esp_system.h>
+#include <stddef.h>
+#include <string.h>
+#if __has_include("esp_private/esp_clk.h")
+#include "esp_private/esp_clk.h"
+#else
+#include "esp32/clk.h"
+#endif
+
+static constexpr uint32_t RESUME_MAGIC = 0x5348524Du;   // "SHRM"
+
+struct ResumeSnapshot {
+  uint32_t magic;
+  uint8_t  mode;
+  uint8_t  hasPayload;
+  uint16_t len;
+  uint64_t rtcUs;                 // resume_rtc_us() when stored
+  uint8_t  payload[RESUME_PAYLOAD_MAX];
+  uint32_t crc;                   // over everything above
+};
+
+RTC_NOINIT_ATTR static ResumeSnapshot snap;
+static bool resumeGranted = false;  // resume_pending() said yes this boot
+static bool payloadGranted = false; // ... and the payload is fresh enough to load
+
+static uint32_t snapCrc() {
+  return crc32_ieee(&snap, offsetof(ResumeSnapshot, crc));
+}
+
+static bool unintendedReset() {
+  switch (esp_reset_reason()) {
+    case ESP_RST_BROWNOUT:
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+uint64_t resume_rtc_us() { return esp_clk_rtc_time(); }
+
+const char* resume_reset_reason() {
+  switch (esp_reset_reason()) {
+    case ESP_RST_POWERON:  return "POWERON";
+    case ESP_RST_EXT:      return "EXT";
+    case ESP_RST_SW:       return "SW";
+    case ESP_RST_PANIC:    return "PANIC";
+    case ESP_RST_INT_WDT:  return "INT_WDT";
+    case ESP_RST_TASK_WDT: return "TASK_WDT";
+    case ESP_RST_WDT:      return "WDT";
+    case ESP_RST_BROWNOUT: return "BROWNOUT";
+    case ESP_RST_DEEPSLEEP:return "DEEPSLEEP";
+    default:               return "OTHER";
+  }
+}
+
+bool resume_pending(uint8_t* mode, uint32_t* ageMs) {
+  resumeGranted = payloadGranted = false;
+  if (!unintendedReset()) return false;
+  if (snap.magic != RESUME_MAGIC || snap.crc != snapCrc()) return false;
+  if (snap.len > RESUME_PAYLOAD_MAX) return false;
+  const uint64_t now = resume_rtc_us();
+  const bool timed = (now >= snap.rtcUs);                   // else the RTC timer was reset too
+  const uint64_t age = timed ? (now - snap.rtcUs) / 1000 : 0;
+  // The mode stands until a deliberate exit clears it; only a payload goes stale
+  payloadGranted = snap.hasPayload && timed && age <= RESUME_MAX_AGE_MS;
+  *mode = snap.mode;
+  *ageMs = (uint32_t)age;
+  resumeGranted = true;
+  return true;
+}
+
+void resume_begin(uint8_t mode) {
+  memset(&snap, 0, sizeof(snap));
+  snap.magic = RESUME_MAGIC;
+  snap.mode = mode;
+  snap.rtcUs = resume_rtc_us();
+  snap.crc = snapCrc();
+}
+
+void resume_store(const void* payload, uint16_t len) {
+  if (snap.magic != RESUME_MAGIC || len > RESUME_PAYLOAD_MAX) return;
+  memcpy(snap.payload, payload, len);
+  snap.len = len;
+  snap.hasPayload = 1;
+  snap.rtcUs = resume_rtc_us();
+  snap.crc = snapCrc();
+}
+
+bool resume_load(void* payload, uint16_t len) {
+  if (!payloadGranted || snap.len != len) return false;
+  memcpy(payload, snap.payload, len);
+  return true;
+}
+
+void resume_clear() {
+  resumeGranted = payloadGranted = false;
+  snap.magic = 0;
+  snap.crc = 0;
+}
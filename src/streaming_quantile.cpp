@@ -0,0 +1,128 @@
+#include "streaming_quantile.h"
+#include <math.h>
+
+static constexpr float MIN_VALUE = 1e-30f;     // log of zero stays finite
+
+void QuantileHist::reset(uint16_t h) {
+  horizon = h;
+  decay = (h > 1) ? 1.0f - 1.0f / (float)h : 1.0f;
+  haveOrigin = false;
+  lo = 0.0f;
+  for (uint16_t i = 0; i < QHIST_BINS; i++) w[i] = 0.0f;
+  total = 0.0f;
+  n = 0;
+  seedBin = 0;
+  seedFrac = 0.0f;
+  seedW = 0.0f;
+}
+
+int QuantileHist::binOf(float x) const {
+  const float l2 = log2f(fmaxf(x, MIN_VALUE));
+  return (int)floorf((l2 - lo) * (float)QHIST_BINS_PER_OCT);
+}
+
+void QuantileHist::slide(int octaves) {
+  const int s = octaves * QHIST_BINS_PER_OCT;
+  const int bins = QHIST_BINS;
+  float fold = 0.0f;
+  if (s > 0) {                                  // bottom bins fall off into the new bin 0
+    for (int i = 0; i < s && i < bins; i++) fold += w[i];
+    for (int i = 0; i < bins; i++) w[i] = (i + s < bins) ? w[i + s] : 0.0f;
+    w[0] += fold;
+  } else if (s < 0) {                           // top bins fall off into the new top bin
+    const int k = -s;
+    for (int i = (bins - k > 0) ? bins - k : 0; i < bins; i++) fold += w[i];
+    for (int i = bins - 1; i >= 0; i--) w[i] = (i - k >= 0) ? w[i - k] : 0.0f;
+    w[bins - 1] += fold;
+  }
+  lo += (float)octaves;
+  seedBin -= s;                                 // folded into an edge bin: spread like the rest
+  if (seedBin < 0 || seedBin >= bins) seedW = 0.0f;
+}
+
+void QuantileHist::add(float x) {
+  if (!haveOrigin) {
+    haveOrigin = true;
+    lo = floorf(log2f(fmaxf(x, MIN_VALUE))) - (float)(QHIST_OCTAVES / 2);
+  }
+  // Slide no further than keeps the held median an octave inside the window:
+  // one wild value (a zero, a clipped bar) cannot fold the history into an
+  // edge bin, while a real level change walks the window over as its mass
+  // takes over the median.
+  int b = binOf(x);
+  if (b < 0 || b >= QHIST_BINS) {
+    const int m = (total > 0.0f) ? medianBin() : QHIST_BINS / 2;
+    int k, room;
+    if (b < 0) {
+      k = (-b + QHIST_BINS_PER_OCT - 1) / QHIST_BINS_PER_OCT;
+      room = (QHIST_BINS - QHIST_BINS_PER_OCT - 1 - m) / QHIST_BINS_PER_OCT;
+    } else {
+      k = (b - QHIST_BINS) / QHIST_BINS_PER_OCT + 1;
+      room = (m - QHIST_BINS_PER_OCT) / QHIST_BINS_PER_OCT;
+    }
+    if (room < 1) room = 1;
+    if (k > room) k = room;
+    slide((b < 0) ? -k : k);
+    b = binOf(x);
+  }
+  if (b < 0) b = 0;                             // still outside: counts at the edge
+  if (b >= QHIST_BINS) b = QHIST_BINS - 1;
+
+  if (decay < 1.0f) {
+    for (uint16_t i = 0; i < QHIST_BINS; i++) w[i] *= decay;
+    total *= decay;
+    seedW *= decay;
+  }
+  w[b] += 1.0f;
+  total += 1.0f;
+  n++;
+}
+
+void QuantileHist::seed(float v, float weight) {
+  reset(horizon);
+  add(v);
+  int b = binOf(v);
+  if (b < 0) b = 0;
+  if (b >= QHIST_BINS) b = QHIST_BINS - 1;
+  w[b] = weight;
+  total = weight;
+  seedBin = b;
+  seedFrac = (log2f(fmaxf(v, MIN_VALUE)) - lo) * (float)QHIST_BINS_PER_OCT - (float)b;
+  seedFrac = (seedFrac < 0.0f) ? 0.0f : (seedFrac > 1.0f) ? 1.0f : seedFrac;
+  seedW = weight;
+}
+
+// Position in bin i (0..1) where its cumulative mass reaches t (0 < t <= w[i]).
+// The seed bin holds a point of seedW at seedFrac plus the rest spread evenly.
+float QuantileHist::inBin(int i, float t) const {
+  if (i != seedBin || seedW <= 0.0f) return t / w[i];
+  const float u = fmaxf(w[i] - seedW, 0.0f);
+  if (t <= u * seedFrac) return t / u;
+  if (t <= u * seedFrac + seedW || u <= 0.0f) return seedFrac;
+  return (t - seedW) / u;
+}
+
+int QuantileHist::medianBin() const {
+  const float half = 0.5f * total;
+  float acc = 0.0f;
+  for (uint16_t i = 0; i < QHIST_BINS; i++) {
+    acc += w[i];
+    if (acc >= half) return i;
+  }
+  return QHIST_BINS - 1;
+}
+
+float QuantileHist::quantile(float p) const {
+  if (total <= 0.0f) return 0.0f;
+  const float target = p * total;
+  float acc = 0.0f;
+  for (uint16_t i = 0; i < QHIST_BINS; i++) {
+    if (w[i] <= 0.0f) continue;
+    if (acc + w[i] >= target) {
+      const float frac = inBin(i, target - acc);
+      return exp2f(lo + ((float)i + frac) / (float)QHIST_BINS_PER_OCT);
+    }
+    acc += w[i];
+  }
+  return exp2f(lo + (float)QHIST_BINS / (float)QHIST_BINS_PER_OCT);
+}
@@ -0,0 +1,74 @@
+#include "tempo_tracker.h"
+#include <math.h>
+
+static constexpr float ERR_EMA_GAIN = 0.125f;   // ~8-beat memory for confidence
+static constexpr float ERR_CLIP     = 0.5f;     // |e| / period cap (half a beat)
+
+TempoTracker::TempoTracker(const Config& c, uint32_t initialPeriodUs)
+  : cfg(c), period((float)initialPeriodUs) {}
+
+void TempoTracker::resync() {
+  havePhase = false;
+  lastObsUs = 0;
+  locked = 0;
+}
+
+void TempoTracker::setPeriod(uint32_t periodUs) {
+  resync();
+  period = (float)periodUs;
+  errEma = 0.0f;
+}
+
+float TempoTracker::confidence() const {
+  if (!havePhase) return 0.0f;
+  const float lock = (cfg.lockBeats == 0 || locked >= cfg.lockBeats)
+                     ? 1.0f : (float)locked / (float)cfg.lockBeats;
+  float q = 1.0f - errEma / cfg.confErrFull;
+  if (q < 0.0f) q = 0.0f;
+  return lock * q;
+}
+
+TempoBeat TempoTracker::onBeat(uint32_t tUs) {
+  TempoBeat r = {};
+  r.curBpm = bpm();
+
+  if (!havePhase) {
+    havePhase   = true;
+    phaseUs     = tUs;
+    lastObsUs   = tUs;
+    r.verdict   = TEMPO_FIRST;
+    r.candidateUs = periodUs();
+    r.candBpm   = r.curBpm;
+    return r;
+  }
+
+  r.rawIntervalUs = tUs - lastObsUs;
+  lastObsUs = tUs;
+
+  const float e    = (float)(int32_t)(tUs - phaseUs) - period;
+  const float cand = period + cfg.beta * e;
+  r.phaseErrUs  = (int32_t)floorf(e + 0.5f);
+  r.candidateUs = (cand > 0.0f) ? (uint32_t)(cand + 0.5f) : 0;
+  r.candBpm     = (cand > 0.0f) ? 60000000.0f / cand : 0.0f;
+
+  float fe = fabsf(e) / period;
+  if (fe > ERR_CLIP) fe = ERR_CLIP;
+  errEma += ERR_EMA_GAIN * (fe - errEma);
+
+  // D1: range guard on the candidate period
+  if (r.candBpm < cfg.bpmMin || r.candBpm > cfg.bpmMax) r.verdict = TEMPO_REJECT_RANGE;
+  // D2: single-beat spike guard vs the current estimate
+  else if (fabsf(r.candBpm - r.curBpm) > cfg.spikeBpm) r.verdict = TEMPO_REJECT_SPIKE;
+  else if (hook && !hook(r.rawIntervalUs, r.candidateUs)) r.verdict = TEMPO_REJECT_HOOK;
+  else r.verdict = TEMPO_ACCEPT;
+
+  if (r.verdict == TEMPO_ACCEPT) {
+    phaseUs += (uint32_t)(int32_t)floorf(period + cfg.alpha * e + 0.5f);
+    period = cand;
+    if (locked < 255) locked++;
+  } else {
+    phaseUs = tUs;                     // re-anchor on the observed beat
+    if (r.verdict != TEMPO_REJECT_HOOK) locked = 0;
+  }
+  return r;
+}
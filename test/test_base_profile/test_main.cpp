@@ -0,0 +1,92 @@
+// Baseline profile slots (include/base_profile.h): slot choice, change
+// detection and eviction.
+#include <unity.h>
+#include <stdint.h>
+#include "base_profile.h"
+
+static constexpr uint8_t SLOTS = 8;
+static constexpr float   DELTA = 0.10f;
+
+static BaseProfile keyed(uint8_t bpm, int8_t level, float rms) {
+  BaseProfile p = {};
+  p.bpmBand = bpm;
+  p.levelBand = level;
+  p.rms = rms; p.tr = 0.5f * rms; p.kVar = 0.01f; p.kMean = 0.1f;
+  for (uint8_t b = 0; b < BAND_COUNT; b++) { p.bandE[b] = rms; p.bandV[b] = 0.1f * rms; }
+  return p;
+}
+
+static BaseProfile withBreak(BaseProfile p, float bf) {
+  p.hasBreak = 1;
+  p.bfRms = bf; p.bfTr = bf; p.bfKVar = 0.1f * bf;
+  return p;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_slot_same_key_then_empty() {
+  BaseProfile s[SLOTS] = {};
+  uint32_t seq = 0;
+  TEST_ASSERT_EQUAL_INT8(0, baseProfileSlot(s, SLOTS, 21, -4));
+  TEST_ASSERT_TRUE(baseProfileStore(s[0], keyed(21, -4, 0.2f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_INT8(0, baseProfileSlot(s, SLOTS, 21, -4));
+  TEST_ASSERT_EQUAL_INT8(1, baseProfileSlot(s, SLOTS, 22, -4));
+}
+
+void test_store_only_on_change() {
+  BaseProfile p = {};
+  uint32_t seq = 0;
+  TEST_ASSERT_TRUE(baseProfileStore(p, keyed(21, -4, 0.20f), DELTA, &seq));
+  TEST_ASSERT_FALSE(baseProfileStore(p, keyed(21, -4, 0.21f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT32(1, seq);
+  TEST_ASSERT_TRUE(baseProfileStore(p, keyed(21, -4, 0.25f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT32(2, p.seq);
+  // A first break floor under a known key is a change
+  TEST_ASSERT_TRUE(baseProfileStore(p, withBreak(keyed(21, -4, 0.25f), 0.4f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT8(1, p.hasBreak);
+}
+
+// Same key without a break this session: the stored floor stays
+void test_same_key_keeps_break_floor() {
+  BaseProfile p = {};
+  uint32_t seq = 0;
+  baseProfileStore(p, withBreak(keyed(21, -4, 0.2f), 0.4f), DELTA, &seq);
+  TEST_ASSERT_TRUE(baseProfileStore(p, keyed(21, -4, 0.3f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT8(1, p.hasBreak);
+  TEST_ASSERT_EQUAL_FLOAT(0.4f, p.bfRms);
+}
+
+// All slots full with break floors: the oldest goes to a new key, which must
+// not inherit the evicted key's floor
+void test_eviction_drops_break_floor() {
+  BaseProfile s[SLOTS] = {};
+  uint32_t seq = 0;
+  for (uint8_t i = 0; i < SLOTS; i++)
+    baseProfileStore(s[i], withBreak(keyed((uint8_t)(20 + i), -4, 0.2f), 0.3f + 0.01f * i), DELTA, &seq);
+  // Refresh slot 0 so slot 1 is the oldest
+  baseProfileStore(s[0], withBreak(keyed(20, -4, 0.3f), 0.3f), DELTA, &seq);
+
+  const int8_t k = baseProfileSlot(s, SLOTS, 40, -2);
+  TEST_ASSERT_EQUAL_INT8(1, k);
+  TEST_ASSERT_TRUE(baseProfileStore(s[k], keyed(40, -2, 0.5f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT8(40, s[k].bpmBand);
+  TEST_ASSERT_EQUAL_INT8(-2, s[k].levelBand);
+  TEST_ASSERT_EQUAL_UINT8(0, s[k].hasBreak);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, s[k].bfRms);
+  TEST_ASSERT_EQUAL_UINT32(seq, s[k].seq);
+
+  // The new key's own break floor is taken when it has one
+  TEST_ASSERT_TRUE(baseProfileStore(s[k], withBreak(keyed(40, -2, 0.5f), 0.6f), DELTA, &seq));
+  TEST_ASSERT_EQUAL_UINT8(1, s[k].hasBreak);
+  TEST_ASSERT_EQUAL_FLOAT(0.6f, s[k].bfRms);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_slot_same_key_then_empty);
+  RUN_TEST(test_store_only_on_change);
+  RUN_TEST(test_same_key_keeps_break_floor);
+  RUN_TEST(test_eviction_drops_break_floor);
+  return UNITY_END();
+}
@@ -0,0 +1,182 @@
+// Host comparison of the quantile baseline (include/streaming_quantile.h)
+// against the gated EMA it replaced (BASELINE_QUANTILE = false in
+// mode_party.cpp), on a synthetic per-bar kVar trace:
+//   level 1.0 for 120 bars, then 1.4 (track change), +-8% gaussian spread,
+//   6% of bars at 0.5x (breakdown fills) and 6% at 1.6x (impacts)
+// Reported per trace seed and as the worst / mean over TRACES seeds, median
+// vs EMA: first bar within 5% of the level, bars to get back within 5%
+// after the change (-1 = never), mean steady-state error (bars 31..119 and
+// 181..239). Also the slide of the histogram window over a x300 step and a
+// single zero bar, and the seed -> quantile round trip.
+// Numbers print with: pio test -e native -f test_bench_baseline_quantile -v
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "streaming_quantile.h"
+#include "../test_rng.h"
+
+// Same values as the baseline policy in mode_party.cpp
+static constexpr uint16_t HORIZON        = 32;     // BASELINE_QUANTILE_HORIZON
+static constexpr uint16_t EMA_READY_BARS = 16;     // BASELINE_MIN_QUALIFIED_BARS
+static constexpr float    EMA_ALPHA_LEARN = 0.30f; // BASE_ALPHA_LEARNING
+static constexpr float    EMA_ALPHA_STD   = 0.10f; // BASE_ALPHA_STD
+static constexpr float    EMA_BAND_MIN = 0.90f, EMA_BAND_MAX = 1.10f;   // BASELINE_UPDATE_KR_*
+
+static constexpr int BARS = 240, CHANGE_BAR = 120, TRACES = 8;
+static constexpr float TOL = 0.05f;
+
+static TestRng rng(3u);
+
+// Gated EMA as the firmware ran it: every bar until ready, then only bars
+// within the band around the current value
+struct GatedEma {
+  float v = 0.0f;
+  uint16_t qual = 0;
+  void add(float x) {
+    if (qual == 0) { v = x; qual = 1; return; }
+    const bool ready = qual >= EMA_READY_BARS;
+    const float r = x / v;
+    if (ready && (r < EMA_BAND_MIN || r > EMA_BAND_MAX)) return;
+    const float a = ready ? EMA_ALPHA_STD : EMA_ALPHA_LEARN;
+    v = (1.0f - a) * v + a * x;
+    qual++;
+  }
+};
+
+struct Result { int firstIn, followBars; float steadyErr; };
+
+static void run(uint32_t traceSeed, Result* med, Result* ema) {
+  rng = TestRng(traceSeed);
+  QuantileHist q;
+  q.reset(HORIZON);
+  GatedEma e;
+  *med = *ema = Result{-1, -1, 0.0f};
+  double errQ = 0.0, errE = 0.0;
+  int nErr = 0;
+  for (int i = 0; i < BARS; i++) {
+    const float level = (i < CHANGE_BAR) ? 1.0f : 1.4f;
+    float x = level * (1.0f + 0.08f * rng.gauss());
+    const float u = rng.uniform();
+    if (u < 0.06f) x *= 0.5f;
+    else if (u < 0.12f) x *= 1.6f;
+    q.add(x);
+    e.add(x);
+
+    const float eq = fabsf(q.median() / level - 1.0f), ee = fabsf(e.v / level - 1.0f);
+    if (i < CHANGE_BAR) {
+      if (med->firstIn < 0 && eq < TOL) med->firstIn = i;
+      if (ema->firstIn < 0 && ee < TOL) ema->firstIn = i;
+    } else {
+      if (med->followBars < 0 && eq < TOL) med->followBars = i - CHANGE_BAR;
+      if (ema->followBars < 0 && ee < TOL) ema->followBars = i - CHANGE_BAR;
+    }
+    if ((i > 30 && i < CHANGE_BAR) || i > CHANGE_BAR + 60) { errQ += eq; errE += ee; nErr++; }
+  }
+  med->steadyErr = (float)(errQ / nErr);
+  ema->steadyErr = (float)(errE / nErr);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_median_vs_gated_ema() {
+  int medFirstMax = 0, medFollowMax = 0, emaFollowed = 0;
+  float medErrSum = 0.0f, emaErrSum = 0.0f, medErrMax = 0.0f;
+  for (int t = 0; t < TRACES; t++) {
+    Result med, ema;
+    run(3u + (uint32_t)t, &med, &ema);
+    printf("BASELINE trace %d: first<5%% median %d EMA %d | after change median %d EMA %d | steady err median %.1f%% EMA %.1f%%\n",
+           t, med.firstIn, ema.firstIn, med.followBars, ema.followBars,
+           100.0f * med.steadyErr, 100.0f * ema.steadyErr);
+
+    TEST_ASSERT_TRUE(med.firstIn >= 0);
+    TEST_ASSERT_TRUE(med.followBars >= 0);
+    TEST_ASSERT_TRUE(med.steadyErr < ema.steadyErr);
+    if (med.firstIn > medFirstMax) medFirstMax = med.firstIn;
+    if (med.followBars > medFollowMax) medFollowMax = med.followBars;
+    if (med.steadyErr > medErrMax) medErrMax = med.steadyErr;
+    if (ema.followBars >= 0) emaFollowed++;
+    medErrSum += med.steadyErr;
+    emaErrSum += ema.steadyErr;
+  }
+  printf("BASELINE %d traces: median first<5%% by bar %d, follows in <= %d bars, steady err mean %.1f%% max %.1f%%; "
+         "EMA followed the change in %d/%d, steady err mean %.1f%%\n",
+         TRACES, medFirstMax, medFollowMax, 100.0f * medErrSum / TRACES, 100.0f * medErrMax,
+         emaFollowed, TRACES, 100.0f * emaErrSum / TRACES);
+
+  TEST_ASSERT_TRUE(medFirstMax < (int)EMA_READY_BARS);  // on the level before the EMA was even ready
+  TEST_ASSERT_TRUE(medFollowMax <= 2 * (int)HORIZON);
+  TEST_ASSERT_EQUAL_INT(0, emaFollowed);               // the gate rejects the new level
+  TEST_ASSERT_TRUE(medErrMax < 0.03f);
+}
+
+// A x300 level step (gain change) slides the window up and back down
+void test_window_slides_over_large_step() {
+  rng = TestRng(5u);
+  QuantileHist h;
+  h.reset(HORIZON);
+  for (int i = 0; i < 100; i++) h.add(0.001f * (1.0f + 0.05f * rng.gauss()));
+  TEST_ASSERT_FLOAT_WITHIN(0.00005f, 0.001f, h.median());
+  int up = -1, down = -1;
+  for (int i = 0; i < 200; i++) {
+    h.add(0.3f * (1.0f + 0.05f * rng.gauss()));
+    if (up < 0 && fabsf(h.median() / 0.3f - 1.0f) < TOL) up = i;
+  }
+  for (int i = 0; i < 200; i++) {
+    h.add(1e-5f);
+    if (down < 0 && fabsf(h.median() / 1e-5f - 1.0f) < TOL) down = i;
+  }
+  printf("BASELINE slide: x300 up in %d bars, back down in %d bars\n", up, down);
+  TEST_ASSERT_TRUE(up >= 0 && up <= 2 * (int)HORIZON);
+  TEST_ASSERT_TRUE(down >= 0 && down <= 2 * (int)HORIZON);
+}
+
+// One zero bar (dropout) must not drag the median into an edge bin
+void test_zero_bar_does_not_collapse() {
+  rng = TestRng(7u);
+  QuantileHist h;
+  h.reset(HORIZON);
+  for (int i = 0; i < 50; i++) h.add(0.01f * (1.0f + 0.05f * rng.gauss()));
+  const float before = h.median();
+  h.add(0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f * before, before, h.median());
+  h.add(0.01f);
+  TEST_ASSERT_FLOAT_WITHIN(0.05f * before, before, h.median());
+}
+
+// A seeded baseline (warm profile, RTC resume) reads back as the seeded
+// value wherever it sits in its bin, and the first real bars near it move
+// the median by their share only, not to the bin's interpolation
+void test_seed_round_trip() {
+  const float SEED_BARS = 8.0f;                  // BASE_PROFILE_SEED_BARS
+  float worstSeed = 0.0f, worstAfter = 0.0f;
+  for (int k = 0; k < 2 * QHIST_BINS_PER_OCT; k++) {
+    const float v = 0.0123f * exp2f((float)k / (4.0f * QHIST_BINS_PER_OCT));   // 8 spots per bin
+    QuantileHist h;
+    h.reset(HORIZON);
+    h.seed(v, SEED_BARS);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f * v, v, h.median());
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f * v, v, h.quantile(0.1f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f * v, v, h.quantile(0.9f));
+    worstSeed = fmaxf(worstSeed, fabsf(h.median() / v - 1.0f));
+
+    h.add(v);                                    // the same level again: no shift
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f * v, v, h.median());
+    h.add(1.5f * v);                             // one outlier above
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f * v, v, h.median());
+    for (int i = 0; i < 4; i++) h.add(v * (1.0f + 0.01f * (float)(i - 2)));
+    worstAfter = fmaxf(worstAfter, fabsf(h.median() / v - 1.0f));
+    TEST_ASSERT_FLOAT_WITHIN(0.025f * v, v, h.median());
+  }
+  printf("SEED round trip: max error %.5f%% seeded, %.2f%% after 6 bars within +-2%%\n",
+         100.0f * worstSeed, 100.0f * worstAfter);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_median_vs_gated_ema);
+  RUN_TEST(test_window_slides_over_large_step);
+  RUN_TEST(test_zero_bar_does_not_collapse);
+  RUN_TEST(test_seed_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,106 @@
+// Host micro-benchmark for the kick / body / hats filter bank
+// (include/filter_bank.h), float and Q24 / Q28 integer sections.
+//
+// Reports time per input sample and per 75 ms monitor window next to the
+// device budget (240 MHz: 5000 cycles per sample at 48 kHz). Host numbers
+// only rank the two paths and catch regressions; the device figure comes
+// from DEBUG_AUDIO_CYCLES (AUDIO_CYCLES bank=) in mode_party.cpp.
+// The bands are also checked for separating a 60 Hz / 250 Hz / 10 kHz tone.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include "filter_bank.h"
+#include "../test_rng.h"
+
+static constexpr uint32_t FS = 48000;
+static constexpr uint8_t  DECIM = 12;
+static constexpr uint32_t WIN_SAMPLES = FS * 75 / 1000;
+static constexpr uint32_t BENCH_SAMPLES = FS * 20;   // 20 s of audio
+static constexpr uint32_t DEVICE_CYC_PER_SAMPLE = 240000000u / FS;
+
+static int32_t sig[FS];   // 1 s of kick + bass + noise, looped
+static volatile float sink;
+
+static void makeSignal() {
+  TestRng rng(1u);
+  for (uint32_t i = 0; i < FS; i++) {
+    const float t = (float)(i % (FS / 2)) / (float)FS;
+    const float noise = rng.noise();
+    const float x = 0.4f * sinf(2.0f * 3.14159265f * 55.0f * t) * expf(-t * 10.0f)
+                  + 0.1f * sinf(2.0f * 3.14159265f * 220.0f * (float)i / (float)FS)
+                  + 0.05f * noise;
+    sig[i] = (int32_t)lrintf(x * 16777216.0f);
+  }
+}
+
+template <typename T>
+static double benchNsPerSample(const char* name) {
+  FilterBank<T, FS, DECIM> bank;
+  BankAcc acc;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+    bank.push(sig[i % FS], acc);
+    if ((i % WIN_SAMPLES) == WIN_SAMPLES - 1) acc.reset();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_SAMPLES;
+  printf("filter bank %-6s %6.1f ns/sample  %7.1f us/window   (device budget %u cycles/sample)\n",
+         name, ns, ns * WIN_SAMPLES / 1000.0, (unsigned)DEVICE_CYC_PER_SAMPLE);
+  sink = acc.band[BAND_KICK].energy();   // keep the work observable
+  return ns;
+}
+
+template <typename T>
+static void toneEnergy(float hz, float e[BAND_COUNT]) {
+  FilterBank<T, FS, DECIM> bank;
+  BankAcc acc;
+  for (uint32_t i = 0; i < FS; i++) {
+    const float x = 0.5f * sinf(2.0f * 3.14159265f * hz * (float)i / (float)FS);
+    if (i == FS / 2) acc.reset();     // skip the settling half second
+    bank.push((int32_t)lrintf(x * 16777216.0f), acc);
+  }
+  for (uint8_t b = 0; b < BAND_COUNT; b++) e[b] = acc.band[b].energy();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_bench_float() { benchNsPerSample<float>("float"); }
+void test_bench_fixed() { benchNsPerSample<int32_t>("fixed"); }
+
+// Each tone lands in its band, and the integer sections agree with float
+template <typename T>
+static void checkSeparation() {
+  const float tones[BAND_COUNT] = { 60.0f, 250.0f, 10000.0f };
+  for (uint8_t b = 0; b < BAND_COUNT; b++) {
+    float e[BAND_COUNT];
+    toneEnergy<T>(tones[b], e);
+    for (uint8_t o = 0; o < BAND_COUNT; o++)
+      if (o != b) TEST_ASSERT_TRUE(e[b] > 10.0f * e[o]);
+  }
+}
+void test_bands_separate_float() { checkSeparation<float>(); }
+void test_bands_separate_fixed() { checkSeparation<int32_t>(); }
+
+void test_fixed_matches_float() {
+  const float tones[] = { 60.0f, 250.0f, 10000.0f };
+  for (float hz : tones) {
+    float ef[BAND_COUNT], ex[BAND_COUNT];
+    toneEnergy<float>(hz, ef);
+    toneEnergy<int32_t>(hz, ex);
+    for (uint8_t b = 0; b < BAND_COUNT; b++)
+      if (ef[b] > 1e-4f) TEST_ASSERT_FLOAT_WITHIN(0.01f * ef[b], ef[b], ex[b]);
+  }
+}
+
+int main(int, char**) {
+  makeSignal();
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_float);
+  RUN_TEST(test_bench_fixed);
+  RUN_TEST(test_bands_separate_float);
+  RUN_TEST(test_bands_separate_fixed);
+  RUN_TEST(test_fixed_matches_float);
+  return UNITY_END();
+}
@@ -0,0 +1,106 @@
+// Host benchmark for the spectral-flux onset engine (include/onset_flux.h)
+// and the audio beat tracker it feeds (include/audio_beat.h).
+//
+// Reports cost per FFT hop and per 75 ms monitor window, in ns and in host
+// cycles (x86 TSC, nominal clock), next to the device window budget of
+// 240 MHz * 75 ms = 18M cycles. The host figure ranks changes; the device
+// figure comes from DEBUG_AUDIO_CYCLES (AUDIO_CYCLES onsetHop= win=).
+// A 120 BPM kick track also has to produce one onset peak per beat.
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include "onset_flux.h"
+#include "audio_beat.h"
+#include "../test_rng.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t cycles() { return __rdtsc(); }
+#else
+static inline uint64_t cycles() { return 0; }
+#endif
+
+static constexpr uint32_t FS = 48000;
+static constexpr uint32_t WIN_SAMPLES = FS * 75 / 1000;
+static constexpr uint64_t DEVICE_WIN_BUDGET = 240000000ull * 75 / 1000;
+static constexpr uint32_t BENCH_SAMPLES = FS * 20;
+
+static float track[FS * 2];   // 2 s of 120 BPM kick + hats + noise, looped
+
+static void makeTrack() {
+  TestRng rng(3u);
+  const uint32_t beat = FS / 2;
+  for (uint32_t i = 0; i < FS * 2; i++) {
+    const float tb = (float)(i % beat) / (float)FS;
+    const float th = (float)((i + beat / 2) % beat) / (float)FS;
+    const float noise = rng.noise();
+    track[i] = 0.5f * sinf(2.0f * 3.14159265f * 55.0f * tb) * expf(-tb * 15.0f)
+             + 0.1f * noise * expf(-th * 60.0f)
+             + 0.01f * noise;
+  }
+}
+
+static volatile float sink;
+
+void setUp() {}
+void tearDown() {}
+
+void test_bench_onset_per_window() {
+  onset_init(FS);
+  abeat_init((float)FS / (float)ONSET_HOP);
+  uint32_t hops = 0;
+  float acc = 0.0f;
+  const uint64_t c0 = cycles();
+  const auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+    float flux[ONSET_BANDS];
+    if (onset_push(track[i % (FS * 2)], flux)) {
+      AudioBeatEvent ev;
+      abeat_push(2.0f * flux[ONSET_LOW] + flux[ONSET_MID] + flux[ONSET_HIGH], &ev);
+      acc += flux[ONSET_LOW];
+      hops++;
+    }
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  const uint64_t c1 = cycles();
+  sink = acc;
+  const double nsHop = std::chrono::duration<double, std::nano>(t1 - t0).count() / hops;
+  const double cycHop = (double)(c1 - c0) / hops;
+  const double winHops = (double)WIN_SAMPLES / ONSET_HOP;
+  printf("onset + beat tracker: %.0f ns/hop, %.0f cycles/hop (host)\n", nsHop, cycHop);
+  printf("per 75 ms window (%.1f hops): %.1f us, %.0f cycles (host) vs device budget %llu cycles (%.3f%%)\n",
+         winHops, nsHop * winHops / 1000.0, cycHop * winHops,
+         (unsigned long long)DEVICE_WIN_BUDGET, 100.0 * cycHop * winHops / (double)DEVICE_WIN_BUDGET);
+  TEST_ASSERT_TRUE(hops >= (BENCH_SAMPLES / ONSET_HOP) - 2);
+}
+
+// One LOW-band flux peak per kick: the hop after each beat beats its neighbours
+void test_kick_onsets_peak_on_beats() {
+  onset_init(FS);
+  float low[FS * 2 / ONSET_HOP + 8] = {};
+  uint32_t hops = 0;
+  for (uint32_t i = 0; i < FS * 2; i++) {
+    float flux[ONSET_BANDS];
+    if (onset_push(track[i], flux)) low[hops++] = flux[ONSET_LOW];
+  }
+  // Beats at 0, 0.5, 1.0, 1.5 s; the first needs a full FFT window of history
+  const uint32_t beatHops = (FS / 2) / ONSET_HOP;   // 93 (93.75) hops apart
+  uint32_t peaks = 0;
+  for (uint32_t b = 1; b < 4; b++) {
+    const uint32_t c = (b * (FS / 2)) / ONSET_HOP;
+    uint32_t best = c - 3;
+    for (uint32_t h = c - 3; h <= c + 3 && h < hops; h++) if (low[h] > low[best]) best = h;
+    float rest = 0.0f;
+    for (uint32_t h = c + 10; h < c + beatHops - 10 && h < hops; h++) rest = fmaxf(rest, low[h]);
+    if (low[best] > 4.0f * rest) peaks++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, peaks);
+}
+
+int main(int, char**) {
+  makeTrack();
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_onset_per_window);
+  RUN_TEST(test_kick_onsets_peak_on_beats);
+  return UNITY_END();
+}
@@ -0,0 +1,149 @@
+// Host benchmark for the phrase-boundary detector (include/phrase_detector.h)
+// on synthetic bar traces.
+//
+// A track is a run of 8-bar phrases. At each phrase start every feature
+// (rms, tr, kVar, kMean) jumps by 0.4..1.2 Np up or down with probability
+// 0.6, and 30% of phrases change again by ~0.3 Np at their bar 5. Each bar
+// adds gaussian noise of NOISE Np. A trace is track A for 16 phrases plus 3
+// bars, then track B mixed in off A's grid.
+// Scored from bar 33 on (history and the grid settled), on the decision
+// mode_party makes at beat 4: nextStart(bar) == bar + 1.
+//   hits / starts   true phrase starts predicted
+//   false           predicted starts that were not
+//   rephase         bars after the mix-in to the first hit on B's grid
+// Reported per noise level over TRACES seeded traces (LCG, the same on every
+// host), plus ns per bar for onBar() + nextStart(). Numbers print with:
+//   pio test -e native -f test_bench_phrase_detector -v
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+#include "phrase_detector.h"
+#include "../test_rng.h"
+
+static constexpr int PHRASE = 8;
+static constexpr int A_PHRASES = 16, B_PHRASES = 24, MIX_OFFSET = 3;
+static constexpr int BARS = A_PHRASES * PHRASE + MIX_OFFSET + B_PHRASES * PHRASE;
+static constexpr int MIX_BAR = A_PHRASES * PHRASE + MIX_OFFSET + 1;   // 1-based, first bar of B
+static constexpr int SCORE_FROM = 33;
+static constexpr int TRACES = 8;
+
+struct Bar { float f[PHRASE_DIMS]; bool start; };
+static Bar trace[BARS];
+
+static TestRng rng(1u);
+
+static int makeTrack(Bar* out, int phrases, float noise) {
+  float lv[PHRASE_DIMS] = { logf(0.1f), logf(0.01f), logf(0.001f), logf(0.05f) };
+  int n = 0;
+  for (int p = 0; p < phrases; p++) {
+    for (int d = 0; d < PHRASE_DIMS; d++)
+      if (rng.uniform() < 0.6f) lv[d] += ((rng.uniform() < 0.5f) ? -1.0f : 1.0f) * (0.4f + 0.8f * rng.uniform());
+    float sub[PHRASE_DIMS] = {};
+    if (rng.uniform() < 0.3f) for (int d = 0; d < PHRASE_DIMS; d++) sub[d] = 0.3f * rng.gauss();
+    for (int b = 0; b < PHRASE; b++, n++) {
+      out[n].start = (b == 0);
+      for (int d = 0; d < PHRASE_DIMS; d++) out[n].f[d] = expf(lv[d] + noise * rng.gauss() + ((b >= 4) ? sub[d] : 0.0f));
+    }
+  }
+  return n;
+}
+
+static void makeTrace(uint32_t traceSeed, float noise) {
+  static Bar b[B_PHRASES * PHRASE];
+  rng = TestRng(traceSeed);
+  makeTrack(trace, A_PHRASES + 1, noise);                 // A, cut 3 bars into its 17th phrase
+  makeTrack(b, B_PHRASES, noise);
+  for (int i = 0; i < B_PHRASES * PHRASE; i++) trace[MIX_BAR - 1 + i] = b[i];
+}
+
+struct Score { int hits, starts, falsePos, rephaseMax, rephaseMiss; };
+
+static void scoreTrace(Score* s) {
+  PhraseDetector pd;
+  pd.reset();
+  int rephase = -1;
+  for (int i = 0; i < BARS; i++) {
+    const uint32_t bar = (uint32_t)i + 1;
+    pd.onBar(bar, trace[i].f[0], trace[i].f[1], trace[i].f[2], trace[i].f[3]);
+    if (i + 1 >= BARS || (int)bar < SCORE_FROM) continue;
+    const bool predicted = pd.nextStart(bar) == bar + 1;
+    const bool truth = trace[i + 1].start;
+    if (truth) { s->starts++; if (predicted) s->hits++; }
+    else if (predicted) s->falsePos++;
+    if (rephase < 0 && (int)bar >= MIX_BAR && predicted && truth) rephase = (int)bar + 1 - MIX_BAR;
+  }
+  if (rephase < 0) s->rephaseMiss++;
+  else if (rephase > s->rephaseMax) s->rephaseMax = rephase;
+}
+
+static Score runNoise(float noise) {
+  Score s = {};
+  for (int t = 0; t < TRACES; t++) {
+    makeTrace(7u + 101u * (uint32_t)t, noise);
+    Score one = {};
+    scoreTrace(&one);
+    printf("PHRASE noise=%.2f trace %d: %d/%d starts, %d false, rephase %d bars\n",
+           noise, t, one.hits, one.starts, one.falsePos, one.rephaseMiss ? -1 : one.rephaseMax);
+    s.hits += one.hits; s.starts += one.starts; s.falsePos += one.falsePos;
+    s.rephaseMiss += one.rephaseMiss;
+    if (one.rephaseMax > s.rephaseMax) s.rephaseMax = one.rephaseMax;
+  }
+  printf("PHRASE noise=%.2f total: %d/%d starts (%.0f%%), %d false, rephase <= %d bars, %d traces never rephased\n",
+         noise, s.hits, s.starts, 100.0f * s.hits / s.starts, s.falsePos, s.rephaseMax, s.rephaseMiss);
+  return s;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_low_noise() {
+  const Score s = runNoise(0.05f);
+  TEST_ASSERT_TRUE(s.hits * 10 >= s.starts * 8);
+  TEST_ASSERT_TRUE(s.falsePos * 10 <= s.starts);
+}
+
+void test_mid_noise() {
+  const Score s = runNoise(0.10f);
+  TEST_ASSERT_TRUE(s.hits * 10 >= s.starts * 8);
+  TEST_ASSERT_TRUE(s.falsePos * 10 <= s.starts);
+}
+
+void test_high_noise() {
+  const Score s = runNoise(0.20f);
+  TEST_ASSERT_TRUE(s.hits * 10 >= s.starts * 6);
+  TEST_ASSERT_TRUE(s.falsePos * 5 <= s.starts);
+}
+
+// Beyond the bar-to-bar noise of a real mix: reported to show where the
+// grid degrades, loosely bounded
+void test_very_high_noise() {
+  const Score s = runNoise(0.30f);
+  TEST_ASSERT_TRUE(s.hits * 2 >= s.starts);
+}
+
+void test_bench_cost_per_bar() {
+  makeTrace(7u, 0.10f);
+  PhraseDetector pd;
+  pd.reset();
+  const int N = 1000000;
+  volatile uint32_t sink = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) {
+    const Bar& b = trace[i % BARS];
+    sink = sink + (uint32_t)pd.onBar((uint32_t)i + 1, b.f[0], b.f[1], b.f[2], b.f[3]) + pd.nextStart((uint32_t)i + 1);
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  printf("PHRASE cost: %.0f ns/bar (onBar + nextStart, host)\n",
+         std::chrono::duration<double, std::nano>(t1 - t0).count() / N);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_low_noise);
+  RUN_TEST(test_mid_noise);
+  RUN_TEST(test_high_noise);
+  RUN_TEST(test_very_high_noise);
+  RUN_TEST(test_bench_cost_per_bar);
+  return UNITY_END();
+}
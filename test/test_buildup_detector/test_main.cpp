@@ -0,0 +1,167 @@
+// BuildupDetector (include/buildup_detector.h) on synthetic monitor-window
+// traces: a break at constant level plus per-window noise, then a riser
+// (transient / hats climb) or a filter sweep (hats up, body down).
+// Windows are 75 ms at 128 BPM: 6 per beat, 24 per bar. Noise is Gaussian
+// on each window's log power, in dB; traces come from a fixed LCG so every
+// host sees the same numbers.
+// Arm latencies print with: pio test -e native -f test_buildup_detector -v
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include "buildup_detector.h"
+#include "../test_rng.h"
+
+static constexpr int   WIN_PER_BEAT = 6;
+static constexpr int   TRACES       = 8;
+static constexpr int   FLAT_BARS    = 4;       // break before the riser starts
+
+static TestRng rng(1u);
+static float fromDb(float db) { return powf(10.0f, 0.1f * db); }
+
+// Levels in dB per bar of the trace, per window
+struct Trace {
+  float trDbBar, hatsDbBar, bodyDbBar;         // slopes once the riser starts
+  float noiseDb;
+};
+
+// One beat of windows at beat index b (riser from beat riseAt on)
+static void feedBeat(BuildupDetector& d, const Trace& t, int b, int riseAt) {
+  for (int w = 0; w < WIN_PER_BEAT; w++) {
+    const float bars = (b >= riseAt) ? (float)(b - riseAt) / 4.0f + (float)w / (4.0f * WIN_PER_BEAT) : 0.0f;
+    const float tr    = fromDb(-30.0f + t.trDbBar * bars + t.noiseDb * rng.gauss());
+    const float hatsE = fromDb(-40.0f + t.hatsDbBar * bars + t.noiseDb * rng.gauss());
+    const float bodyE = fromDb(-34.0f + t.bodyDbBar * bars + t.noiseDb * rng.gauss());
+    d.addWindow(sqrtf(tr), hatsE, bodyE);      // tr is a mean |hp|: an amplitude
+  }
+}
+
+// Beats from the riser start until armed (-1: never within maxBars)
+static int armLatency(const Trace& t, uint32_t s, int maxBars) {
+  rng = TestRng(s);
+  BuildupDetector d;
+  d.reset();
+  const int riseAt = FLAT_BARS * 4;
+  for (int b = 0; b < riseAt + maxBars * 4; b++) {
+    feedBeat(d, t, b, riseAt);
+    d.onBeat();
+    if (d.armed()) return b - riseAt;
+  }
+  return -1;
+}
+
+// Worst arm latency over TRACES seeds, in beats; every trace must stay
+// unarmed through the flat break
+static int worstLatency(const char* name, const Trace& t) {
+  int worst = 0, best = 1000;
+  for (int k = 0; k < TRACES; k++) {
+    const int lat = armLatency(t, 7u + 101u * (uint32_t)k, 8);
+    TEST_ASSERT_TRUE_MESSAGE(lat >= 0, name);
+    if (lat > worst) worst = lat;
+    if (lat < best) best = lat;
+  }
+  printf("%-22s noise=%.1f dB  arms after %d..%d beats of riser\n", name, t.noiseDb, best, worst);
+  return worst;
+}
+
+void setUp() { rng = TestRng(1u); }
+void tearDown() {}
+
+// A 2 dB/bar transient riser arms within 4 bars on every trace
+void test_riser_arms() {
+  const Trace t = { 2.0f, 0.0f, 0.0f, 1.5f };
+  TEST_ASSERT_TRUE(worstLatency("riser tr 2 dB/bar", t) <= 16);
+}
+
+// Hats riser (snare roll into open hats)
+void test_hats_riser_arms() {
+  const Trace t = { 0.0f, 3.0f, 0.0f, 1.5f };
+  TEST_ASSERT_TRUE(worstLatency("riser hats 3 dB/bar", t) <= 16);
+}
+
+// High-pass sweep: hats up, body down; only the tilt climbs fast
+void test_tilt_sweep_arms() {
+  const Trace t = { 0.0f, 1.0f, -1.0f, 1.5f };
+  TEST_ASSERT_TRUE(worstLatency("tilt sweep 2 dB/bar", t) <= 16);
+}
+
+// A flat break with 3 dB of window noise never arms in 64 bars
+void test_flat_break_never_arms() {
+  const Trace t = { 0.0f, 0.0f, 0.0f, 3.0f };
+  for (int k = 0; k < TRACES; k++) {
+    rng = TestRng(7u + 101u * (uint32_t)k);
+    BuildupDetector d;
+    d.reset();
+    int maxStreak = 0, streak = 0;
+    for (int b = 0; b < 64 * 4; b++) {
+      feedBeat(d, t, b, 1 << 30);
+      d.onBeat();
+      TEST_ASSERT_FALSE(d.armed());
+      streak = (d.score() >= 1.0f) ? streak + 1 : 0;
+      if (streak > maxStreak) maxStreak = streak;
+    }
+    TEST_ASSERT_TRUE(maxStreak < BUILDUP_CONFIRM_BEATS);
+  }
+}
+
+// The riser stops and the break holds its level: disarms within the fit span
+void test_disarms_after_riser() {
+  const Trace t = { 2.0f, 0.0f, 0.0f, 1.5f };
+  rng = TestRng(7u);
+  BuildupDetector d;
+  d.reset();
+  int b = 0;
+  for (; b < 16 + 16; b++) { feedBeat(d, t, b, 16); d.onBeat(); }
+  TEST_ASSERT_TRUE(d.armed());
+  // Hold the level reached after 4 bars of riser
+  const Trace hold = { 0.0f, 0.0f, 0.0f, 1.5f };
+  int beats = 0;
+  for (; beats < 2 * BUILDUP_BEATS && d.armed(); beats++) {
+    for (int w = 0; w < WIN_PER_BEAT; w++) {
+      const float tr = fromDb(-30.0f + 2.0f * 4.0f + hold.noiseDb * rng.gauss());
+      d.addWindow(sqrtf(tr), fromDb(-40.0f + hold.noiseDb * rng.gauss()), fromDb(-34.0f + hold.noiseDb * rng.gauss()));
+    }
+    d.onBeat();
+  }
+  printf("disarm after riser     %d beats of flat level\n", beats);
+  TEST_ASSERT_FALSE(d.armed());
+  TEST_ASSERT_TRUE(beats <= BUILDUP_BEATS);
+}
+
+// Beats without windows (party mode pauses the detector during a pre-armed
+// DROP) leave the fit untouched: the riser stays armed and keeps climbing
+void test_pause_keeps_history() {
+  const Trace t = { 2.0f, 0.0f, 0.0f, 1.5f };
+  rng = TestRng(7u);
+  BuildupDetector d;
+  d.reset();
+  int b = 0;
+  for (; b < 16 + 12; b++) { feedBeat(d, t, b, 16); d.onBeat(); }
+  TEST_ASSERT_TRUE(d.armed());
+  const uint8_t fill = d.beats();
+  const float slope = d.slopeDbPerBar(BUILDUP_TR);
+  for (int k = 0; k < 4; k++) TEST_ASSERT_FALSE(d.onBeat());
+  TEST_ASSERT_EQUAL_UINT8(fill, d.beats());
+  TEST_ASSERT_EQUAL_FLOAT(slope, d.slopeDbPerBar(BUILDUP_TR));
+  feedBeat(d, t, b + 4, 16);
+  d.onBeat();
+  TEST_ASSERT_TRUE(d.armed());
+
+  // A reset at that point would lose two bars before the next verdict
+  d.reset();
+  feedBeat(d, t, b + 5, 16);
+  d.onBeat();
+  TEST_ASSERT_FALSE(d.armed());
+  TEST_ASSERT_TRUE(d.beats() < BUILDUP_MIN_BEATS);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_riser_arms);
+  RUN_TEST(test_hats_riser_arms);
+  RUN_TEST(test_tilt_sweep_arms);
+  RUN_TEST(test_flat_break_never_arms);
+  RUN_TEST(test_disarms_after_riser);
+  RUN_TEST(test_pause_keeps_history);
+  return UNITY_END();
+}
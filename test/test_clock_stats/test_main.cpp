@@ -0,0 +1,116 @@
+// ClockStats (include/clock_stats.h): reference seeding, drop accounting and
+// re-seeding on synthetic MIDI clock tick traces.
+#include <unity.h>
+#include <stdint.h>
+#include "clock_stats.h"
+#include "../test_rng.h"
+
+static uint32_t tickFor(float bpm) { return (uint32_t)(60000000.0f / (bpm * 24.0f) + 0.5f); }
+
+static TestRng rng(1u);
+
+// n ticks of the grid t0 + k * dt (+ jitter); returns the next grid time
+static uint32_t feed(ClockStats& c, uint32_t t0, uint32_t dt, int n, int32_t jitter) {
+  for (int k = 0; k < n; k++) c.add(t0 + (uint32_t)k * dt + (uint32_t)rng.jitterUs(jitter));
+  return t0 + (uint32_t)n * dt;
+}
+
+void setUp() { rng = TestRng(1u); }
+void tearDown() {}
+
+void test_steady_clock() {
+  ClockStats c;
+  c.reset();
+  const uint32_t dt = tickFor(128.0f);
+  feed(c, 1000, dt, 24 * 64 + 1, 200);
+  TEST_ASSERT_EQUAL_UINT32(24 * 64, c.intervals());
+  TEST_ASSERT_EQUAL_UINT32(0, c.drops());
+  TEST_ASSERT_FLOAT_WITHIN(20.0f, (float)dt, c.referenceUs());
+  TEST_ASSERT_TRUE(c.jitterQuantileUs(0.99f) <= 500);
+}
+
+// The old reference took the first interval as is: a late second tick
+// doubled it and hid every real drop after it.
+void test_late_first_tick_does_not_seed() {
+  ClockStats c;
+  c.reset();
+  const uint32_t dt = tickFor(120.0f);
+  c.add(0);
+  c.add(2 * dt);                                 // one tick lost at the start
+  uint32_t t = feed(c, 3 * dt, dt, 100, 100);
+  TEST_ASSERT_FLOAT_WITHIN(50.0f, (float)dt, c.referenceUs());
+  TEST_ASSERT_EQUAL_UINT32(1, c.drops());
+  TEST_ASSERT_EQUAL_UINT32(1, c.missedTicks());
+
+  t += dt;                                       // and one more later
+  feed(c, t, dt, 10, 100);
+  TEST_ASSERT_EQUAL_UINT32(2, c.drops());
+  TEST_ASSERT_EQUAL_UINT32(2, c.missedTicks());
+  TEST_ASSERT_EQUAL_UINT32(0, c.reseeds());
+}
+
+void test_isolated_drops_counted() {
+  ClockStats c;
+  c.reset();
+  const uint32_t dt = tickFor(140.0f);
+  uint32_t t = feed(c, 0, dt, 50, 100);
+  for (int i = 0; i < 3; i++) {
+    t += 2 * dt;                                 // two ticks lost
+    t = feed(c, t, dt, 20, 100);
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, c.drops());
+  TEST_ASSERT_EQUAL_UINT32(6, c.missedTicks());
+  TEST_ASSERT_EQUAL_UINT32(0, c.reseeds());
+}
+
+// Tempo halves (mixer change, or a drummer's half-time clock): the EMA never
+// sees those intervals, so without a re-seed every tick would be a drop.
+void test_slower_clock_reseeds() {
+  ClockStats c;
+  c.reset();
+  const uint32_t fast = tickFor(150.0f), slow = tickFor(70.0f);
+  uint32_t t = feed(c, 0, fast, 100, 100);
+  const uint32_t before = c.intervals();
+  feed(c, t, slow, 200, 100);
+  TEST_ASSERT_EQUAL_UINT32(1, c.reseeds());
+  TEST_ASSERT_EQUAL_UINT32(0, c.drops());
+  TEST_ASSERT_EQUAL_UINT32(0, c.missedTicks());
+  TEST_ASSERT_EQUAL_UINT32(before + 200, c.intervals());   // the re-seeded run counts too
+  TEST_ASSERT_FLOAT_WITHIN(50.0f, (float)slow, c.referenceUs());
+}
+
+// Faster clock: the EMA follows without dropping anything
+void test_faster_clock_follows() {
+  ClockStats c;
+  c.reset();
+  const uint32_t slow = tickFor(100.0f), fast = tickFor(130.0f);
+  uint32_t t = feed(c, 0, slow, 100, 100);
+  feed(c, t, fast, 300, 100);
+  TEST_ASSERT_EQUAL_UINT32(0, c.drops());
+  TEST_ASSERT_EQUAL_UINT32(0, c.reseeds());
+  TEST_ASSERT_FLOAT_WITHIN(50.0f, (float)fast, c.referenceUs());
+}
+
+void test_reset_clears_seed() {
+  ClockStats c;
+  c.reset();
+  feed(c, 0, tickFor(120.0f), 3, 0);             // two intervals held, not seeded
+  TEST_ASSERT_EQUAL_UINT32(0, c.intervals());
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, c.referenceUs());
+  c.reset();
+  const uint32_t dt = tickFor(90.0f);
+  feed(c, 0, dt, CLOCK_STATS_SEED + 1, 0);
+  TEST_ASSERT_EQUAL_UINT32(CLOCK_STATS_SEED, c.intervals());
+  TEST_ASSERT_EQUAL_FLOAT((float)dt, c.referenceUs());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_clock);
+  RUN_TEST(test_late_first_tick_does_not_seed);
+  RUN_TEST(test_isolated_drops_counted);
+  RUN_TEST(test_slower_clock_reseeds);
+  RUN_TEST(test_faster_clock_follows);
+  RUN_TEST(test_reset_clears_seed);
+  return UNITY_END();
+}
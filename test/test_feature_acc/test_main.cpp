@@ -0,0 +1,153 @@
+// FeatureAcc (fixed point) against the double reference it replaced.
+//
+// The input path is the audio task's: Q24 mono sample, transient high-pass,
+// CIC / 12 + one-pole kick envelope, all in Q28 at the accumulator. The
+// reference gets the same float values (what the old code summed in double,
+// with a Welford update for the envelope). Every getter must stay within
+// FA_SHADOW_REL_TOL, or FA_SHADOW_ABS_TOL when the reference is near zero.
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "feature_acc.h"
+#include "dsp_filters.h"
+#include "../test_rng.h"
+
+static constexpr uint32_t FS = 48000;
+static constexpr uint8_t  DECIM = 12;
+
+struct RefAcc {
+  uint32_t n = 0, nE = 0;
+  double sumSq = 0.0, trSum = 0.0, mean = 0.0, m2 = 0.0;
+  void add(float x, float tr) { sumSq += (double)x * (double)x; trSum += tr; n++; }
+  void addEnv(float e) {
+    nE++;
+    const double d = e - mean;
+    mean += d / (double)nE;
+    m2 += d * (e - mean);
+  }
+  double rms() const { return sqrt(sumSq / n); }
+  double tr() const { return trSum / n; }
+  double kVar() const { return (nE < 2) ? 0.0 : m2 / (double)(nE - 1); }
+};
+
+// Kick (55 Hz decaying sine, 2 per second) plus white noise, peak at `dbfs`
+struct Signal {
+  float level, kickMix;
+  uint32_t i = 0;
+  TestRng rng;
+  Signal(float dbfs, float kick, uint32_t s) : level(powf(10.0f, dbfs / 20.0f)), kickMix(kick), rng(s) {}
+  int32_t nextQ24() {
+    const float noise = rng.noise();
+    const float t = (float)(i % (FS / 2)) / (float)FS;
+    const float kick = sinf(2.0f * 3.14159265f * 55.0f * t) * expf(-t * 12.0f);
+    i++;
+    const float x = level * (kickMix * kick + (1.0f - kickMix) * noise);
+    return (int32_t)lrintf(x * 16777216.0f);
+  }
+};
+
+struct Path {
+  OnePoleHP<FS, DSP_TR_HP_HZ> hp;
+  CicDecimator3<DECIM> cic;
+  OnePoleLP<FS / DECIM, DSP_KICK_ENV_HZ> lp;
+  void push(int32_t xQ24, FeatureAcc& a, RefAcc& r) {
+    const float x = (float)xQ24 * (1.0f / 16777216.0f);
+    const float tr = fabsf(hp.process(x));
+    const int32_t trQ28 = fa_toQ28(tr);
+    a.add(xQ24, trQ28);
+    r.add(x, (float)trQ28 / FA_Q28);
+    float envIn;
+    const uint32_t axQ21 = (uint32_t)((xQ24 < 0) ? -xQ24 : xQ24) >> 3;
+    if (cic.push(axQ21, &envIn)) {
+      const float env = lp.process(envIn);
+      a.addEnv(fa_toQ28(env));
+      r.addEnv(env);
+    }
+  }
+};
+
+static float worstRel = 0.0f;    // rms, tr, kMean
+static float worstKVarAbs = 0.0f;
+
+// rms / tr / kMean: relative bound. kVar: relative, or absolute near zero
+// (the envelope is quantised to Q28 before it is summed).
+static void expectClose(float got, double ref, bool absOk, const char* what) {
+  const double err = fabs((double)got - ref);
+  bool ok = err <= FA_SHADOW_REL_TOL * fabs(ref);
+  if (absOk) {
+    if (err > worstKVarAbs) worstKVarAbs = (float)err;
+    ok = ok || err <= FA_SHADOW_ABS_TOL;
+  } else if (ref > 0.0 && err / ref > worstRel) {
+    worstRel = (float)(err / ref);
+  }
+  if (!ok) printf("%s: got %.9g ref %.9g rel %.2e\n", what, got, ref, err / fabs(ref));
+  TEST_ASSERT_TRUE_MESSAGE(ok, what);
+}
+
+static void runSpan(float dbfs, float kick, uint32_t samples) {
+  FeatureAcc a;
+  RefAcc r;
+  Path p;
+  Signal s(dbfs, kick, 12345u + samples);
+  for (uint32_t i = 0; i < samples; i++) p.push(s.nextQ24(), a, r);
+  expectClose(a.rms(), r.rms(), false, "rms");
+  expectClose(a.tr(), r.tr(), false, "tr");
+  expectClose(a.kMean(), r.mean, false, "kMean");
+  expectClose(a.kVar(), r.kVar(), true, "kVar");
+}
+
+void setUp() {}
+void tearDown() {}
+
+// -50 .. -8 dBFS, one 75 ms window up to a 3 s bar, kick-heavy and noise-heavy
+void test_fixed_point_matches_double_reference() {
+  const float levels[] = { -50.0f, -30.0f, -18.0f, -8.0f };
+  const float kicks[]  = { 0.9f, 0.3f };
+  const uint32_t spans[] = { FS * 75 / 1000, FS / 2, FS * 3 };
+  for (float db : levels)
+    for (float k : kicks)
+      for (uint32_t n : spans) runSpan(db, k, n);
+  printf("worst relative error rms/tr/kMean: %.2e, worst kVar absolute error: %.2e\n",
+         worstRel, worstKVarAbs);
+}
+
+// Merging windows into a bar is lossless: same bits as feeding the bar directly
+void test_merge_is_exact() {
+  FeatureAcc bar, win, direct, mark, partial;
+  RefAcc ref;
+  Path p1, p2;
+  Signal s1(-20.0f, 0.6f, 7u), s2(-20.0f, 0.6f, 7u);
+  for (uint32_t w = 0; w < 10; w++) {
+    for (uint32_t i = 0; i < 3600; i++) {
+      p1.push(s1.nextQ24(), win, ref);
+      p2.push(s2.nextQ24(), direct, ref);
+      if (w == 9 && i == 1800) partial.mergeSince(win, mark);   // bar boundary mid-window
+    }
+    if (w < 9) { bar.merge(win); win.reset(); }
+  }
+  partial.mergeSince(win, mark);
+  bar.merge(partial);
+  TEST_ASSERT_EQUAL_UINT32(direct.n, bar.n);
+  TEST_ASSERT_EQUAL_UINT32(direct.nE, bar.nE);
+  TEST_ASSERT_TRUE(direct.sumSq == bar.sumSq && direct.sumTr == bar.sumTr);
+  TEST_ASSERT_TRUE(direct.sumE == bar.sumE && direct.sumE2 == bar.sumE2);
+}
+
+// Silence and DC: kVar must come out 0, not a small negative / garbage value
+void test_kvar_flat_envelope_is_zero() {
+  FeatureAcc a;
+  for (uint32_t i = 0; i < 4000; i++) { a.add(0, 0); a.addEnv(fa_toQ28(0.25f)); }
+  TEST_ASSERT_TRUE(a.kVar() == 0.0f);
+  TEST_ASSERT_FLOAT_WITHIN(1e-7f, 0.25f, a.kMean());
+  a.reset();
+  TEST_ASSERT_TRUE(a.rms() == 0.0f && a.kVar() == 0.0f);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_point_matches_double_reference);
+  RUN_TEST(test_merge_is_exact);
+  RUN_TEST(test_kvar_flat_envelope_is_zero);
+  return UNITY_END();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// Deterministic noise for the host tests: a 32-bit LCG (Numerical Recipes
+// constants), so every host sees the same traces. Draws use the top 24 bits.
+// Included by the suites as "../test_rng.h".
+struct TestRng {
+  uint32_t seed;
+  explicit TestRng(uint32_t s = 1u) : seed(s) {}
+
+  uint32_t next() {                             // [0, 2^24)
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  }
+  float uniform() { return ((float)next() + 0.5f) * (1.0f / 16777216.0f); }   // (0, 1)
+  float noise() { return (float)next() * (1.0f / 8388608.0f) - 1.0f; }        // [-1, 1)
+  int32_t jitterUs(int32_t amp) {               // uniform in [-amp, amp]
+    return (int32_t)((int64_t)next() * (2 * amp + 1) / 16777216) - amp;
+  }
+  float gauss() {                               // Box-Muller, unit variance
+    const float u1 = uniform(), u2 = uniform();
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+  }
+};
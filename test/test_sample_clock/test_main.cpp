@@ -0,0 +1,126 @@
+// SampleClock (include/sample_clock.h) on synthetic DMA block arrivals:
+// 48 kHz, 256-frame blocks, each seen by the task some wake latency after
+// its last frame was captured.
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sample_clock.h"
+#include "../test_rng.h"
+
+static constexpr uint32_t FS    = 48000;
+static constexpr uint32_t BLOCK = 256;
+static constexpr double   WAKE_US = 300.0;      // latency floor of the task wake
+
+static TestRng rng(1u);
+
+// The I2S side of a trace: frame n is captured at t0 + n / fs, with the I2S
+// master off the CPU crystal by ppm
+struct Source {
+  double t0, ppm;
+  double frameUs(uint64_t n) const { return t0 + (double)n * 1e6 * (1.0 + 1e-6 * ppm) / (double)FS; }
+};
+
+// micros() reading (wraps like the real one)
+static uint32_t micros32(double us) { return (uint32_t)(uint64_t)llround(us); }
+
+// usAt() against the truth (capture time plus the wake floor), in us
+static int32_t errUs(const SampleClock& c, const Source& s, uint64_t n) {
+  return (int32_t)(c.usAt(n) - micros32(s.frameUs(n) + WAKE_US));
+}
+
+void setUp() { rng = TestRng(1u); }
+void tearDown() {}
+
+// Every frame within a few seconds of the anchor maps to a time and back,
+// on both sides of the anchor
+void test_round_trip() {
+  const Source s = { 5.0e6, 0.0 };
+  SampleClock c(FS);
+  c.reset();
+  uint64_t end = 0;
+  for (int b = 0; b < 1000; b++) {             // ~5.3 s: the anchor has moved
+    end += BLOCK;
+    c.observe(end, micros32(s.frameUs(end) + WAKE_US));
+  }
+  for (uint64_t n = end - 4 * FS; n < end + FS; n++)
+    TEST_ASSERT_TRUE(c.sampleAt(c.usAt(n)) == n);
+}
+
+// micros() wraps mid-trace: times and frames stay continuous across it
+void test_micros_wrap() {
+  const Source s = { 4294967296.0 - 2.0e6, 0.0 };   // 2 s before the wrap
+  SampleClock c(FS);
+  c.reset();
+  uint64_t end = 0;
+  for (int b = 0; b < 2000; b++) {             // ~10.7 s
+    end += BLOCK;
+    const uint32_t at = micros32(s.frameUs(end) + WAKE_US);
+    c.observe(end, at);
+    TEST_ASSERT_INT32_WITHIN(1, 0, errUs(c, s, end));
+    TEST_ASSERT_TRUE(c.sampleAt(at) == end);
+  }
+  // Frames captured before the wrap still map back from the far side
+  const uint64_t before = FS;                   // 1 s into the trace
+  TEST_ASSERT_INT32_WITHIN(1, 0, errUs(c, s, before));
+  TEST_ASSERT_TRUE(c.sampleAt(c.usAt(before)) == before);
+}
+
+// Three hours of blocks: the anchor advances in whole seconds, so the
+// mapping near the newest frame stays exact however long the session runs
+void test_anchor_advance() {
+  const Source s = { 1000.0, 0.0 };
+  SampleClock c(FS);
+  c.reset();
+  uint64_t end = 0;
+  int32_t worst = 0;
+  const uint32_t blocks = 3u * 3600u * FS / BLOCK;
+  for (uint32_t b = 0; b < blocks; b++) {
+    end += BLOCK;
+    c.observe(end, micros32(s.frameUs(end) + WAKE_US));
+    if (end < FS) continue;
+    const int32_t e = errUs(c, s, end - FS);    // a frame one second back
+    if (abs(e) > worst) worst = abs(e);
+  }
+  printf("anchor advance: %u blocks, worst error %ld us\n", (unsigned)blocks, (long)worst);
+  TEST_ASSERT_TRUE(worst <= 1);
+  TEST_ASSERT_EQUAL_INT32(0, c.lagUs());
+  TEST_ASSERT_TRUE(c.sampleAt(c.usAt(end - FS / 2)) == end - FS / 2);
+}
+
+// Wake latency jitters above its floor, and the I2S master runs 100 ppm
+// off in either direction: the estimate rides the floor to within 5 frames.
+// A fast master is the harder case: between two low arrivals the floor falls
+// ~0.5 us per block while the estimate leaks up 1 us per block.
+void test_jittered_arrivals() {
+  const double ppms[2] = { 100.0, -100.0 };
+  for (int k = 0; k < 2; k++) {
+    const Source s = { 2.0e6, ppms[k] };
+    SampleClock c(FS);
+    c.reset();
+    uint64_t end = 0;
+    int32_t worst = 0;
+    for (int b = 0; b < 20000; b++) {          // ~107 s
+      end += BLOCK;
+      const float u = rng.uniform();
+      const double late = 3000.0 * (double)(u * u * u);   // mostly small, tail to 3 ms
+      c.observe(end, micros32(s.frameUs(end) + WAKE_US + late));
+      if (b < 200) continue;                   // first arrival may sit above the floor
+      const int32_t e = errUs(c, s, end);
+      TEST_ASSERT_TRUE(e >= -1);               // never earlier than the floor
+      if (e > worst) worst = e;
+    }
+    printf("jittered arrivals %+.0f ppm: worst %ld us above the floor\n", ppms[k], (long)worst);
+    TEST_ASSERT_TRUE(worst <= (int32_t)(5 * 1000000 / FS));
+  }
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_micros_wrap);
+  RUN_TEST(test_anchor_advance);
+  RUN_TEST(test_jittered_arrivals);
+  return UNITY_END();
+}
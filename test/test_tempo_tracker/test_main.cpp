@@ -0,0 +1,176 @@
+// TempoTracker (include/tempo_tracker.h): guards, confidence and the
+// next-beat prediction on synthetic MIDI beat traces (jittered, spiked,
+// missing beats, tempo change, micros() wrap).
+#include <unity.h>
+#include <stdint.h>
+#include <math.h>
+#include "tempo_tracker.h"
+#include "../test_rng.h"
+
+// Same values as TEMPO_CFG in mode_party.cpp
+static const TempoTracker::Config CFG = { 0.5f, 0.15f, 80.0f, 160.0f, 20.0f, 0.10f, 8 };
+
+static TestRng rng(1u);
+static uint32_t periodFor(float bpm) { return (uint32_t)(60000000.0f / bpm + 0.5f); }
+
+// Feed n beats of the grid t0 + k * period (+ jitter); returns the next grid time
+static uint32_t feed(TempoTracker& t, uint32_t t0, uint32_t period, int n, int32_t jitter) {
+  for (int k = 0; k < n; k++) t.onBeat(t0 + (uint32_t)k * period + (uint32_t)rng.jitterUs(jitter));
+  return t0 + (uint32_t)n * period;
+}
+
+void setUp() { rng = TestRng(1u); }
+void tearDown() {}
+
+void test_first_beat_anchors_only() {
+  TempoTracker t(CFG, 500000);
+  TEST_ASSERT_FALSE(t.hasPhase());
+  TEST_ASSERT_TRUE(t.confidence() == 0.0f);
+  const TempoBeat b = t.onBeat(1000);
+  TEST_ASSERT_EQUAL_INT(TEMPO_FIRST, b.verdict);
+  TEST_ASSERT_EQUAL_UINT32(500000, t.periodUs());
+  TEST_ASSERT_EQUAL_UINT32(501000, t.predictedNextBeatUs());
+}
+
+// 125 BPM with +-1 ms jitter (MIDI byte timing): period, prediction, confidence
+void test_jittered_clock_locks() {
+  const uint32_t P = periodFor(125.0f);
+  TempoTracker t(CFG, 500000);
+  const uint32_t next = feed(t, 10000, P, 64, 1000);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f * P, (float)P, (float)t.periodUs());
+  TEST_ASSERT_FLOAT_WITHIN(1500.0f, 0.0f, (float)(int32_t)(t.predictedNextBeatUs() - next));
+  TEST_ASSERT_TRUE(t.confidence() > 0.8f);
+}
+
+// The phase filter averages jitter: prediction error below the raw jitter
+void test_prediction_beats_raw_jitter() {
+  const uint32_t P = periodFor(128.0f);
+  TempoTracker t(CFG, P);
+  uint32_t t0 = 50000;
+  t0 = feed(t, t0, P, 16, 2000);
+  double predErr = 0.0, rawErr = 0.0;
+  for (int k = 0; k < 256; k++) {
+    const uint32_t truth = t0 + (uint32_t)k * P;
+    predErr += fabs((double)(int32_t)(t.predictedNextBeatUs() - truth));
+    const int32_t j = rng.jitterUs(2000);
+    rawErr += fabs((double)j);
+    t.onBeat(truth + (uint32_t)j);
+  }
+  TEST_ASSERT_TRUE(predErr < 0.8 * rawErr);
+}
+
+// 120 -> 128 BPM: the period follows within 32 beats, every beat accepted
+void test_tempo_change_is_followed() {
+  const uint32_t P1 = periodFor(120.0f), P2 = periodFor(128.0f);
+  TempoTracker t(CFG, P1);
+  uint32_t tNext = feed(t, 0, P1, 16, 0);
+  for (int k = 0; k < 32; k++) {
+    const TempoBeat b = t.onBeat(tNext + (uint32_t)k * P2);
+    TEST_ASSERT_EQUAL_INT(TEMPO_ACCEPT, b.verdict);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f * P2, (float)P2, (float)t.periodUs());
+}
+
+// D1: a missing beat at 90 BPM proposes < 80 BPM; period kept, phase re-anchored
+void test_missing_beat_rejected_by_range() {
+  const uint32_t P = periodFor(90.0f);
+  TempoTracker t(CFG, P);
+  const uint32_t tNext = feed(t, 0, P, 16, 0);
+  const uint32_t before = t.periodUs();
+  const TempoBeat b = t.onBeat(tNext + P);          // beat at tNext missing
+  TEST_ASSERT_EQUAL_INT(TEMPO_REJECT_RANGE, b.verdict);
+  TEST_ASSERT_EQUAL_UINT32(2 * P, b.rawIntervalUs);
+  TEST_ASSERT_EQUAL_UINT32(before, t.periodUs());
+  TEST_ASSERT_EQUAL_UINT32(tNext + P, t.lastBeatUs());
+  TEST_ASSERT_TRUE(t.confidence() == 0.0f);         // lock restarts
+  const TempoBeat n = t.onBeat(tNext + 2 * P);
+  TEST_ASSERT_EQUAL_INT(TEMPO_ACCEPT, n.verdict);
+}
+
+// D2: a missing beat at 155 BPM proposes a 20+ BPM jump
+void test_missing_beat_rejected_by_spike() {
+  const uint32_t P = periodFor(155.0f);
+  TempoTracker t(CFG, P);
+  const uint32_t tNext = feed(t, 0, P, 16, 0);
+  const uint32_t before = t.periodUs();
+  const TempoBeat b = t.onBeat(tNext + P);
+  TEST_ASSERT_EQUAL_INT(TEMPO_REJECT_SPIKE, b.verdict);
+  TEST_ASSERT_EQUAL_UINT32(before, t.periodUs());
+  TEST_ASSERT_EQUAL_INT(TEMPO_ACCEPT, t.onBeat(tNext + 2 * P).verdict);
+}
+
+// A spiked (early, doubled) beat moves the period by at most BETA * e and the
+// estimate is back within 1% a few beats later
+void test_spiked_beat_recovers() {
+  const uint32_t P = periodFor(125.0f);
+  TempoTracker t(CFG, P);
+  const uint32_t tNext = feed(t, 0, P, 16, 0);
+  t.onBeat(tNext - P / 2);                          // stray beat half-way
+  const uint32_t pert = t.periodUs();
+  TEST_ASSERT_TRUE(pert < P && pert > P - P / 8);
+  for (int k = 0; k < 24; k++) t.onBeat(tNext + (uint32_t)k * P);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f * P, (float)P, (float)t.periodUs());
+}
+
+static bool vetoAll(uint32_t, uint32_t) { return false; }
+
+// Hook veto keeps the period and the lock count (CLOCK_HOLD)
+void test_hook_veto_keeps_lock() {
+  const uint32_t P = periodFor(125.0f);
+  TempoTracker t(CFG, P);
+  const uint32_t tNext = feed(t, 0, P, 16, 0);
+  const float conf = t.confidence();
+  t.setAcceptHook(vetoAll);
+  const TempoBeat b = t.onBeat(tNext + 3000);
+  TEST_ASSERT_EQUAL_INT(TEMPO_REJECT_HOOK, b.verdict);
+  TEST_ASSERT_EQUAL_UINT32(P, t.periodUs());
+  TEST_ASSERT_TRUE(t.confidence() > 0.5f * conf);
+}
+
+// Confidence: lock ramp over lockBeats, falls as jitter grows, 0 after resync
+void test_confidence_tracks_jitter() {
+  const uint32_t P = periodFor(125.0f);
+  TempoTracker t(CFG, P);
+  feed(t, 0, P, 5, 0);                              // 4 accepted of 8 lock beats
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.5f, t.confidence());
+  feed(t, 5 * P, P, 8, 0);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, t.confidence());
+
+  const int32_t jitters[] = { 1000, 10000, 25000, 45000 };
+  float prev = 1.0f;
+  for (int32_t j : jitters) {
+    TempoTracker n(CFG, P);
+    feed(n, 0, P, 64, j);
+    TEST_ASSERT_TRUE(n.confidence() < prev);
+    prev = n.confidence();
+  }
+  TEST_ASSERT_TRUE(prev < 0.5f);                    // +-45 ms: not trusted
+  t.resync();
+  TEST_ASSERT_TRUE(t.confidence() == 0.0f);
+}
+
+// micros() wraps every 71.6 min: intervals and prediction stay continuous
+void test_micros_wrap() {
+  const uint32_t P = periodFor(125.0f);
+  TempoTracker t(CFG, P);
+  const uint32_t t0 = 0xFFFFFFFFu - 8 * P;
+  const uint32_t tNext = feed(t, t0, P, 16, 0);
+  TEST_ASSERT_TRUE(tNext < t0);                      // wrapped
+  TEST_ASSERT_EQUAL_UINT32(tNext, t.predictedNextBeatUs());
+  TEST_ASSERT_EQUAL_UINT32(P, t.periodUs());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_beat_anchors_only);
+  RUN_TEST(test_jittered_clock_locks);
+  RUN_TEST(test_prediction_beats_raw_jitter);
+  RUN_TEST(test_tempo_change_is_followed);
+  RUN_TEST(test_missing_beat_rejected_by_range);
+  RUN_TEST(test_missing_beat_rejected_by_spike);
+  RUN_TEST(test_spiked_beat_recovers);
+  RUN_TEST(test_hook_veto_keeps_lock);
+  RUN_TEST(test_confidence_tracks_jitter);
+  RUN_TEST(test_micros_wrap);
+  return UNITY_END();
+}